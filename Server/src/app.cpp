@@ -40,6 +40,12 @@ App::~App()
     }
 }
 
+void App::setIoBackend(const rtnt::core::Peer::IoBackend backend) { _server.setIoBackend(backend); }
+
+void App::setUdpOffload(const bool enabled) { _server.setUdpOffload(enabled); }
+
+void App::setShardCount(const size_t count) { _server.setShardCount(count); }
+
 void App::start()
 {
     _server.start();
@@ -53,9 +59,8 @@ void App::start()
     packet::server::SendInterface sendInterface;
     while (true) {
         while (_outGoing.pop(sendInterface)) {
-            for (const auto& session : sendInterface.first) {
-                std::visit([&](auto&& p) { _server.sendTo(session, p); }, sendInterface.second);
-            }
+            std::visit([&](auto&& p) { _server.broadcast(sendInterface.first, p); },
+                       sendInterface.second);
         }
         _lobbyManager.update();
         _server.update();
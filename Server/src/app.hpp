@@ -27,6 +27,26 @@ public:
                  const std::string& config);
     ~App();
 
+    /**
+     * @brief Selects how the server talks to its socket.
+     * @param backend The I/O backend, see @code rtnt::core::Peer::IoBackend@endcode.
+     * @note Must be called before @code start@endcode.
+     */
+    void setIoBackend(rtnt::core::Peer::IoBackend backend);
+
+    /**
+     * @brief Enables UDP segmentation offload (GSO/GRO) on the server socket.
+     * @note Requires the batched I/O backend. Must be called before @code start@endcode.
+     */
+    void setUdpOffload(bool enabled);
+
+    /**
+     * @brief Spreads the server socket over several ones, each served by its own thread.
+     * @param count The number of I/O shards, see @code rtnt::core::Server::setShardCount@endcode.
+     * @note Linux only. Must be called before @code start@endcode.
+     */
+    void setShardCount(size_t count);
+
     /**
      * @brief Starts the server and updates it periodically.
      */
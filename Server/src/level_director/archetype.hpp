@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -13,6 +14,7 @@ struct Enemy
 {
     entity::Type type;        ///< The type of enemy (must be in the entity::Type enum).
     std::string patternName;  ///< The name of the movement pattern.
+    uint8_t patternId;        ///< The id of the movement pattern (see level::MovePatterns).
     int count;                ///< The number of entities in this group.
 };
 
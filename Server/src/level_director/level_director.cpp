@@ -9,7 +9,8 @@
 #include "enums/player_state.hpp"
 #include "lobby/lobby.hpp"
 
-std::vector<level::Enemy> parseEnemies(const nlohmann::json& data)
+std::vector<level::Enemy> parseEnemies(const nlohmann::json& data,
+                                       const level::MovePatterns& patterns)
 {
     if (!data.contains("enemies") || !data["enemies"].is_array()) {
         LOG_CRIT("[ERROR]: you must specify an array of enemies.");
@@ -20,6 +21,13 @@ std::vector<level::Enemy> parseEnemies(const nlohmann::json& data)
         enemy.type = entity::StringToType.at(e.at("type"));
         enemy.patternName = e.at("pattern");
         enemy.count = e.at("count");
+        const std::optional<uint8_t> patternId = patterns.getId(enemy.patternName);
+        if (!patternId.has_value()) {
+            LOG_CRIT("[ERROR]: Unknown movement pattern {}, skipping enemy group.",
+                     enemy.patternName);
+            continue;
+        }
+        enemy.patternId = patternId.value();
         enemies.push_back(enemy);
     }
     return enemies;
@@ -39,7 +47,7 @@ void Director::parseArchetypes(const nlohmann::json& data)
         archetype.weight = wave.at("weight");
         archetype.spawnInterval = wave.at("spawnInterval");
         archetype.postWaveDelay = wave.at("postWaveDelay");
-        archetype.enemies = parseEnemies(wave);
+        archetype.enemies = parseEnemies(wave, _patterns);
         _wavePool.push_back(archetype);
     }
 }
@@ -54,6 +62,9 @@ void Director::load(const std::string& waveConfig)
     using json = nlohmann::json;
     try {
         const json data = nlohmann::json::parse(f);
+        if (data.contains("patterns")) {
+            _patterns.parse(data["patterns"]);
+        }
         parseArchetypes(data);
     } catch (nlohmann::json::parse_error& e) {
         LOG_CRIT("{} at {}", e.what(), e.byte);
@@ -123,7 +134,7 @@ void Director::update(const float dt,
             {},
             typeToValue(group.type),
             {entity::state::EntityAlive},
-            {nameToMoveSet(group.patternName)});
+            {group.patternId});
 
         wave.spawnedInGroup++;
 
@@ -140,6 +151,8 @@ void Director::update(const float dt,
     }
 }
 
+const MovePatterns& Director::getPatterns() const { return _patterns; }
+
 void Director::restart()
 {
     _activeWaves.clear();
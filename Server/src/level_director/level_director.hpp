@@ -4,6 +4,7 @@
 #include <vector>
 
 #include "archetype.hpp"
+#include "move_pattern.hpp"
 
 class Lobby;
 
@@ -36,7 +37,13 @@ public:
 
     void restart();
 
+    /**
+     * @return The movement patterns, loaded from the wave configuration file.
+     */
+    const MovePatterns& getPatterns() const;
+
 private:
+    MovePatterns _patterns;
     std::vector<wave::Archetype> _wavePool;
     std::mt19937 _rng{1234};
     float _credits;
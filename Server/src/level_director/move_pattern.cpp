@@ -0,0 +1,74 @@
+#include "move_pattern.hpp"
+
+#include <nlohmann/json.hpp>
+
+#include "logger/Logger.h"
+
+static level::MovePattern parsePattern(const std::string& name,
+                                       const nlohmann::json& data)
+{
+    level::MovePattern pattern;
+    pattern.name = name;
+
+    for (const auto& s : data.value("speed", nlohmann::json::array())) {
+        level::SpeedStage stage;
+        stage.minX = s.value("minX", stage.minX);
+        stage.maxX = s.value("maxX", stage.maxX);
+        stage.whenStopped = s.value("whenStopped", stage.whenStopped);
+        stage.factor = s.at("factor");
+        pattern.speed.push_back(stage);
+    }
+    for (const auto& t : data.value("trajectory", nlohmann::json::array())) {
+        pattern.trajectory.push_back(
+            {t.at("amplitude").get<float>(), t.at("frequency").get<float>()});
+    }
+    pattern.phasePerEntity = data.value("phasePerEntity", pattern.phasePerEntity);
+    if (data.contains("bounds")) {
+        const auto& b = data["bounds"];
+        pattern.bounds = level::VerticalBounds{
+            b.at("minY").get<float>(), b.at("maxY").get<float>(), b.at("push").get<float>()};
+    }
+    return pattern;
+}
+
+namespace level {
+
+void MovePatterns::add(const MovePattern& pattern)
+{
+    if (_ids.contains(pattern.name)) {
+        _patterns[_ids.at(pattern.name)] = pattern;
+        return;
+    }
+    if (_patterns.size() > std::numeric_limits<uint8_t>::max()) {
+        LOG_ERR("Cannot add the pattern {}: too many patterns.", pattern.name);
+        return;
+    }
+    _ids.emplace(pattern.name, static_cast<uint8_t>(_patterns.size()));
+    _patterns.push_back(pattern);
+}
+
+void MovePatterns::parse(const nlohmann::json& data)
+{
+    if (!data.is_object()) {
+        LOG_CRIT("[ERROR]: Patterns object should map pattern names to patterns.");
+        return;
+    }
+    for (const auto& [name, pattern] : data.items()) {
+        add(parsePattern(name, pattern));
+        if (_ids.contains(name)) {
+            LOG_TRACE_R2("Loaded movement pattern {} (id {}).", name, _ids.at(name));
+        }
+    }
+}
+
+std::optional<uint8_t> MovePatterns::getId(const std::string& name) const
+{
+    if (!_ids.contains(name)) {
+        return std::nullopt;
+    }
+    return _ids.at(name);
+}
+
+const std::vector<MovePattern>& MovePatterns::getAll() const { return _patterns; }
+
+}  // namespace level
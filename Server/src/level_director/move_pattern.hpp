@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <nlohmann/json_fwd.hpp>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace level {
+
+/**
+ * @brief A term of the sum of sinusoids describing the trajectory of a pattern.
+ *
+ * The trajectory is @code y(x) = sum(amplitude * sin(frequency * (x + phase)))@endcode, so each
+ * term adds @code amplitude * frequency * cos(frequency * (x + phase))@endcode to its slope.
+ */
+struct Sinusoid
+{
+    float amplitude;  ///< The amplitude of the oscillation, in pixels.
+    float frequency;  ///< The angular frequency of the oscillation, in radians per pixel.
+};
+
+/**
+ * @brief A stage of the speed profile of a pattern.
+ *
+ * The first stage matching the entity sets its horizontal velocity to
+ * @code factor * max_vx@endcode. If no stage matches, the velocity is left untouched.
+ */
+struct SpeedStage
+{
+    float minX = -std::numeric_limits<float>::infinity();  ///< The stage applies after this x.
+    float maxX = std::numeric_limits<float>::infinity();   ///< The stage applies before this x.
+    bool whenStopped = false;  ///< Whether the stage only applies to stopped entities.
+    float factor = 0.0f;       ///< The factor applied to the max horizontal velocity.
+};
+
+/**
+ * @brief The vertical band an entity is pushed back into.
+ */
+struct VerticalBounds
+{
+    float minY;  ///< Entities above this y are pushed down.
+    float maxY;  ///< Entities below this y are pushed up.
+    float push;  ///< The vertical velocity added to push the entity back.
+};
+
+/**
+ * @brief A movement pattern, described as data.
+ */
+struct MovePattern
+{
+    std::string name;                      ///< The name used in the wave configuration file.
+    std::vector<SpeedStage> speed;         ///< The speed profile, evaluated in order.
+    std::vector<Sinusoid> trajectory;      ///< The trajectory, none for a straight line.
+    float phasePerEntity = 0.0f;           ///< The phase added per entity id, to desync them.
+    std::optional<VerticalBounds> bounds;  ///< The band the entity has to stay in, if any.
+};
+
+/**
+ * @class level::MovePatterns
+ * @brief The table of the movement patterns, indexed by the id stored in @code MoveSet@endcode.
+ *
+ * The patterns are only defined by the @code "patterns"@endcode object of the wave configuration
+ * file. Each one gets the next free id, or replaces the pattern loaded before with the same name.
+ */
+class MovePatterns
+{
+public:
+    /**
+     * @brief Parses the patterns of a @code nlohmann::json@endcode data object.
+     * @param data A reference to a @code nlohmann::json@endcode object mapping names to patterns.
+     */
+    void parse(const nlohmann::json& data);
+
+    /**
+     * @param name The name of the pattern.
+     * @return The id of the pattern, or @code std::nullopt@endcode if it does not exist.
+     */
+    std::optional<uint8_t> getId(const std::string& name) const;
+
+    /**
+     * @return All the patterns, indexed by their id.
+     */
+    const std::vector<MovePattern>& getAll() const;
+
+private:
+    std::vector<MovePattern> _patterns;
+    std::unordered_map<std::string, uint8_t> _ids;
+
+    void add(const MovePattern& pattern);
+};
+
+}  // namespace level
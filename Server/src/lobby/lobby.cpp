@@ -32,7 +32,8 @@ Lobby::Lobby(const lobby::Id id,
 
 void Lobby::registerAllSystems()
 {
-    _engine.registerSystem(std::make_shared<server::systems::ApplyEnemyMovement>());
+    _engine.registerSystem(std::make_shared<server::systems::ApplyEnemyMovement>(
+        _levelDirector.getPatterns()));
     _engine.registerSystem(std::make_shared<server::systems::ApplyMovement>());
     _engine.registerSystem(std::make_shared<server::systems::BroadcastUpdatedMovements>(*this));
     _engine.registerSystem(std::make_shared<server::systems::BroadcastDeadEntities>(*this));
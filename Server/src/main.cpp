@@ -24,5 +24,17 @@ int main(int argc,
     }
 
     server::App server(p.getValue("-p").as<int>(), p.getValue("--config").as<std::string>());
+    if (p.hasFlag("--batched-io")) {
+        server.setIoBackend(rtnt::core::Peer::IoBackend::kBatched);
+    }
+    if (p.hasFlag("--io-uring")) {
+        server.setIoBackend(rtnt::core::Peer::IoBackend::kIoUring);
+    }
+    if (p.hasFlag("--udp-offload")) {
+        server.setUdpOffload(true);
+    }
+    if (p.hasFlag("--io-shards")) {
+        server.setShardCount(p.getValue("--io-shards").as<int>());
+    }
     server.start();
 }
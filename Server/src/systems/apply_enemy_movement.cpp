@@ -1,91 +1,131 @@
 #include "apply_enemy_movement.hpp"
 
 #include <cmath>
+#include <cstdint>
+#include <numbers>
 
 #include "components/move_set.hpp"
 #include "components/position.hpp"
-#include "components/velocity.hpp"
-#include "enums/move_set.hpp"
 #include "rtecs/ECS.hpp"
 
-static void straightSlow(const components::Position& pos,
-                         components::Velocity& velocity)
+/**
+ * @brief Round to the nearest integer with float arithmetic only, valid for |value| < 2^22.
+ */
+static float fastRound(const float value)
 {
-    if (pos.x < 1900 && velocity.vx == 0) {
-        velocity.vx = velocity.max_vx;
-    } else if (pos.x > 1900) {
-        velocity.vx = -velocity.max_vx / 4;
-    }
-}
-
-static void wave(const components::Position& pos,
-                 components::Velocity& velocity)
-{
-    constexpr float amplitude = 400.0f;
-    constexpr float frequency = 0.01f;
-
-    const float slope = amplitude * frequency * std::cos(pos.x * frequency);
+    constexpr float magic = 12582912.0f;  // 1.5 * 2^23: the sum has no fractional bit left.
 
-    if (pos.x < 700 && velocity.vx == 0) {
-        velocity.vx = velocity.max_vx / 2;
-    } else {
-        velocity.vx = -velocity.max_vx / 2;
-    }
-    velocity.vy = slope * velocity.vx;
+    return (value + magic) - magic;
 }
 
-static void zigzag(const rtecs::types::EntityID& id,
-                   const components::Position& pos,
-                   components::Velocity& velocity)
+/**
+ * @brief A branch-free cosine approximation (max error ~1e-3), that the compiler can vectorize.
+ */
+static float fastCos(float x)
 {
-    const float phaseOffset = id * 777;
-    constexpr std::array frequAmp = {
-        std::make_pair<float, float>(.005, 400),
-        std::make_pair<float, float>(.008, 150),
-        std::make_pair<float, float>(0.03, 20),
-    };
-
-    float totalSlope = 0;
-    for (const auto& [f, a] : frequAmp) {
-        totalSlope += a * f * std::cos((pos.x + phaseOffset) * f);
-    }
+    constexpr float invTwoPi = 0.5f * std::numbers::inv_pi_v<float>;
 
-    if (velocity.vx == 0) {
-        velocity.vx = -velocity.max_vx / 2;
-    }
-    velocity.vy = totalSlope * velocity.vx;
-    if (pos.y < 50.0f) {
-        velocity.vy += 20.0f;
-    } else if (pos.y > 900.0f) {
-        velocity.vy -= 20.0f;
-    }
+    x = x * invTwoPi - 0.25f;
+    x -= fastRound(x);
+    x *= 16.0f * (std::abs(x) - 0.5f);
+    x += 0.225f * x * (std::abs(x) - 1.0f);
+    return x;
 }
 
 namespace server::systems {
 
-ApplyEnemyMovement::ApplyEnemyMovement()
-    : ASystem("ApplyEnemyMovement")
+void ApplyEnemyMovement::Batch::clear()
+{
+    x.clear();
+    y.clear();
+    phase.clear();
+    slope.clear();
+    velocities.clear();
+}
+
+ApplyEnemyMovement::ApplyEnemyMovement(const level::MovePatterns& patterns)
+    : ASystem("ApplyEnemyMovement"),
+      _patterns(patterns)
 {
 }
 
 void ApplyEnemyMovement::apply(rtecs::ECS& ecs)
 {
+    const std::vector<level::MovePattern>& patterns = _patterns.getAll();
     auto entities = ecs.group<components::Position, components::Velocity, components::MoveSet>();
 
-    entities.apply([](const rtecs::types::EntityID& id,
-                      const components::Position& position,
-                      components::Velocity& velocity,
-                      const components::MoveSet& moveSet) {
-        if (moveSet.set == static_cast<uint8_t>(move::Set::kStraightSlow)) {
-            return straightSlow(position, velocity);
+    _batches.resize(patterns.size());
+    for (Batch& batch : _batches) {
+        batch.clear();
+    }
+
+    entities.apply([&](const rtecs::types::EntityID& id,
+                       const components::Position& position,
+                       components::Velocity& velocity,
+                       const components::MoveSet& moveSet) {
+        if (moveSet.set >= patterns.size()) {
+            return;
         }
-        if (moveSet.set == static_cast<uint8_t>(move::Set::kWave)) {
-            return wave(position, velocity);
+        Batch& batch = _batches[moveSet.set];
+        batch.x.push_back(position.x);
+        batch.y.push_back(position.y);
+        batch.phase.push_back(static_cast<float>(id) * patterns[moveSet.set].phasePerEntity);
+        batch.velocities.push_back(&velocity);
+    });
+
+    for (size_t i = 0; i < patterns.size(); i++) {
+        if (!_batches[i].velocities.empty()) {
+            applyPattern(patterns[i], _batches[i]);
         }
-        if (moveSet.set == static_cast<uint8_t>(move::Set::kZigZag)) {
-            return zigzag(id, position, velocity);
+    }
+}
+
+void ApplyEnemyMovement::applyPattern(const level::MovePattern& pattern,
+                                      Batch& batch)
+{
+    const size_t count = batch.velocities.size();
+
+    for (size_t i = 0; i < count; i++) {
+        components::Velocity& velocity = *batch.velocities[i];
+
+        for (const level::SpeedStage& stage : pattern.speed) {
+            if (batch.x[i] > stage.minX && batch.x[i] < stage.maxX &&
+                (!stage.whenStopped || velocity.vx == 0)) {
+                velocity.vx = stage.factor * velocity.max_vx;
+                break;
+            }
         }
-    });
+    }
+
+    if (!pattern.trajectory.empty()) {
+        batch.slope.assign(count, 0.0f);
+        // One pass per term over contiguous arrays, so that these loops get vectorized.
+        for (const level::Sinusoid& term : pattern.trajectory) {
+            const float gain = term.amplitude * term.frequency;
+            const float* x = batch.x.data();
+            const float* phase = batch.phase.data();
+            float* slope = batch.slope.data();
+
+            for (size_t i = 0; i < count; i++) {
+                slope[i] += gain * fastCos((x[i] + phase[i]) * term.frequency);
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            batch.velocities[i]->vy = batch.slope[i] * batch.velocities[i]->vx;
+        }
+    }
+
+    if (pattern.bounds.has_value()) {
+        const level::VerticalBounds& bounds = pattern.bounds.value();
+
+        for (size_t i = 0; i < count; i++) {
+            if (batch.y[i] < bounds.minY) {
+                batch.velocities[i]->vy += bounds.push;
+            } else if (batch.y[i] > bounds.maxY) {
+                batch.velocities[i]->vy -= bounds.push;
+            }
+        }
+    }
 }
 
 }  // namespace server::systems
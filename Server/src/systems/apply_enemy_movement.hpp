@@ -1,13 +1,45 @@
 #pragma once
 
+#include <vector>
+
+#include "components/velocity.hpp"
+#include "level_director/move_pattern.hpp"
 #include "rtecs/systems/ASystem.hpp"
 
 namespace server::systems {
 
 class ApplyEnemyMovement final : public rtecs::systems::ASystem
 {
+private:
+    /**
+     * @brief The entities following the same pattern, stored as a structure of arrays so that
+     * the trajectories are evaluated for the whole batch at once.
+     */
+    struct Batch
+    {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> phase;
+        std::vector<float> slope;
+        std::vector<components::Velocity*> velocities;
+
+        void clear();
+    };
+
+    const level::MovePatterns& _patterns;
+    std::vector<Batch> _batches;  ///< The batches, indexed by pattern id.
+
+    /**
+     * @brief Apply a pattern to all the entities following it.
+     *
+     * @param pattern The movement pattern
+     * @param batch The entities following the pattern
+     */
+    static void applyPattern(const level::MovePattern& pattern,
+                             Batch& batch);
+
 public:
-    explicit ApplyEnemyMovement();
+    explicit ApplyEnemyMovement(const level::MovePatterns& patterns);
     void apply(rtecs::ECS& ecs) override;
 };
 
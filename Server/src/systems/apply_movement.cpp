@@ -1,5 +1,7 @@
 #include "apply_movement.hpp"
 
+#include <algorithm>
+
 #include "components/factory.hpp"
 #include "components/position.hpp"
 #include "components/velocity.hpp"
@@ -10,7 +12,10 @@ using namespace server::systems;
 using namespace components;
 
 ApplyMovement::ApplyMovement()
-    : ASystem("UpdatePosition")
+    : ASystem("UpdatePosition"),
+      _layers{rtecs::spatial::SpatialGrid(kBroadphaseCellSize),
+              rtecs::spatial::SpatialGrid(kBroadphaseCellSize),
+              rtecs::spatial::SpatialGrid(kBroadphaseCellSize)}
 {
 }
 
@@ -20,6 +25,7 @@ void ApplyMovement::apply(rtecs::ECS& ecs)
     auto movable = ecs.group<Type, Velocity, Position, Hitbox, State>();
     auto colliders = ecs.group<Position, Hitbox, State, Type>();
 
+    buildBroadphase(colliders);
     movable.apply([&](const rtecs::types::EntityID id,
                       const Type& type,
                       Velocity& vel,
@@ -30,56 +36,113 @@ void ApplyMovement::apply(rtecs::ECS& ecs)
         if (type.type == entity::Type::kPlayer) {
             const Position nextHorizontalPos = {pos.x + vel.vx, pos.y};
             const std::optional<Collider> horizontalCollider =
-                findCollider(id, nextHorizontalPos, box, colliders, entity::Type::kPlayer);
+                findCollider(id, nextHorizontalPos, box, entity::Type::kPlayer);
             handlePlayerHorizontalMovement(pos, vel, box, horizontalCollider);
 
             const Position nextVerticalPos = {pos.x, pos.y + vel.vy};
             const std::optional<Collider> verticalCollider =
-                findCollider(id, nextVerticalPos, box, colliders, entity::Type::kPlayer);
+                findCollider(id, nextVerticalPos, box, entity::Type::kPlayer);
             handlePlayerVerticalMovement(pos, vel, box, verticalCollider);
         } else {
             const Position nextPos = {pos.x + vel.vx, pos.y + vel.vy};
             const entity::Type expectedType =
                 type.type == entity::Type::kBullet ? entity::Type::kEnemy : entity::Type::kPlayer;
-            const std::optional<Collider> collider =
-                findCollider(id, nextPos, box, colliders, expectedType);
+            const std::optional<Collider> collider = findCollider(id, nextPos, box, expectedType);
             handleEntityMovement(pos, vel, box, state, collider);
             if (type.type == entity::Type::kBullet &&
                 (pos.x - box.width < 0 || pos.x > 1920 || pos.y - box.height < 0 || pos.y > 1080)) {
                 state.state = entity::state::EntityDead;
             }
         }
+        updateBroadphase(id, pos, box);
     });
 }
 
-std::optional<ApplyMovement::Collider> ApplyMovement::findCollider(
-    const rtecs::types::EntityID id,
-    const Position& pos,
-    const Hitbox& box,
-    rtecs::sparse::SparseGroup<Position,
-                               Hitbox,
-                               State,
-                               Type>& colliders,
-    const entity::Type expectedColliderType)
+rtecs::spatial::AABB ApplyMovement::toBounds(const Position& pos,
+                                             const Hitbox& box)
 {
-    bool isCollisionDetected = false;
-    std::optional<Collider> collider = std::nullopt;
+    return {pos.x, pos.y, box.width, box.height};
+}
+
+void ApplyMovement::buildBroadphase(Colliders& colliders)
+{
+    for (rtecs::spatial::SpatialGrid& layer : _layers) {
+        layer.clear();
+    }
+    _colliderIds.clear();
+    _colliders.clear();
+    _colliderIndexes.clear();
 
     colliders.apply([&](const rtecs::types::EntityID colliderId,
                         Position& colliderPos,
                         Hitbox& colliderBox,
                         State& colliderState,
                         Type& colliderType) {
-        if (colliderType.type != expectedColliderType || colliderId == id || isCollisionDetected) {
-            return;
+        const size_t index = _colliders.size();
+        const auto layer = static_cast<size_t>(colliderType.type);
+
+        _colliderIds.push_back(colliderId);
+        _colliders.emplace_back(colliderPos, colliderBox, colliderState, colliderType);
+        _colliderIndexes.emplace(colliderId, index);
+        if (layer < kLayerCount) {
+            _layers[layer].update(index, toBounds(colliderPos, colliderBox));
         }
-        if (collide(pos, box, colliderPos, colliderBox)) {
-            isCollisionDetected = true;
-            collider = std::tuple<Position&, Hitbox&, State&, Type&>(
-                colliderPos, colliderBox, colliderState, colliderType);
+    });
+}
+
+void ApplyMovement::updateBroadphase(const rtecs::types::EntityID id,
+                                     const Position& pos,
+                                     const Hitbox& box)
+{
+    const auto it = _colliderIndexes.find(id);
+
+    if (it == _colliderIndexes.end()) {
+        return;
+    }
+
+    const auto layer = static_cast<size_t>(std::get<Type&>(_colliders[it->second]).type);
+
+    if (layer < kLayerCount) {
+        _layers[layer].update(it->second, toBounds(pos, box));
+    }
+}
+
+std::optional<ApplyMovement::Collider> ApplyMovement::findCollider(
+    const rtecs::types::EntityID id,
+    const Position& pos,
+    const Hitbox& box,
+    const entity::Type expectedColliderType)
+{
+    const auto layer = static_cast<size_t>(expectedColliderType);
+
+    if (layer >= kLayerCount) {
+        return std::nullopt;
+    }
+
+    const rtecs::spatial::AABB bounds = toBounds(pos, box);
+
+    _candidates.clear();
+    _layers[layer].queryCandidates(bounds, [&](const size_t index, const rtecs::spatial::AABB&) {
+        if (_colliderIds[index] != id) {
+            _candidates.push_back(index);
         }
     });
-    return collider;
+    // The cells are not visited in the group order: sort the candidates so that the first hit is
+    // the first collider of the group, whatever the broadphase.
+    std::ranges::sort(_candidates);
+
+    _narrowphase.clear();
+    for (const size_t index : _candidates) {
+        const Collider& candidate = _colliders[index];
+        _narrowphase.push(toBounds(std::get<Position&>(candidate), std::get<Hitbox&>(candidate)));
+    }
+
+    const std::optional<size_t> hit = _narrowphase.firstHit(bounds);
+
+    if (!hit.has_value()) {
+        return std::nullopt;
+    }
+    return _colliders[_candidates[hit.value()]];
 }
 
 void ApplyMovement::handleEntityMovement(Position& pos,
@@ -138,12 +201,3 @@ void ApplyMovement::handlePlayerVerticalMovement(Position& pos,
     }
     vel.vy = 0;
 }
-
-bool ApplyMovement::collide(const Position& refPos,
-                            const Hitbox& refBox,
-                            const Position& otherPos,
-                            const Hitbox& otherBox)
-{
-    return (refPos.x < otherPos.x + otherBox.width && refPos.x + refBox.width > otherPos.x &&
-            refPos.y < otherPos.y + otherBox.height && refPos.y + refBox.height > otherPos.y);
-}
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <array>
 #include <optional>
+#include <unordered_map>
+#include <vector>
 
 #include "components/hitbox.hpp"
 #include "components/position.hpp"
 #include "components/state.hpp"
 #include "components/type.hpp"
 #include "components/velocity.hpp"
+#include "rtecs/spatial/AABBBatch.hpp"
+#include "rtecs/spatial/SpatialGrid.hpp"
 #include "rtecs/sparse/group/SparseGroup.hpp"
 #include "rtecs/systems/ASystem.hpp"
 #include "rtecs/types/types.hpp"
@@ -19,38 +24,65 @@ class ApplyMovement final : public rtecs::systems::ASystem
 {
 private:
     using Collider = std::tuple<Position&, Hitbox&, State&, Type&>;
+    using Colliders = rtecs::sparse::SparseGroup<Position, Hitbox, State, Type>;
+
+    /// The size of a broadphase cell, close to the size of the biggest hitboxes (enemies).
+    static constexpr float kBroadphaseCellSize = 160.0f;
+    static constexpr size_t kLayerCount = 3;
+
+    /// One grid per entity type. The grids are keyed by the index of the collider in the group.
+    std::array<rtecs::spatial::SpatialGrid, kLayerCount> _layers;
+    std::vector<rtecs::types::EntityID> _colliderIds;
+    std::vector<Collider> _colliders;
+    std::unordered_map<rtecs::types::EntityID, size_t> _colliderIndexes;
+    /// The candidates of the current query, sorted in the group order, and their hitboxes.
+    std::vector<size_t> _candidates;
+    rtecs::spatial::AABBBatch _narrowphase;
+
+    /**
+     * @brief Get the bounding box of an entity.
+     *
+     * @param pos The position of the entity
+     * @param box The hitbox of the entity
+     * @return The bounding box of the entity.
+     */
+    static rtecs::spatial::AABB toBounds(const Position& pos,
+                                         const Hitbox& box);
+
     /**
-     * @brief Check if a horizontal/vertical collision is detected.
+     * @brief Index every collider in the grid of its type.
      *
-     * @param refPos The reference position
-     * @param refBox The reference hitbox
-     * @param otherPos The other position
-     * @param otherBox The other hitbox
-     * @return `true` if a collision is detected, `false` otherwise.
+     * @param colliders The list of colliders
      */
-    static bool collide(const Position& refPos,
-                        const Hitbox& refBox,
-                        const Position& otherPos,
-                        const Hitbox& otherBox);
+    void buildBroadphase(Colliders& colliders);
 
     /**
-     * @bief Find a collider
+     * @brief Move a collider in the broadphase after its position changed.
+     *
+     * @param id The id of the moved entity
+     * @param pos The new position of the entity
+     * @param box The hitbox of the entity
+     */
+    void updateBroadphase(rtecs::types::EntityID id,
+                          const Position& pos,
+                          const Hitbox& box);
+
+    /**
+     * @brief Find a collider
+     *
+     * Only the colliders sharing a broadphase cell with the moving entity are tested, all at once
+     * in the narrowphase. When several of them collide, the first one of the group is returned.
      *
      * @param id The id of the moving entity
      * @param pos The position of the moving entity
      * @param box The box of the moving entity
-     * @param colliders The list of colliders
      * @param expectedColliderType The excpected collider type
      * @return An optional collider if any.
      */
-    static std::optional<Collider> findCollider(rtecs::types::EntityID id,
-                                                const Position& pos,
-                                                const Hitbox& box,
-                                                rtecs::sparse::SparseGroup<Position,
-                                                                           Hitbox,
-                                                                           State,
-                                                                           Type>& colliders,
-                                                entity::Type expectedColliderType);
+    std::optional<Collider> findCollider(rtecs::types::EntityID id,
+                                         const Position& pos,
+                                         const Hitbox& box,
+                                         entity::Type expectedColliderType);
 
     /**
      * @brief Handle the movement of the bullets and enemies
@@ -1,12 +1,12 @@
 #pragma once
 
 #include <functional>
+#include <unordered_map>
 #include <vector>
 
 #include "Transform.hpp"
 #include "collision.hpp"
 #include "damage.hpp"
-#include "enums/move_set.hpp"
 #include "health.hpp"
 #include "hitbox.hpp"
 #include "invulnerability.hpp"
@@ -53,11 +53,6 @@ inline Velocity typeToVelocity(const entity::Type& type) { return entityTypeToVe
 
 inline Value typeToValue(const entity::Type& type) { return entityTypeToValue.at(type); }
 
-inline uint8_t nameToMoveSet(const std::string& name)
-{
-    return static_cast<uint8_t>(move::StringToMoveSet.at(name));
-}
-
 class Factory
 {
 public:
@@ -4,9 +4,12 @@
 
 namespace components {
 
+/**
+ * @brief Specifies the movement pattern of an enemy.
+ */
 struct MoveSet
 {
-    uint8_t set;
+    uint8_t set;  ///< The id of the pattern, assigned by the server from the wave configuration.
 
     template <typename Archive>
     void serialize(Archive& ar)
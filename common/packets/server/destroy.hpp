@@ -13,6 +13,7 @@ struct Destroy
 {
     static constexpr auto kId = static_cast<rtnt::core::packet::Id>(type::Server::kDestroy);
     static constexpr auto kFlag = rtnt::core::packet::Flag::kUnreliable;
+    static constexpr auto kPriority = rtnt::core::packet::Priority::kHigh;
     static constexpr rtnt::core::packet::Name kName = "DESTROY";
 
     rtecs::types::EntityID id;  ///< The id of the destroyed entity.
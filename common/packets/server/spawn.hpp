@@ -13,6 +13,7 @@ struct Spawn
 {
     static constexpr auto kId = static_cast<rtnt::core::packet::Id>(type::Server::kSpawn);
     static constexpr auto kFlag = rtnt::core::packet::Flag::kReliable;
+    static constexpr auto kPriority = rtnt::core::packet::Priority::kHigh;
     static constexpr rtnt::core::packet::Name kName = "SPAWN";
 
     rtecs::types::EntityID id;      ///< The id of the entity for future reference
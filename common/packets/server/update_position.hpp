@@ -12,7 +12,8 @@ namespace packet {
 struct UpdatePosition
 {
     static constexpr auto kId = static_cast<rtnt::core::packet::Id>(type::Server::kUpdatePosition);
-    static constexpr auto kFlag = rtnt::core::packet::Flag::kUnreliable;
+    static constexpr auto kFlag = rtnt::core::packet::Flag::kSequenced;
+    static constexpr auto kLifetime = std::chrono::milliseconds(50);  ///< One server tick
     static constexpr rtnt::core::packet::Name kName = "UPDATE_POSITION";
 
     rtecs::types::EntityID id;  ///< The id of the entity
@@ -21,6 +22,12 @@ struct UpdatePosition
     float vx;                   //< The x velocity of the entity (used for dead reckoning)
     float vy;                   //< The y velocity of the entity (used for dead reckoning)
 
+    /// Only the newest position of each entity is delivered.
+    [[nodiscard]] rtnt::core::packet::SequenceKey sequenceKey() const
+    {
+        return static_cast<rtnt::core::packet::SequenceKey>(id);
+    }
+
     template <typename Archive>
     void serialize(Archive& ar)
     {
@@ -0,0 +1,58 @@
+#include "rtecs/spatial/AABBBatch.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+
+using namespace rtecs::spatial;
+
+/**
+ * @brief Measure the average time of a narrowphase query, in nanoseconds.
+ *
+ * Every query misses, so that the whole batch is tested each time.
+ */
+template <typename Fn>
+static double measure(const AABBBatch &batch,
+                      Fn &&query)
+{
+    constexpr size_t queries = 1 << 20;
+    const AABB box = {-100.0f, -100.0f, 10.0f, 10.0f};
+    size_t hits = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < queries; i++) {
+        hits += query(batch, box).has_value();
+    }
+    const auto end = std::chrono::steady_clock::now();
+
+    if (hits != 0) {
+        std::printf("Unexpected hit.\n");
+    }
+    return std::chrono::duration<double, std::nano>(end - start).count() / queries;
+}
+
+int main()
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coordinate(0.0f, 1920.0f);
+    std::uniform_real_distribution<float> size(5.0f, 150.0f);
+
+    std::printf("%10s %14s %14s %9s\n", "candidates", "scalar (ns)", "batched (ns)", "speedup");
+    for (size_t count = 8; count <= 1024; count *= 2) {
+        AABBBatch batch;
+
+        batch.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            batch.push({coordinate(rng), coordinate(rng), size(rng), size(rng)});
+        }
+
+        const double scalar = measure(batch, [](const AABBBatch &b, const AABB &box) {
+            return b.firstHitScalar(box);
+        });
+        const double batched =
+            measure(batch, [](const AABBBatch &b, const AABB &box) { return b.firstHit(box); });
+
+        std::printf("%10zu %14.1f %14.1f %8.1fx\n", count, scalar, batched, scalar / batched);
+    }
+    return 0;
+}
@@ -9,6 +9,7 @@
 #include "sparse/group/SparseGroup.hpp"
 #include "sparse/set/SparseSet.hpp"
 #include "sparse/view/SparseView.hpp"
+#include "spatial/SpatialGrid.hpp"
 #include "systems/ISystem.hpp"
 
 namespace rtecs {
@@ -26,6 +27,8 @@ namespace rtecs {
  * - Get specifics components of a single entity
  * - Get all the instances of a specific group (Transform + Gravity + Collidable) of all entities
  * - Delete an entity
+ * - Clone the world (or a subset of its components)
+ * - Index the entities by their position to run area and proximity queries
  *
  * @note You can also instantiate an ECS using the ECS::createWithComponents<Your, Components, Here>();
  */
@@ -42,6 +45,11 @@ private:
     bitset::DynamicBitSet _componentMaskIndex;
     bitset::DynamicBitSet _emptyComponentMask;
 
+    using SpatialBoundsFn = std::function<std::optional<spatial::AABB>(ECS &, types::EntityID)>;
+    spatial::SpatialGrid _spatialIndex;
+    bitset::DynamicBitSet _spatialComponentsMask;
+    SpatialBoundsFn _spatialBounds;
+
 private:
     /**
      * @brief Register a single component.
@@ -119,6 +127,7 @@ private:
         LOG_TRACE_R3("Updated mask of entity#{}", entityId);
         ptr->put(entityId, instance);
         LOG_TRACE_R3("Updated component#{} of entity#{}", componentId, entityId);
+        onComponentUpdated(entityId, _componentsMasks.at(componentId));
     }
 
     /**
@@ -200,6 +209,7 @@ private:
         }
         set.put(entityId, newInstance);
         LOG_TRACE_R3("Updated component#{} of entity#{}", set.getId(), entityId);
+        onComponentUpdated(entityId, _componentsMasks.at(set.getId()));
         return true;
     }
 
@@ -215,6 +225,25 @@ private:
         return typeid(T).hash_code();
     }
 
+    /**
+     * @brief Refresh the spatial index if one of the indexed components of an entity changed.
+     *
+     * @param entityId The entity's ID
+     * @param componentMask The mask of the updated component
+     */
+    void onComponentUpdated(types::EntityID entityId,
+                            const bitset::DynamicBitSet &componentMask);
+
+    /**
+     * @brief Clone the world, keeping only the components that match the given mask.
+     *
+     * @param componentsMask The mask of the components to keep, or `std::nullopt` to keep them all.
+     * @return The cloned world.
+     */
+    [[nodiscard]]
+    std::unique_ptr<ECS> cloneHelper(
+        const std::optional<bitset::DynamicBitSet> &componentsMask) const;
+
 public:
     explicit ECS();
     ~ECS() = default;
@@ -373,6 +402,142 @@ public:
         return sparse::SparseGroup<T...>(getComponent<T>()...);
     }
 
+    /*************/
+    /**  WORLD  **/
+    /*************/
+
+    /**
+     * @brief Fork the world.
+     *
+     * The returned ECS holds a copy of every entity and of every component instance, and can be
+     * simulated forward without altering this one (client-side prediction, lag compensation...).
+     * The component storages are copied in bulk and their sparse pages are shared with this world
+     * until one of the two writes to them (copy-on-write).
+     *
+     * @note If component types are specified, only these components are copied and registered in
+     * the cloned world. The entities are kept, but their masks are restricted to these components.
+     * @warning The systems are shared with this world: systems holding a state (or a reference to
+     * something outside the ECS) will act on it from both worlds.
+     *
+     * @tparam T The components to copy (all of them if none is specified).
+     * @return The cloned world.
+     */
+    template <typename... T>
+    [[nodiscard]]
+    std::unique_ptr<ECS> clone() const
+    {
+        if constexpr (sizeof...(T) == 0) {
+            return cloneHelper(std::nullopt);
+        } else {
+            return cloneHelper(getComponentMask<T...>());
+        }
+    }
+
+    /***************/
+    /**  SPATIAL  **/
+    /***************/
+
+    /**
+     * @brief Index every entity that has both components in a uniform grid.
+     *
+     * The index is updated incrementally when one of these components is added or updated through
+     * the ECS (`addEntityComponents`, `updateEntity`...) and when an entity is destroyed.
+     *
+     * @warning Components modified in place (through a SparseGroup for instance) are not tracked:
+     * call `refreshSpatialIndex` on the moved entities (or on the whole world) afterwards.
+     * @note Registering a new spatial index replaces the previous one.
+     *
+     * @tparam TPosition The component that holds the position of the entity.
+     * @tparam TBox The component that holds the size of the entity.
+     * @param boundsFn A function computing the bounding box of an entity from its components.
+     * @param cellSize The size of a cell of the grid.
+     */
+    template <typename TPosition, typename TBox>
+    void registerSpatialIndex(
+        const std::function<spatial::AABB(const TPosition &, const TBox &)> &boundsFn,
+        const float cellSize = spatial::SpatialGrid::kDefaultCellSize)
+    {
+        if (!_components.contains(getComponentID<TPosition>()) ||
+            !_components.contains(getComponentID<TBox>())) {
+            LOG_WARN(
+                "Cannot register the spatial index: One of its components has not been "
+                "registered.");
+            return;
+        }
+        _spatialComponentsMask = getComponentMask<TPosition, TBox>();
+        _spatialBounds = [boundsFn](ECS &ecs,
+                                    types::EntityID entityId) -> std::optional<spatial::AABB> {
+            types::OptionalRef<sparse::SparseSet<TPosition>> positions =
+                ecs.getComponent<TPosition>();
+            types::OptionalRef<sparse::SparseSet<TBox>> boxes = ecs.getComponent<TBox>();
+
+            if (!positions.has_value() || !boxes.has_value()) {
+                return std::nullopt;
+            }
+
+            types::OptionalRef<TPosition> position = positions->get().get(entityId);
+            types::OptionalRef<TBox> box = boxes->get().get(entityId);
+
+            if (!position.has_value() || !box.has_value()) {
+                return std::nullopt;
+            }
+            return boundsFn(position->get(), box->get());
+        };
+        _spatialIndex = spatial::SpatialGrid(cellSize);
+        refreshSpatialIndex();
+        LOG_TRACE_R2("Spatial index registered ({} entities indexed).", _spatialIndex.size());
+    }
+
+    /**
+     * @brief Re-compute the bounding box of an entity in the spatial index.
+     *
+     * @note The entity is removed from the index if it no longer has the indexed components.
+     *
+     * @param entityId The entity's ID
+     */
+    void refreshSpatialIndex(types::EntityID entityId);
+
+    /**
+     * @brief Re-compute the bounding box of every entity in the spatial index.
+     */
+    void refreshSpatialIndex();
+
+    /**
+     * @brief Call the callback on every indexed entity whose bounding box overlaps the area.
+     *
+     * @note If the callback returns a `bool`, returning `true` stops the query.
+     *
+     * @param area The queried area
+     * @param callback A callable taking the `types::EntityID` and the `const spatial::AABB &` of an
+     * entity.
+     */
+    template <typename Fn>
+    void queryAABB(const spatial::AABB &area,
+                   Fn &&callback) const
+    {
+        _spatialIndex.queryAABB(area, std::forward<Fn>(callback));
+    }
+
+    /**
+     * @brief Find the indexed entity whose bounding box is the closest to a point.
+     *
+     * @param x The x coordinate of the point
+     * @param y The y coordinate of the point
+     * @param maxDistance The maximum distance between the point and the entity
+     * @return The closest entity, or `std::nullopt` if none is within `maxDistance`.
+     */
+    [[nodiscard]]
+    std::optional<types::EntityID> queryNearest(
+        float x,
+        float y,
+        float maxDistance = std::numeric_limits<float>::infinity()) const;
+
+    /**
+     * @return The spatial index of the world.
+     */
+    [[nodiscard]]
+    const spatial::SpatialGrid &getSpatialIndex() const;
+
     /***************/
     /**  SYSTEMS  **/
     /***************/
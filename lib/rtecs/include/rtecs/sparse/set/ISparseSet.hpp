@@ -1,5 +1,7 @@
 #pragma once
 
+#include <memory>
+
 #include "rtecs/types/types.hpp"
 
 namespace rtecs::sparse {
@@ -31,8 +33,10 @@ public:
      * @brief Remove the entity associated component from the sparse-set.
      *
      * @param id The entity to remove from the sparse-set.
+     * @throw std::bad_alloc If a sparse page shared with a clone could not be
+     * copied. The sparse-set is then left unchanged.
      */
-    virtual void remove(size_t id) noexcept = 0;
+    virtual void remove(size_t id) = 0;
 
     /**
      * @brief Clear the sparse-set, removing all stored components.
@@ -62,6 +66,14 @@ public:
      */
     [[nodiscard]]
     virtual types::ComponentID getId() const = 0;
+
+    /**
+     * @brief Create an independent copy of the sparse-set.
+     *
+     * @return A new sparse-set holding the same components.
+     */
+    [[nodiscard]]
+    virtual std::unique_ptr<ISparseSet> clone() const = 0;
 };
 
 }  // namespace rtecs::sparse
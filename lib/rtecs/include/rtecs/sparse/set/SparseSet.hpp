@@ -28,11 +28,14 @@ namespace rtecs::sparse {
  * - `_entities` stores the corresponding entity ids for each dense slot.
  * - `_sparsePages` is a paged sparse array mapping an entity id to the
  *   dense index. Each page is an array of optional indices of size
- *   `kPageSize`.
+ *   `kPageSize`, allocated lazily on first write.
  *
  * This design allows O(1) average-time `has`, `put`, and `remove` (the
  * `remove` performs a swap-with-last in the dense array). The paged sparse
  * array avoids allocating a huge flat sparse array for large entity ids.
+ *
+ * Sparse pages are shared between a set and its clones (see `clone()`) and
+ * are only copied when one of them writes to a shared page (copy-on-write).
  */
 template <typename T>
 class SparseSet final : public ASparseSet
@@ -52,7 +55,18 @@ private:
     static constexpr OptionalSparseElement kNullSparseElement = std::nullopt;
 
     std::vector<T> _dense;
-    std::vector<Sparse> _sparsePages{};
+    std::vector<std::shared_ptr<Sparse>> _sparsePages{};
+
+    /**
+     * @brief Get a page that is safe to write into.
+     *
+     * Allocates the page if it does not exist yet, and detaches it if it is still shared with
+     * another SparseSet (copy-on-write).
+     *
+     * @param page The index of the page.
+     * @return A mutable reference to the page.
+     */
+    Sparse &getWritablePage(size_t page);
 
 public:
     /**
@@ -115,8 +129,10 @@ public:
      * @brief Remove the entity associated component from the sparse-set.
      *
      * @param id The entity to remove from the sparse-set.
+     * @throw std::bad_alloc If a sparse page shared with a clone could not be
+     * copied. The sparse-set is then left unchanged.
      */
-    void remove(size_t id) noexcept override;
+    void remove(size_t id) override;
 
     /**
      * Clear the sparse-set.
@@ -130,6 +146,17 @@ public:
      */
     [[nodiscard]]
     size_t size() const noexcept override;
+
+    /**
+     * @brief Create a copy of the sparse-set.
+     *
+     * The dense storage is copied in bulk, while the sparse pages are shared with the copy until
+     * either set writes to them.
+     *
+     * @return A new sparse-set holding the same components.
+     */
+    [[nodiscard]]
+    std::unique_ptr<ISparseSet> clone() const override;
 };
 
 // ====================================
@@ -141,11 +168,11 @@ types::OptionalRef<T> SparseSet<T>::get(const size_t id) noexcept
     const size_t page = PAGE_OF(id, kPageSize);
     const size_t sparseIndex = PAGE_INDEX_OF(id, kPageSize);
 
-    if (page >= _sparsePages.size()) {
+    if (page >= _sparsePages.size() || !_sparsePages[page]) {
         return std::nullopt;
     }
 
-    const OptionalSparseElement optionalDenseIndex = _sparsePages[page][sparseIndex];
+    const OptionalSparseElement optionalDenseIndex = (*_sparsePages[page])[sparseIndex];
 
     if (!optionalDenseIndex.has_value()) {
         return std::nullopt;
@@ -159,11 +186,11 @@ types::OptionalCRef<T> SparseSet<T>::get(const size_t id) const noexcept
     const size_t page = PAGE_OF(id, kPageSize);
     const size_t sparseIndex = PAGE_INDEX_OF(id, kPageSize);
 
-    if (page >= _sparsePages.size()) {
+    if (page >= _sparsePages.size() || !_sparsePages[page]) {
         return std::nullopt;
     }
 
-    const OptionalSparseElement optionalDenseIndex = _sparsePages[page][sparseIndex];
+    const OptionalSparseElement optionalDenseIndex = (*_sparsePages[page])[sparseIndex];
 
     if (!optionalDenseIndex.has_value()) {
         return std::nullopt;
@@ -183,10 +210,10 @@ bool SparseSet<T>::has(const size_t id) const noexcept
     const size_t page = PAGE_OF(id, kPageSize);
     const size_t sparseIndex = PAGE_INDEX_OF(id, kPageSize);
 
-    if (page >= _sparsePages.size()) {
+    if (page >= _sparsePages.size() || !_sparsePages[page]) {
         return false;
     }
-    return _sparsePages[page].at(sparseIndex).has_value();
+    return _sparsePages[page]->at(sparseIndex).has_value();
 }
 
 template <typename T>
@@ -202,17 +229,13 @@ bool SparseSet<T>::put(const size_t id,
     const size_t page = PAGE_OF(id, kPageSize);
     const size_t sparseIndex = PAGE_INDEX_OF(id, kPageSize);
 
-    if (page >= _sparsePages.size()) {
-        _sparsePages.resize(page + 1);
-        _sparsePages[page].fill(kNullSparseElement);
-    }
-
-    const OptionalSparseElement optionalDenseIndex = _sparsePages[page][sparseIndex];
+    Sparse &sparsePage = getWritablePage(page);
+    const OptionalSparseElement optionalDenseIndex = sparsePage[sparseIndex];
 
     if (!optionalDenseIndex.has_value()) {
         _dense.push_back(component);
         _entities.push_back(id);
-        _sparsePages[page][sparseIndex] = _dense.size() - 1;
+        sparsePage[sparseIndex] = _dense.size() - 1;
     } else {
         const size_t denseIndex = optionalDenseIndex.value();
         _dense[denseIndex] = component;
@@ -222,7 +245,7 @@ bool SparseSet<T>::put(const size_t id,
 }
 
 template <typename T>
-void SparseSet<T>::remove(const size_t id) noexcept
+void SparseSet<T>::remove(const size_t id)
 {
     if (!has(id)) {
         return;
@@ -230,13 +253,20 @@ void SparseSet<T>::remove(const size_t id) noexcept
 
     const size_t targetPage = PAGE_OF(id, kPageSize);
     const size_t targetSparseIndex = PAGE_INDEX_OF(id, kPageSize);
-    const OptionalSparseElement optionalTargetIndex = _sparsePages[targetPage][targetSparseIndex];
+    const OptionalSparseElement optionalTargetIndex =
+        (*_sparsePages[targetPage])[targetSparseIndex];
 
     if (!optionalTargetIndex.has_value()) {
         return;
     }
 
     const size_t targetIndex = optionalTargetIndex.value();
+
+    // Pages shared with a clone are detached (which may throw) before anything is modified.
+    Sparse &targetSparsePage = getWritablePage(targetPage);
+    const size_t movedPage = PAGE_OF(_entities.back(), kPageSize);
+    Sparse &movedSparsePage = getWritablePage(movedPage);
+
     T &targetComponent = _dense[targetIndex];
     size_t &targetEntity = _entities[targetIndex];
 
@@ -250,12 +280,11 @@ void SparseSet<T>::remove(const size_t id) noexcept
 
     _dense.pop_back();
     _entities.pop_back();
-    _sparsePages[targetPage].at(targetSparseIndex) = kNullSparseElement;
+    targetSparsePage[targetSparseIndex] = kNullSparseElement;
 
     if (targetIndex < _dense.size()) {
-        const size_t movedPage = PAGE_OF(movedEntityId, kPageSize);
         const size_t movedSparseIndex = PAGE_INDEX_OF(movedEntityId, kPageSize);
-        _sparsePages[movedPage][movedSparseIndex] = targetIndex;
+        movedSparsePage[movedSparseIndex] = targetIndex;
     }
 }
 
@@ -267,4 +296,33 @@ void SparseSet<T>::clear() noexcept
     _sparsePages.clear();
 }
 
+template <typename T>
+std::unique_ptr<ISparseSet> SparseSet<T>::clone() const
+{
+    auto copy = std::make_unique<SparseSet<T>>(getId());
+
+    copy->_dense = _dense;
+    copy->_entities = _entities;
+    copy->_sparsePages = _sparsePages;
+    return copy;
+}
+
+template <typename T>
+typename SparseSet<T>::Sparse &SparseSet<T>::getWritablePage(const size_t page)
+{
+    if (page >= _sparsePages.size()) {
+        _sparsePages.resize(page + 1);
+    }
+
+    std::shared_ptr<Sparse> &sparsePage = _sparsePages[page];
+
+    if (!sparsePage) {
+        sparsePage = std::make_shared<Sparse>();
+        sparsePage->fill(kNullSparseElement);
+    } else if (sparsePage.use_count() > 1) {
+        sparsePage = std::make_shared<Sparse>(*sparsePage);
+    }
+    return *sparsePage;
+}
+
 }  // namespace rtecs::sparse
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rtecs/types/types.hpp"
+
+namespace rtecs::spatial {
+
+/**
+ * @brief An axis-aligned bounding box.
+ *
+ * The box starts at (`x`, `y`) and extends towards positive coordinates.
+ */
+struct AABB
+{
+    float x = 0.0f;
+    float y = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+
+    /**
+     * @brief Check if two boxes overlap.
+     *
+     * @note Boxes that only share an edge do not overlap.
+     *
+     * @param other The other box
+     * @return `true` if the boxes overlap, `false` otherwise.
+     */
+    [[nodiscard]]
+    bool intersects(const AABB &other) const;
+
+    /**
+     * @brief Get the squared distance between a point and this box.
+     *
+     * @param px The x coordinate of the point
+     * @param py The y coordinate of the point
+     * @return The squared distance, or `0` if the point is inside the box.
+     */
+    [[nodiscard]]
+    float squaredDistanceTo(float px,
+                            float py) const;
+};
+
+/**
+ * @brief A uniform grid that indexes entities by their bounding box.
+ *
+ * Each entity is stored in every cell its box overlaps, so a query only visits the cells that
+ * overlap the queried area instead of every indexed entity.
+ * Moving an entity within the same cells only overwrites its box, so the index can be updated
+ * incrementally every tick.
+ *
+ * @note The cell size should be close to the size of the most common boxes: too small and big
+ * boxes span many cells, too big and the cells contain many entities.
+ */
+class SpatialGrid
+{
+public:
+    static constexpr float kDefaultCellSize = 128.0f;
+
+private:
+    /// The cells overlapped by a box, bounds included.
+    struct CellRange
+    {
+        int32_t minX;
+        int32_t minY;
+        int32_t maxX;
+        int32_t maxY;
+
+        bool operator==(const CellRange &other) const = default;
+    };
+
+    struct Entry
+    {
+        AABB bounds;
+        CellRange cells;
+    };
+
+    float _cellSize;
+    std::unordered_map<types::EntityID, Entry> _entries;
+    /// Key: Packed cell coordinates - Value: The entities overlapping this cell
+    std::unordered_map<uint64_t, std::vector<types::EntityID>> _cells;
+    /// The union of all the cells that have been occupied, used to bound the nearest search.
+    std::optional<CellRange> _occupiedCells;
+
+    [[nodiscard]]
+    static uint64_t cellKey(int32_t x,
+                            int32_t y);
+
+    [[nodiscard]]
+    int32_t cellCoordinate(float value) const;
+
+    [[nodiscard]]
+    CellRange cellRange(const AABB &bounds) const;
+
+    /**
+     * @brief Call the callback once on every entity that shares a cell with the area.
+     *
+     * @tparam TestBounds Whether the entities whose box does not overlap the area are skipped.
+     */
+    template <bool TestBounds, typename Fn>
+    void visitCells(const AABB &area,
+                    Fn &&callback) const
+    {
+        const CellRange range = cellRange(area);
+
+        for (int32_t y = range.minY; y <= range.maxY; y++) {
+            for (int32_t x = range.minX; x <= range.maxX; x++) {
+                const auto cell = _cells.find(cellKey(x, y));
+
+                if (cell == _cells.end()) {
+                    continue;
+                }
+                for (const types::EntityID entityId : cell->second) {
+                    const Entry &entry = _entries.at(entityId);
+
+                    // Only report an entity from the first cell shared by its box and the area.
+                    if (x != std::max(entry.cells.minX, range.minX) ||
+                        y != std::max(entry.cells.minY, range.minY) ||
+                        (TestBounds && !entry.bounds.intersects(area))) {
+                        continue;
+                    }
+                    if constexpr (std::is_same_v<std::invoke_result_t<Fn,
+                                                                      types::EntityID,
+                                                                      const AABB &>,
+                                                 bool>) {
+                        if (callback(entityId, entry.bounds)) {
+                            return;
+                        }
+                    } else {
+                        callback(entityId, entry.bounds);
+                    }
+                }
+            }
+        }
+    }
+
+    void insertInCells(types::EntityID entityId,
+                       const CellRange &cells);
+    void removeFromCells(types::EntityID entityId,
+                         const CellRange &cells);
+
+public:
+    explicit SpatialGrid(float cellSize = kDefaultCellSize);
+
+    /**
+     * @brief Insert an entity in the grid, or move it if it is already indexed.
+     *
+     * @param entityId The entity's ID
+     * @param bounds The bounding box of the entity
+     */
+    void update(types::EntityID entityId,
+                const AABB &bounds);
+
+    /**
+     * @brief Remove an entity from the grid.
+     *
+     * @note Nothing happens if the entity is not indexed.
+     *
+     * @param entityId The entity's ID
+     */
+    void remove(types::EntityID entityId);
+
+    /**
+     * @brief Remove every entity from the grid.
+     */
+    void clear();
+
+    /**
+     * @brief Check if an entity is indexed.
+     *
+     * @param entityId The entity's ID
+     * @return `true` if the entity is indexed, `false` otherwise.
+     */
+    [[nodiscard]]
+    bool has(types::EntityID entityId) const;
+
+    /**
+     * @brief Get the bounding box of an indexed entity.
+     *
+     * @param entityId The entity's ID
+     * @return The bounding box of the entity, or `std::nullopt` if it is not indexed.
+     */
+    [[nodiscard]]
+    std::optional<AABB> getBounds(types::EntityID entityId) const;
+
+    /**
+     * @return The number of indexed entities.
+     */
+    [[nodiscard]]
+    size_t size() const;
+
+    /**
+     * @return The size of a cell.
+     */
+    [[nodiscard]]
+    float getCellSize() const;
+
+    /**
+     * @brief Call the callback on every indexed entity whose box overlaps the area.
+     *
+     * Each entity is reported once, even if it spans multiple cells. The order of the calls is
+     * unspecified.
+     *
+     * @note If the callback returns a `bool`, returning `true` stops the query.
+     *
+     * @param area The queried area
+     * @param callback A callable taking the `types::EntityID` and the `const AABB &` of an entity.
+     */
+    template <typename Fn>
+    void queryAABB(const AABB &area,
+                   Fn &&callback) const
+    {
+        visitCells<true>(area, std::forward<Fn>(callback));
+    }
+
+    /**
+     * @brief Call the callback on every indexed entity that shares a cell with the area.
+     *
+     * Unlike `queryAABB`, the boxes are not tested against the area: this is the broadphase only,
+     * meant to be followed by a narrowphase (see `AABBBatch`).
+     *
+     * @note If the callback returns a `bool`, returning `true` stops the query.
+     *
+     * @param area The queried area
+     * @param callback A callable taking the `types::EntityID` and the `const AABB &` of an entity.
+     */
+    template <typename Fn>
+    void queryCandidates(const AABB &area,
+                         Fn &&callback) const
+    {
+        visitCells<false>(area, std::forward<Fn>(callback));
+    }
+
+    /**
+     * @brief Find the indexed entity whose box is the closest to a point.
+     *
+     * The search starts from the cell containing the point and grows ring by ring, so its cost
+     * depends on the distance to the closest entity rather than on the number of entities.
+     *
+     * @param x The x coordinate of the point
+     * @param y The y coordinate of the point
+     * @param maxDistance The maximum distance between the point and the box of the entity
+     * @return The closest entity, or `std::nullopt` if none is within `maxDistance`.
+     */
+    [[nodiscard]]
+    std::optional<types::EntityID> queryNearest(
+        float x,
+        float y,
+        float maxDistance = std::numeric_limits<float>::infinity()) const;
+};
+
+}  // namespace rtecs::spatial
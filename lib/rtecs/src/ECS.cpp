@@ -60,9 +60,91 @@ void ECS::destroyEntity(const types::EntityID entityId)
         }
     }
     _entities.erase(entityId);
+    _spatialIndex.remove(entityId);
     LOG_TRACE_R2("Destroyed entity#{}", entityId);
 }
 
+std::unique_ptr<ECS> ECS::cloneHelper(
+    const std::optional<bitset::DynamicBitSet>& componentsMask) const
+{
+    auto world = std::make_unique<ECS>();
+
+    world->_systems = _systems;
+    world->_entitiesID = _entitiesID;
+    world->_componentMaskIndex = _componentMaskIndex;
+
+    for (const auto& [componentId, set] : _components) {
+        const bitset::DynamicBitSet& mask = _componentsMasks.at(componentId);
+
+        if (componentsMask.has_value() && (mask & componentsMask.value()).none()) {
+            continue;
+        }
+        world->_componentsMasks.emplace(componentId, mask);
+        world->_components.emplace(componentId, set->clone());
+    }
+
+    if (!componentsMask.has_value() ||
+        (_spatialComponentsMask & componentsMask.value()) == _spatialComponentsMask) {
+        world->_spatialIndex = _spatialIndex;
+        world->_spatialComponentsMask = _spatialComponentsMask;
+        world->_spatialBounds = _spatialBounds;
+    }
+
+    world->_entities = _entities;
+    if (componentsMask.has_value()) {
+        for (auto& entityMask : world->_entities | std::views::values) {
+            entityMask &= componentsMask.value();
+        }
+    }
+    LOG_TRACE_R2("World cloned ({} entities, {}/{} components).",
+                 world->_entities.size(),
+                 world->_components.size(),
+                 _components.size());
+    return world;
+}
+
+void ECS::onComponentUpdated(const types::EntityID entityId,
+                             const bitset::DynamicBitSet& componentMask)
+{
+    if (_spatialBounds && (componentMask & _spatialComponentsMask).any()) {
+        refreshSpatialIndex(entityId);
+    }
+}
+
+void ECS::refreshSpatialIndex(const types::EntityID entityId)
+{
+    if (!_spatialBounds) {
+        return;
+    }
+
+    const std::optional<spatial::AABB> bounds = _spatialBounds(*this, entityId);
+
+    if (bounds.has_value()) {
+        _spatialIndex.update(entityId, bounds.value());
+    } else {
+        _spatialIndex.remove(entityId);
+    }
+}
+
+void ECS::refreshSpatialIndex()
+{
+    if (!_spatialBounds) {
+        return;
+    }
+    for (const types::EntityID entityId : _entities | std::views::keys) {
+        refreshSpatialIndex(entityId);
+    }
+}
+
+std::optional<types::EntityID> ECS::queryNearest(const float x,
+                                                 const float y,
+                                                 const float maxDistance) const
+{
+    return _spatialIndex.queryNearest(x, y, maxDistance);
+}
+
+const spatial::SpatialGrid& ECS::getSpatialIndex() const { return _spatialIndex; }
+
 void ECS::applyAllSystems()
 {
     for (const auto& system : _systems) {
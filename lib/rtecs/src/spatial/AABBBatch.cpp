@@ -0,0 +1,103 @@
+#include "rtecs/spatial/AABBBatch.hpp"
+
+#include <bit>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RTECS_AABB_BATCH_SSE
+#endif
+
+using namespace rtecs::spatial;
+
+void AABBBatch::reserve(const size_t capacity)
+{
+    _minX.reserve(capacity);
+    _minY.reserve(capacity);
+    _maxX.reserve(capacity);
+    _maxY.reserve(capacity);
+}
+
+void AABBBatch::clear()
+{
+    _minX.clear();
+    _minY.clear();
+    _maxX.clear();
+    _maxY.clear();
+}
+
+void AABBBatch::push(const AABB& box)
+{
+    _minX.push_back(box.x);
+    _minY.push_back(box.y);
+    _maxX.push_back(box.x + box.width);
+    _maxY.push_back(box.y + box.height);
+}
+
+size_t AABBBatch::size() const { return _minX.size(); }
+
+AABB AABBBatch::at(const size_t index) const
+{
+    return {_minX[index], _minY[index], _maxX[index] - _minX[index], _maxY[index] - _minY[index]};
+}
+
+std::optional<size_t> AABBBatch::firstHitScalar(const AABB& box,
+                                                const size_t from) const
+{
+    const float maxX = box.x + box.width;
+    const float maxY = box.y + box.height;
+
+    for (size_t i = from; i < size(); i++) {
+        if (box.x < _maxX[i] && maxX > _minX[i] && box.y < _maxY[i] && maxY > _minY[i]) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<size_t> AABBBatch::firstHit(const AABB& box,
+                                          const size_t from) const
+{
+    size_t i = from;
+
+#if defined(__AVX__)
+    const __m256 minX = _mm256_set1_ps(box.x);
+    const __m256 minY = _mm256_set1_ps(box.y);
+    const __m256 maxX = _mm256_set1_ps(box.x + box.width);
+    const __m256 maxY = _mm256_set1_ps(box.y + box.height);
+
+    for (; i + 8 <= size(); i += 8) {
+        const __m256 hitX =
+            _mm256_and_ps(_mm256_cmp_ps(minX, _mm256_loadu_ps(&_maxX[i]), _CMP_LT_OQ),
+                          _mm256_cmp_ps(maxX, _mm256_loadu_ps(&_minX[i]), _CMP_GT_OQ));
+        const __m256 hitY =
+            _mm256_and_ps(_mm256_cmp_ps(minY, _mm256_loadu_ps(&_maxY[i]), _CMP_LT_OQ),
+                          _mm256_cmp_ps(maxY, _mm256_loadu_ps(&_minY[i]), _CMP_GT_OQ));
+        const int mask = _mm256_movemask_ps(_mm256_and_ps(hitX, hitY));
+
+        if (mask != 0) {
+            return i + std::countr_zero(static_cast<unsigned>(mask));
+        }
+    }
+#elif defined(RTECS_AABB_BATCH_SSE)
+    const __m128 minX = _mm_set1_ps(box.x);
+    const __m128 minY = _mm_set1_ps(box.y);
+    const __m128 maxX = _mm_set1_ps(box.x + box.width);
+    const __m128 maxY = _mm_set1_ps(box.y + box.height);
+
+    for (; i + 4 <= size(); i += 4) {
+        const __m128 hitX = _mm_and_ps(_mm_cmplt_ps(minX, _mm_loadu_ps(&_maxX[i])),
+                                       _mm_cmpgt_ps(maxX, _mm_loadu_ps(&_minX[i])));
+        const __m128 hitY = _mm_and_ps(_mm_cmplt_ps(minY, _mm_loadu_ps(&_maxY[i])),
+                                       _mm_cmpgt_ps(maxY, _mm_loadu_ps(&_minY[i])));
+        const int mask = _mm_movemask_ps(_mm_and_ps(hitX, hitY));
+
+        if (mask != 0) {
+            return i + std::countr_zero(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+    // Remaining boxes (or every box when no SIMD instruction set is available).
+    return firstHitScalar(box, i);
+}
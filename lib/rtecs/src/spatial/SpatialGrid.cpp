@@ -0,0 +1,241 @@
+#include "rtecs/spatial/SpatialGrid.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "logger/Logger.h"
+
+using namespace rtecs::spatial;
+
+// =======================
+//          AABB
+// =======================
+
+bool AABB::intersects(const AABB& other) const
+{
+    return x < other.x + other.width && x + width > other.x && y < other.y + other.height &&
+           y + height > other.y;
+}
+
+float AABB::squaredDistanceTo(const float px,
+                              const float py) const
+{
+    const float dx = std::max({x - px, 0.0f, px - (x + width)});
+    const float dy = std::max({y - py, 0.0f, py - (y + height)});
+
+    return dx * dx + dy * dy;
+}
+
+// =======================
+//       SpatialGrid
+// =======================
+
+SpatialGrid::SpatialGrid(const float cellSize)
+    : _cellSize(cellSize > 0.0f ? cellSize : kDefaultCellSize)
+{
+    if (cellSize <= 0.0f) {
+        LOG_WARN("Invalid spatial grid cell size ({}), using {} instead.",
+                 cellSize,
+                 kDefaultCellSize);
+    }
+}
+
+uint64_t SpatialGrid::cellKey(const int32_t x,
+                              const int32_t y)
+{
+    return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+}
+
+int32_t SpatialGrid::cellCoordinate(const float value) const
+{
+    // Keep far away (or invalid) coordinates in a sane range so that cell ranges stay iterable.
+    constexpr float limit = 1 << 30;
+    const float cell = std::floor(value / _cellSize);
+
+    if (std::isnan(cell)) {
+        return 0;
+    }
+    return static_cast<int32_t>(std::clamp(cell, -limit, limit));
+}
+
+SpatialGrid::CellRange SpatialGrid::cellRange(const AABB& bounds) const
+{
+    return {
+        cellCoordinate(bounds.x),
+        cellCoordinate(bounds.y),
+        cellCoordinate(bounds.x + bounds.width),
+        cellCoordinate(bounds.y + bounds.height),
+    };
+}
+
+void SpatialGrid::insertInCells(const types::EntityID entityId,
+                                const CellRange& cells)
+{
+    for (int32_t y = cells.minY; y <= cells.maxY; y++) {
+        for (int32_t x = cells.minX; x <= cells.maxX; x++) {
+            _cells[cellKey(x, y)].push_back(entityId);
+        }
+    }
+
+    if (!_occupiedCells.has_value()) {
+        _occupiedCells = cells;
+        return;
+    }
+    _occupiedCells->minX = std::min(_occupiedCells->minX, cells.minX);
+    _occupiedCells->minY = std::min(_occupiedCells->minY, cells.minY);
+    _occupiedCells->maxX = std::max(_occupiedCells->maxX, cells.maxX);
+    _occupiedCells->maxY = std::max(_occupiedCells->maxY, cells.maxY);
+}
+
+void SpatialGrid::removeFromCells(const types::EntityID entityId,
+                                  const CellRange& cells)
+{
+    for (int32_t y = cells.minY; y <= cells.maxY; y++) {
+        for (int32_t x = cells.minX; x <= cells.maxX; x++) {
+            const auto cell = _cells.find(cellKey(x, y));
+
+            if (cell == _cells.end()) {
+                continue;
+            }
+            std::vector<types::EntityID>& entities = cell->second;
+            const auto it = std::ranges::find(entities, entityId);
+
+            if (it != entities.end()) {
+                *it = entities.back();
+                entities.pop_back();
+            }
+            if (entities.empty()) {
+                _cells.erase(cell);
+            }
+        }
+    }
+}
+
+void SpatialGrid::update(const types::EntityID entityId,
+                         const AABB& bounds)
+{
+    const CellRange cells = cellRange(bounds);
+    const auto it = _entries.find(entityId);
+
+    if (it == _entries.end()) {
+        _entries.emplace(entityId, Entry{bounds, cells});
+        insertInCells(entityId, cells);
+        return;
+    }
+
+    Entry& entry = it->second;
+
+    entry.bounds = bounds;
+    if (entry.cells == cells) {
+        return;
+    }
+    removeFromCells(entityId, entry.cells);
+    insertInCells(entityId, cells);
+    entry.cells = cells;
+}
+
+void SpatialGrid::remove(const types::EntityID entityId)
+{
+    const auto it = _entries.find(entityId);
+
+    if (it == _entries.end()) {
+        return;
+    }
+    removeFromCells(entityId, it->second.cells);
+    _entries.erase(it);
+    if (_entries.empty()) {
+        _occupiedCells.reset();
+    }
+}
+
+void SpatialGrid::clear()
+{
+    _entries.clear();
+    _cells.clear();
+    _occupiedCells.reset();
+}
+
+bool SpatialGrid::has(const types::EntityID entityId) const { return _entries.contains(entityId); }
+
+std::optional<AABB> SpatialGrid::getBounds(const types::EntityID entityId) const
+{
+    const auto it = _entries.find(entityId);
+
+    if (it == _entries.end()) {
+        return std::nullopt;
+    }
+    return it->second.bounds;
+}
+
+size_t SpatialGrid::size() const { return _entries.size(); }
+
+float SpatialGrid::getCellSize() const { return _cellSize; }
+
+std::optional<rtecs::types::EntityID> SpatialGrid::queryNearest(const float x,
+                                                                const float y,
+                                                                const float maxDistance) const
+{
+    if (!_occupiedCells.has_value() || maxDistance < 0.0f) {
+        return std::nullopt;
+    }
+
+    const CellRange& occupied = _occupiedCells.value();
+    const int64_t originX = cellCoordinate(x);
+    const int64_t originY = cellCoordinate(y);
+    std::optional<types::EntityID> nearest = std::nullopt;
+    float nearestDistance = maxDistance * maxDistance;
+
+    const auto visitCell = [&](const int64_t cellX, const int64_t cellY) {
+        if (cellX < occupied.minX || cellX > occupied.maxX || cellY < occupied.minY ||
+            cellY > occupied.maxY) {
+            return;
+        }
+
+        const auto cell =
+            _cells.find(cellKey(static_cast<int32_t>(cellX), static_cast<int32_t>(cellY)));
+
+        if (cell == _cells.end()) {
+            return;
+        }
+        for (const types::EntityID entityId : cell->second) {
+            const float distance = _entries.at(entityId).bounds.squaredDistanceTo(x, y);
+
+            if (distance <= nearestDistance && (!nearest.has_value() || distance < nearestDistance)) {
+                nearest = entityId;
+                nearestDistance = distance;
+            }
+        }
+    };
+
+    for (int64_t ring = 0;; ring++) {
+        // Every box first met on this ring is at least (ring - 1) cells away from the point.
+        const float ringDistance = static_cast<float>(std::max<int64_t>(ring - 1, 0)) * _cellSize;
+
+        if (ringDistance * ringDistance > nearestDistance) {
+            break;
+        }
+        if (originX - ring < occupied.minX && originX + ring > occupied.maxX &&
+            originY - ring < occupied.minY && originY + ring > occupied.maxY) {
+            break;
+        }
+
+        const int64_t minX = std::max<int64_t>(originX - ring, occupied.minX);
+        const int64_t maxX = std::min<int64_t>(originX + ring, occupied.maxX);
+
+        for (int64_t cellX = minX; cellX <= maxX; cellX++) {
+            visitCell(cellX, originY - ring);
+            if (ring != 0) {
+                visitCell(cellX, originY + ring);
+            }
+        }
+
+        const int64_t minY = std::max<int64_t>(originY - ring + 1, occupied.minY);
+        const int64_t maxY = std::min<int64_t>(originY + ring - 1, occupied.maxY);
+
+        for (int64_t cellY = minY; cellY <= maxY && ring != 0; cellY++) {
+            visitCell(originX - ring, cellY);
+            visitCell(originX + ring, cellY);
+        }
+    }
+    return nearest;
+}
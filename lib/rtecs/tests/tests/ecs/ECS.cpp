@@ -164,3 +164,86 @@ TEST_F(ECSFixture,
             }
         });
 };
+
+TEST_F(ECSFixture,
+       clone_world)
+{
+    const types::EntityID entityId = _ecs.registerEntity<Profile, Health, Hitbox>(
+        {"", "L1x", 20}, {20}, {10, 10, 5, 5});
+
+    const std::unique_ptr<ECS> world = _ecs.clone();
+
+    ASSERT_NE(world, nullptr);
+    EXPECT_EQ(world->getEntityMask(entityId), _ecs.getEntityMask(entityId));
+
+    const types::OptionalRef<Health> health = world->getEntityComponent<Health>(entityId);
+    ASSERT_TRUE(health.has_value());
+    EXPECT_EQ(health.value().get().health, 20);
+
+    const types::EntityID newEntityId = world->registerEntity<Health>({42});
+    EXPECT_NE(newEntityId, entityId);
+}
+
+TEST_F(ECSFixture,
+       clone_world_is_independent)
+{
+    const types::EntityID entityId = _ecs.registerEntity<Profile, Health>({"", "L1x", 20}, {20});
+
+    const std::unique_ptr<ECS> world = _ecs.clone();
+
+    EXPECT_TRUE(world->updateEntity<Health>(entityId, {5}));
+    EXPECT_EQ(_ecs.getEntityComponent<Health>(entityId).value().get().health, 20);
+    EXPECT_EQ(world->getEntityComponent<Health>(entityId).value().get().health, 5);
+
+    _ecs.destroyEntity(entityId);
+    EXPECT_FALSE(_ecs.getEntityComponent<Health>(entityId).has_value());
+    EXPECT_TRUE(world->getEntityComponent<Health>(entityId).has_value());
+}
+
+TEST_F(ECSFixture,
+       clone_component_subset)
+{
+    const types::EntityID entityId = _ecs.registerEntity<Profile, Health>({"", "L1x", 20}, {20});
+
+    const std::unique_ptr<ECS> world = _ecs.clone<Health>();
+
+    EXPECT_EQ(world->getEntityMask(entityId), _ecs.getComponentMask<Health>());
+    EXPECT_TRUE(world->getEntityComponent<Health>(entityId).has_value());
+    EXPECT_FALSE(world->getEntityComponent<Profile>(entityId).has_value());
+}
+
+TEST_F(ECSFixture,
+       spatial_index_tracks_entities)
+{
+    _ecs.registerSpatialIndex<Hitbox, Health>(
+        [](const Hitbox &box, const Health &) -> spatial::AABB {
+            return {static_cast<float>(box.x),
+                    static_cast<float>(box.y),
+                    static_cast<float>(box.width),
+                    static_cast<float>(box.height)};
+        },
+        64.0f);
+
+    const types::EntityID entityId = _ecs.registerEntity<Hitbox, Health>({5000, 5000, 10, 10}, {1});
+    const types::EntityID withoutHealth = _ecs.registerEntity<Hitbox>({5000, 5000, 10, 10});
+
+    EXPECT_TRUE(_ecs.getSpatialIndex().has(entityId));
+    EXPECT_FALSE(_ecs.getSpatialIndex().has(withoutHealth));
+    EXPECT_EQ(_ecs.queryNearest(4000, 4000), entityId);
+
+    std::vector<types::EntityID> found;
+    _ecs.queryAABB({4990, 4990, 20, 20}, [&](const types::EntityID id, const spatial::AABB &) {
+        found.push_back(id);
+    });
+    EXPECT_EQ(found, std::vector<types::EntityID>{entityId});
+
+    EXPECT_TRUE(_ecs.updateEntity<Hitbox>(entityId, {-5000, -5000, 10, 10}));
+    EXPECT_EQ(_ecs.getSpatialIndex().getBounds(entityId)->x, -5000);
+
+    _ecs.getEntityComponent<Hitbox>(entityId).value().get().x = 7000;
+    _ecs.refreshSpatialIndex(entityId);
+    EXPECT_EQ(_ecs.getSpatialIndex().getBounds(entityId)->x, 7000);
+
+    _ecs.destroyEntity(entityId);
+    EXPECT_FALSE(_ecs.getSpatialIndex().has(entityId));
+}
@@ -187,3 +187,36 @@ TEST(SparseSet,
     sparseSet.remove(2);
     ASSERT_FALSE(sparseSet.has(2));
 }
+
+TEST(SparseSet,
+     clone_is_independent)
+{
+    struct MyComponent
+    {
+        std::string name;
+        int age;
+    };
+
+    rtecs::sparse::SparseSet<MyComponent> sparseSet(0);
+
+    for (int id = 0; id < 10; id++) {
+        sparseSet.put(id, {.name = "", .age = id});
+    }
+
+    const std::unique_ptr<rtecs::sparse::ISparseSet> clone = sparseSet.clone();
+    auto &clonedSet = dynamic_cast<rtecs::sparse::SparseSet<MyComponent> &>(*clone);
+
+    ASSERT_EQ(clonedSet.size(), sparseSet.size());
+    ASSERT_EQ(clonedSet.getEntities(), sparseSet.getEntities());
+
+    clonedSet.remove(2);
+    clonedSet.put(4, {.name = "", .age = 42});
+    sparseSet.put(5000, {.name = "", .age = 5000});
+
+    EXPECT_TRUE(sparseSet.has(2));
+    EXPECT_FALSE(clonedSet.has(2));
+    EXPECT_EQ(sparseSet.get(4).value().get().age, 4);
+    EXPECT_EQ(clonedSet.get(4).value().get().age, 42);
+    EXPECT_FALSE(clonedSet.has(5000));
+    EXPECT_EQ(clonedSet.get(9).value().get().age, 9);
+}
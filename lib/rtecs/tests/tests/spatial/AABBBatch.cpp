@@ -0,0 +1,69 @@
+#include "rtecs/spatial/AABBBatch.hpp"
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace rtecs::spatial;
+
+TEST(AABBBatch,
+     first_hit_index)
+{
+    AABBBatch batch;
+
+    for (int i = 0; i < 20; i++) {
+        batch.push({static_cast<float>(i * 100), 0, 50, 50});
+    }
+
+    EXPECT_EQ(batch.firstHit({1210, 10, 10, 10}), 12);
+    EXPECT_EQ(batch.firstHit({0, 0, 2000, 10}), 0);
+    EXPECT_EQ(batch.firstHit({0, 0, 2000, 10}, 13), 13);
+    EXPECT_FALSE(batch.firstHit({1260, 10, 10, 10}).has_value());
+    EXPECT_FALSE(batch.firstHit({0, 0, 2000, 10}, 20).has_value());
+}
+
+TEST(AABBBatch,
+     touching_edges_do_not_hit)
+{
+    AABBBatch batch;
+
+    batch.push({0, 0, 50, 50});
+
+    EXPECT_FALSE(batch.firstHit({50, 0, 10, 10}).has_value());
+    EXPECT_FALSE(batch.firstHit({0, -10, 10, 10}).has_value());
+    EXPECT_EQ(batch.firstHit({49, 0, 10, 10}), 0);
+}
+
+TEST(AABBBatch,
+     clear_keeps_nothing)
+{
+    AABBBatch batch;
+
+    batch.push({0, 0, 50, 50});
+    batch.clear();
+
+    EXPECT_EQ(batch.size(), 0);
+    EXPECT_FALSE(batch.firstHit({0, 0, 50, 50}).has_value());
+}
+
+TEST(AABBBatch,
+     matches_scalar_fallback)
+{
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> coordinate(0.0f, 1000.0f);
+    std::uniform_real_distribution<float> size(1.0f, 60.0f);
+
+    for (size_t count : {1, 3, 4, 7, 8, 9, 15, 16, 17, 64, 257}) {
+        AABBBatch batch;
+
+        for (size_t i = 0; i < count; i++) {
+            batch.push({coordinate(rng), coordinate(rng), size(rng), size(rng)});
+        }
+        for (int query = 0; query < 200; query++) {
+            const AABB box = {coordinate(rng), coordinate(rng), size(rng) * 3, size(rng) * 3};
+            const size_t from = query % 5;
+
+            EXPECT_EQ(batch.firstHit(box, from), batch.firstHitScalar(box, from));
+        }
+    }
+}
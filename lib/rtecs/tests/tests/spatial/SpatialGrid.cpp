@@ -0,0 +1,182 @@
+#include "rtecs/spatial/SpatialGrid.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+
+using namespace rtecs::spatial;
+using rtecs::types::EntityID;
+
+static std::vector<EntityID> queryAll(const SpatialGrid &grid,
+                                      const AABB &area)
+{
+    std::vector<EntityID> entities;
+
+    grid.queryAABB(area, [&](const EntityID entityId, const AABB &) {
+        entities.push_back(entityId);
+    });
+    std::ranges::sort(entities);
+    return entities;
+}
+
+TEST(SpatialGrid,
+     query_overlapping_entities)
+{
+    SpatialGrid grid(100.0f);
+
+    grid.update(0, {10, 10, 20, 20});
+    grid.update(1, {150, 150, 20, 20});
+    grid.update(2, {500, 500, 20, 20});
+
+    EXPECT_EQ(queryAll(grid, {0, 0, 200, 200}), (std::vector<EntityID>{0, 1}));
+    EXPECT_EQ(queryAll(grid, {25, 25, 10, 10}), (std::vector<EntityID>{0}));
+    EXPECT_TRUE(queryAll(grid, {300, 300, 100, 100}).empty());
+}
+
+TEST(SpatialGrid,
+     query_reports_multi_cell_entity_once)
+{
+    SpatialGrid grid(10.0f);
+
+    grid.update(0, {0, 0, 95, 95});
+
+    EXPECT_EQ(queryAll(grid, {-50, -50, 200, 200}), (std::vector<EntityID>{0}));
+    EXPECT_EQ(queryAll(grid, {42, 42, 30, 30}), (std::vector<EntityID>{0}));
+}
+
+TEST(SpatialGrid,
+     query_ignores_touching_edges)
+{
+    SpatialGrid grid(100.0f);
+
+    grid.update(0, {0, 0, 50, 50});
+
+    EXPECT_TRUE(queryAll(grid, {50, 0, 50, 50}).empty());
+    EXPECT_EQ(queryAll(grid, {49, 0, 50, 50}), (std::vector<EntityID>{0}));
+}
+
+TEST(SpatialGrid,
+     query_stops_when_callback_returns_true)
+{
+    SpatialGrid grid(100.0f);
+    size_t calls = 0;
+
+    for (EntityID id = 0; id < 10; id++) {
+        grid.update(id, {10, 10, 10, 10});
+    }
+    grid.queryAABB({0, 0, 100, 100}, [&](EntityID, const AABB &) {
+        calls++;
+        return true;
+    });
+    EXPECT_EQ(calls, 1);
+}
+
+TEST(SpatialGrid,
+     update_moves_entity)
+{
+    SpatialGrid grid(100.0f);
+
+    grid.update(0, {10, 10, 10, 10});
+    grid.update(0, {20, 20, 10, 10});
+    ASSERT_TRUE(grid.getBounds(0).has_value());
+    EXPECT_EQ(grid.getBounds(0)->x, 20);
+
+    grid.update(0, {1000, 1000, 10, 10});
+    EXPECT_EQ(grid.size(), 1);
+    EXPECT_TRUE(queryAll(grid, {0, 0, 100, 100}).empty());
+    EXPECT_EQ(queryAll(grid, {990, 990, 50, 50}), (std::vector<EntityID>{0}));
+}
+
+TEST(SpatialGrid,
+     remove_entity)
+{
+    SpatialGrid grid(100.0f);
+
+    grid.update(0, {10, 10, 10, 10});
+    grid.update(1, {10, 10, 10, 10});
+    grid.remove(0);
+    grid.remove(42);
+
+    EXPECT_FALSE(grid.has(0));
+    EXPECT_TRUE(grid.has(1));
+    EXPECT_EQ(queryAll(grid, {0, 0, 100, 100}), (std::vector<EntityID>{1}));
+
+    grid.clear();
+    EXPECT_EQ(grid.size(), 0);
+    EXPECT_TRUE(queryAll(grid, {0, 0, 100, 100}).empty());
+}
+
+TEST(SpatialGrid,
+     nearest_entity)
+{
+    SpatialGrid grid(50.0f);
+
+    grid.update(0, {1000, 0, 10, 10});
+    grid.update(1, {-300, -300, 10, 10});
+    grid.update(2, {200, 0, 10, 10});
+
+    EXPECT_EQ(grid.queryNearest(0, 0), 2);
+    EXPECT_EQ(grid.queryNearest(-200, -200), 1);
+    EXPECT_EQ(grid.queryNearest(5000, 5000), 0);
+    EXPECT_EQ(grid.queryNearest(205, 5), 2);
+}
+
+TEST(SpatialGrid,
+     nearest_entity_within_distance)
+{
+    SpatialGrid grid(50.0f);
+
+    grid.update(0, {200, 0, 10, 10});
+
+    EXPECT_FALSE(grid.queryNearest(0, 0, 100.0f).has_value());
+    EXPECT_EQ(grid.queryNearest(0, 0, 200.0f), 0);
+    EXPECT_FALSE(SpatialGrid().queryNearest(0, 0).has_value());
+}
+
+TEST(SpatialGrid,
+     nearest_entity_matches_brute_force)
+{
+    SpatialGrid grid(32.0f);
+    std::vector<AABB> boxes;
+
+    for (int i = 0; i < 200; i++) {
+        const AABB box = {static_cast<float>((i * 7919) % 1920),
+                          static_cast<float>((i * 104729) % 1080),
+                          static_cast<float>(5 + i % 40),
+                          static_cast<float>(5 + i % 25)};
+
+        boxes.push_back(box);
+        grid.update(i, box);
+    }
+    for (int i = 0; i < 50; i++) {
+        const float x = static_cast<float>((i * 1237) % 2200) - 100;
+        const float y = static_cast<float>((i * 4391) % 1300) - 100;
+        float expected = std::numeric_limits<float>::infinity();
+
+        for (const AABB &box : boxes) {
+            expected = std::min(expected, box.squaredDistanceTo(x, y));
+        }
+
+        const std::optional<EntityID> nearest = grid.queryNearest(x, y);
+
+        ASSERT_TRUE(nearest.has_value());
+        EXPECT_FLOAT_EQ(boxes[nearest.value()].squaredDistanceTo(x, y), expected);
+    }
+}
+
+TEST(SpatialGrid,
+     candidates_share_a_cell)
+{
+    SpatialGrid grid(100.0f);
+    std::vector<EntityID> candidates;
+
+    grid.update(0, {10, 10, 10, 10});
+    grid.update(1, {80, 80, 10, 10});
+    grid.update(2, {250, 250, 10, 10});
+
+    grid.queryCandidates({0, 0, 30, 30}, [&](const EntityID entityId, const AABB &) {
+        candidates.push_back(entityId);
+    });
+    std::ranges::sort(candidates);
+    EXPECT_EQ(candidates, (std::vector<EntityID>{0, 1}));
+}
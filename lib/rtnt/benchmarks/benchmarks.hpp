@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+
+#include "rtnt/core/packet.hpp"
+#include "rtnt/core/peer.hpp"
+
+/// I/O backends compared by the benchmarks. Unsupported ones fall back to another backend.
+inline constexpr std::array BACKENDS = {rtnt::core::Peer::IoBackend::kAsio,
+                                        rtnt::core::Peer::IoBackend::kBatched,
+                                        rtnt::core::Peer::IoBackend::kIoUring};
+
+inline const char* getBackendName(const rtnt::core::Peer::IoBackend backend)
+{
+    switch (backend) {
+        case rtnt::core::Peer::IoBackend::kAsio:
+            return "asio";
+        case rtnt::core::Peer::IoBackend::kBatched:
+            return "batched";
+        case rtnt::core::Peer::IoBackend::kIoUring:
+            return "io_uring";
+    }
+    return "?";
+}
+
+/**
+ * @brief Builds a valid unreliable datagram.
+ */
+inline rtnt::core::ByteBuffer makeDatagram(const rtnt::core::packet::SequenceId sequenceId,
+                                           const size_t payloadSize)
+{
+    using namespace rtnt::core;
+
+    packet::Header header{};
+
+    header.sequenceId = sequenceId;
+    header.channelId = packet::DEFAULT_CHANNEL_ID;
+    header.messageId = 128;
+    header.packetSize = static_cast<uint16_t>(payloadSize);
+    header.convertEndianness();
+
+    ByteBuffer datagram(sizeof(packet::Header) + payloadSize, 0x2A);
+    std::memcpy(datagram.data(), &header, sizeof(packet::Header));
+    return datagram;
+}
+
+/**
+ * @brief Floods a single Peer and measures how many datagrams it handles per second.
+ */
+void runReceiveBenchmark();
+
+/**
+ * @brief Runs an echo server for many sessions over loopback, and compares the I/O backends.
+ */
+void runLoopbackBenchmark();
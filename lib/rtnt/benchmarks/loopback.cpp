@@ -0,0 +1,197 @@
+#include <asio/io_context.hpp>
+#include <asio/ip/udp.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include "benchmarks.hpp"
+#include "rtnt/core/peer.hpp"
+#include "rtnt/core/session.hpp"
+
+using namespace rtnt::core;
+
+namespace {
+
+/**
+ * @brief Echoes every received packet to its sender, through one Session per remote endpoint (like
+ *        a Server, without the handshake).
+ */
+class Echo final : public Peer
+{
+public:
+    explicit Echo(asio::io_context& context)
+        : Peer(context)
+    {
+        server(0);
+    }
+
+    std::atomic<uint64_t> packets = 0;
+    std::chrono::steady_clock::time_point first;
+    std::atomic<std::chrono::steady_clock::rep> last = 0;
+
+    [[nodiscard]] size_t getSessionCount() const { return _sessions.size(); }
+
+protected:
+    void onReceive(const udp::endpoint& sender,
+                   rtnt::PooledBuffer data) override
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        if (packets.load(std::memory_order_relaxed) == 0) {
+            first = now;
+        }
+
+        auto it = _sessions.find(sender);
+
+        if (it == _sessions.end()) {
+            auto sendFunction = [this, sender](std::shared_ptr<ByteBuffer> datagram) {
+                sendToTarget(sender, std::move(datagram));
+            };
+
+            it = _sessions.emplace(sender, std::make_unique<Session>(sender, sendFunction)).first;
+        }
+
+        const std::vector<Packet> received = it->second->handleIncoming(data);
+
+        for (const Packet& packet : received) {
+            Packet reply(packet.getId(), packet::Flag::kUnreliable, packet::DEFAULT_CHANNEL_ID);
+
+            reply << static_cast<uint32_t>(packets.load(std::memory_order_relaxed));
+            it->second->send(reply);
+        }
+        it->second->flush();
+        packets.fetch_add(received.size(), std::memory_order_relaxed);
+        last.store(now.time_since_epoch().count(), std::memory_order_release);
+    }
+
+private:
+    std::map<udp::endpoint, std::unique_ptr<Session>> _sessions;
+};
+
+/**
+ * @return The CPU time consumed by the calling thread, in seconds.
+ */
+double getThreadCpuTime()
+{
+    timespec time{};
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) / 1e9;
+}
+
+/**
+ * @return The CPU time consumed by the whole process, in seconds.
+ */
+double getProcessCpuTime()
+{
+    timespec time{};
+
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time);
+    return static_cast<double>(time.tv_sec) + static_cast<double>(time.tv_nsec) / 1e9;
+}
+
+/**
+ * @brief Floods an Echo Peer from many client sockets (one Session each) and measures its
+ *        throughput and CPU cost.
+ *
+ * The CPU time per packet is the CPU time of the whole process minus the one of the sending
+ * threads, divided by the number of packets the Echo Peer handled (each one being received, then
+ * answered). Datagrams the Peer was too slow to read are dropped by the kernel and not counted.
+ */
+void measure(const Peer::IoBackend backend,
+             const size_t sessionCount)
+{
+    constexpr size_t datagramCount = 1 << 18;
+    constexpr size_t burstSize = 16;  ///< Datagrams sent in a row by a client socket.
+    const size_t senderCount = std::min<size_t>(4, sessionCount);
+
+    asio::io_context context;
+    Echo echo(context);
+
+    echo.setIoBackend(backend);
+    echo.start();
+    std::thread ioThread([&context]() { context.run(); });
+
+    asio::io_context senderContext;
+    std::vector<udp::socket> sockets;
+    const udp::endpoint target(asio::ip::make_address("127.0.0.1"), echo.getLocalPort());
+    std::vector<packet::SequenceId> sequenceIds(sessionCount, 0);
+
+    sockets.reserve(sessionCount);
+    for (size_t i = 0; i < sessionCount; i++) {
+        sockets.emplace_back(senderContext, udp::endpoint(udp::v4(), 0));
+    }
+
+    std::atomic<double> senderCpuTime = 0.0;
+    std::vector<std::thread> senders;
+    const double cpuTimeBefore = getProcessCpuTime();
+
+    for (size_t s = 0; s < senderCount; s++) {
+        senders.emplace_back([&, s]() {
+            const double start = getThreadCpuTime();
+            size_t sent = 0;
+
+            // Each sender owns every senderCount-th socket.
+            while (sent < datagramCount / senderCount) {
+                for (size_t i = s; i < sessionCount; i += senderCount) {
+                    for (size_t b = 0; b < burstSize; b++) {
+                        // Sessions drop duplicates, so each datagram needs its own sequence ID.
+                        const ByteBuffer datagram = makeDatagram(++sequenceIds[i], 64);
+
+                        sockets[i].send_to(asio::buffer(datagram), target);
+                    }
+                    sent += burstSize;
+                }
+            }
+            senderCpuTime.fetch_add(getThreadCpuTime() - start);
+        });
+    }
+    for (auto& sender : senders) {
+        sender.join();
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));  // Let the Peer drain its socket.
+
+    const double cpuTime = getProcessCpuTime() - cpuTimeBefore - senderCpuTime.load();
+
+    context.stop();
+    ioThread.join();
+
+    const uint64_t handled = echo.packets.load();
+    const std::chrono::steady_clock::time_point last{
+        std::chrono::steady_clock::duration(echo.last.load(std::memory_order_acquire))};
+    const double elapsed = std::chrono::duration<double>(last - echo.first).count();
+    const auto& metrics = echo.getNetworkMetrics();
+
+    std::printf("%8s %10zu %10zu %12llu %14.0f %14.2f %12.1f\n",
+                getBackendName(echo.getIoBackend()),
+                sessionCount,
+                echo.getSessionCount(),
+                static_cast<unsigned long long>(handled),
+                static_cast<double>(handled) / elapsed,
+                cpuTime * 1e6 / static_cast<double>(std::max<uint64_t>(handled, 1)),
+                static_cast<double>(metrics.totalPacketsSent.load()) /
+                    static_cast<double>(std::max<uint64_t>(metrics.totalSendCalls.load(), 1)));
+}
+
+}  // namespace
+
+void runLoopbackBenchmark()
+{
+    std::printf("%8s %10s %10s %12s %14s %14s %12s\n",
+                "backend",
+                "sessions",
+                "reached",
+                "handled",
+                "packets/s",
+                "CPU us/packet",
+                "sent/call");
+    for (const auto backend : BACKENDS) {
+        for (const size_t sessionCount : {1, 64, 1024}) {
+            measure(backend, sessionCount);
+        }
+    }
+}
@@ -0,0 +1,22 @@
+#include <cstdio>
+#include <string_view>
+
+#include "benchmarks.hpp"
+
+int main(int argc,
+         char** argv)
+{
+    const std::string_view name = argc > 1 ? argv[1] : "";
+
+    if (!name.empty() && name != "receive" && name != "loopback") {
+        std::printf("Usage: %s [receive|loopback]\n", argv[0]);
+        return 1;
+    }
+    if (name.empty() || name == "receive") {
+        runReceiveBenchmark();
+    }
+    if (name.empty() || name == "loopback") {
+        runLoopbackBenchmark();
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <asio/io_context.hpp>
+#include <asio/ip/udp.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "benchmarks.hpp"
+#include "rtnt/core/peer.hpp"
+#include "rtnt/core/session.hpp"
+
+using namespace rtnt::core;
+
+/**
+ * @brief Peer that runs every received datagram through a Session, then drops the packets.
+ */
+class Sink final : public Peer
+{
+public:
+    explicit Sink(asio::io_context& context)
+        : Peer(context),
+          _session(udp::endpoint{}, nullptr)
+    {
+        server(0);
+    }
+
+    std::atomic<uint64_t> packets = 0;
+    std::chrono::steady_clock::time_point first;
+    std::atomic<std::chrono::steady_clock::rep> last = 0;
+
+protected:
+    void onReceive(const udp::endpoint& /*sender*/,
+                   rtnt::PooledBuffer data) override
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        if (packets.load(std::memory_order_relaxed) == 0) {
+            first = now;
+        }
+        packets.fetch_add(_session.handleIncoming(data).size(), std::memory_order_relaxed);
+        last.store(now.time_since_epoch().count(), std::memory_order_release);
+    }
+
+private:
+    Session _session;
+};
+
+/**
+ * @brief Measure the number of packets the Peer handles per second while being flooded.
+ *
+ * The rate is measured on the receiving side, between the first and the last handled packet.
+ * Datagrams the Peer was too slow to read are dropped by the kernel and not counted.
+ */
+static void measure(const Peer::IoBackend backend,
+                    const size_t payloadSize)
+{
+    constexpr size_t datagramCount = 1 << 18;
+
+    asio::io_context context;
+    Sink sink(context);
+
+    sink.setIoBackend(backend);
+    sink.start();
+    std::thread ioThread([&context]() { context.run(); });
+
+    std::vector<ByteBuffer> datagrams;
+    datagrams.reserve(datagramCount);
+    for (size_t i = 0; i < datagramCount; i++) {
+        datagrams.push_back(makeDatagram(static_cast<packet::SequenceId>(i), payloadSize));
+    }
+
+    asio::io_context senderContext;
+    udp::socket sender(senderContext, udp::endpoint(udp::v4(), 0));
+    const udp::endpoint target(asio::ip::make_address("127.0.0.1"), sink.getLocalPort());
+
+    for (const ByteBuffer& datagram : datagrams) {
+        sender.send_to(asio::buffer(datagram), target);
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));  // Let the Peer drain its socket.
+
+    context.stop();
+    ioThread.join();
+
+    const uint64_t sent = datagrams.size();
+    const uint64_t received = sink.packets.load();
+    const std::chrono::steady_clock::time_point last{
+        std::chrono::steady_clock::duration(sink.last.load(std::memory_order_acquire))};
+    const double elapsed = std::chrono::duration<double>(last - sink.first).count();
+
+    std::printf("%8s %12zu %12llu %12llu %14.0f %12.1f %14llu\n",
+                getBackendName(sink.getIoBackend()),
+                payloadSize,
+                static_cast<unsigned long long>(sent),
+                static_cast<unsigned long long>(received),
+                static_cast<double>(received) / elapsed,
+                static_cast<double>(sink.getNetworkMetrics().totalPacketsReceived.load()) /
+                    static_cast<double>(sink.getNetworkMetrics().totalReceiveCalls.load()),
+                static_cast<unsigned long long>(
+                    sink.getNetworkMetrics().receptionPoolMisses.load()));
+}
+
+void runReceiveBenchmark()
+{
+    std::printf("%8s %12s %12s %12s %14s %12s %14s\n",
+                "backend",
+                "payload (B)",
+                "sent",
+                "handled",
+                "packets/s",
+                "per call",
+                "pool misses");
+    for (const auto backend : BACKENDS) {
+        for (const size_t payloadSize : {0, 64, 512, 1200}) {
+            measure(backend, payloadSize);
+        }
+    }
+}
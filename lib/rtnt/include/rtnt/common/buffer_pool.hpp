@@ -0,0 +1,176 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace rtnt {
+
+class BufferPool;
+
+/**
+ * @class   PooledBuffer
+ * @brief   Reference-counted handle to a fixed-size buffer owned by a @code BufferPool@endcode.
+ *
+ * Copying a PooledBuffer only increments the (intrusive) reference count of the underlying block.
+ * The block goes back to its pool when the last handle referencing it is destroyed.
+ * Each handle sees a window (offset and size) of the block, so a block holding several datagrams
+ * can be split with @code slice@endcode without copying it.
+ *
+ * @note    Handles can be copied and destroyed from any thread.
+ * @warning The content of the buffer is not synchronized: it must not be written once shared.
+ */
+class PooledBuffer final
+{
+public:
+    PooledBuffer() = default;
+    PooledBuffer(const PooledBuffer& other);
+    PooledBuffer(PooledBuffer&& other) noexcept;
+    PooledBuffer& operator=(const PooledBuffer& other);
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept;
+    ~PooledBuffer();
+
+    /**
+     * @return  A pointer to the first byte of the buffer.
+     */
+    [[nodiscard]] uint8_t* data();
+    [[nodiscard]] const uint8_t* data() const;
+
+    /**
+     * @return  The number of meaningful bytes in the buffer (@code 0@endcode by default).
+     */
+    [[nodiscard]] size_t size() const { return _size; }
+
+    /**
+     * @brief   Sets the number of meaningful bytes in the buffer.
+     * @param   size    New size, clamped to @code capacity()@endcode
+     */
+    void resize(size_t size);
+
+    /**
+     * @return  The maximum number of bytes the buffer can hold.
+     */
+    [[nodiscard]] size_t capacity() const;
+
+    /**
+     * @brief   Creates a handle on a part of this buffer, sharing the same block.
+     * @param   offset  Offset of the part, clamped to @code size()@endcode
+     * @param   size    Size of the part, clamped to what remains after @code offset@endcode
+     * @return  The new handle.
+     */
+    [[nodiscard]] PooledBuffer slice(size_t offset,
+                                     size_t size) const;
+
+    /**
+     * @return  A read-only view of the meaningful bytes of the buffer.
+     */
+    [[nodiscard]] std::span<const uint8_t> view() const;
+
+    /**
+     * @return  @code true@endcode if the buffer comes from the pool, @code false@endcode if it had
+     *          to be allocated because the pool was exhausted.
+     */
+    [[nodiscard]] bool isPooled() const;
+
+    explicit operator bool() const { return _block != nullptr; }
+
+private:
+    friend class BufferPool;
+
+    struct Block;
+
+    Block* _block = nullptr;
+    size_t _offset = 0;
+    size_t _size = 0;
+
+    explicit PooledBuffer(Block* block)
+        : _block(block)
+    {
+    }
+
+    void release();
+};
+
+/**
+ * @class   BufferPool
+ * @brief   Lock-free pool of fixed-size buffers, mainly used to receive datagrams without
+ *          allocating.
+ *
+ * All the buffers are allocated once, in a single contiguous block. Free buffers are kept in a
+ * lock-free stack (tagged index, to avoid the ABA problem), so that @code acquire@endcode and the
+ * release of a buffer never lock nor allocate.
+ * If the pool is exhausted, @code acquire@endcode falls back to a heap allocated buffer, which is
+ * freed instead of being given back to the pool.
+ *
+ * The pool stays alive as long as its owner or any of its buffers does, so buffers can safely
+ * outlive the Peer that received them.
+ */
+class BufferPool final
+{
+    struct OwnerRelease
+    {
+        void operator()(BufferPool* pool) const;
+    };
+
+public:
+    using Ptr = std::unique_ptr<BufferPool, OwnerRelease>;
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    /**
+     * @brief   Creates a pool.
+     * @param   bufferCount Number of buffers in the pool
+     * @param   bufferSize  Size of each buffer, in bytes
+     * @return  The owning handle of the pool.
+     */
+    static Ptr create(size_t bufferCount,
+                      size_t bufferSize);
+
+    /**
+     * @brief   Takes a free buffer from the pool, or allocates one if the pool is exhausted.
+     * @return  A buffer of @code getBufferSize()@endcode bytes, with a size of @code 0@endcode.
+     */
+    [[nodiscard]] PooledBuffer acquire();
+
+    [[nodiscard]] size_t getBufferCount() const { return _bufferCount; }
+    [[nodiscard]] size_t getBufferSize() const { return _bufferSize; }
+
+    /**
+     * @return  The number of buffers that had to be allocated because the pool was exhausted.
+     */
+    [[nodiscard]] uint64_t getMissCount() const { return _misses.load(std::memory_order_relaxed); }
+
+private:
+    friend class PooledBuffer;
+
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    const size_t _bufferCount;
+    const size_t _bufferSize;
+
+    std::unique_ptr<PooledBuffer::Block[]> _blocks;
+    std::unique_ptr<uint8_t[]> _storage;
+
+    /// Head of the free stack: the tag in the high 32 bits, the index of the block in the low ones.
+    std::atomic<uint64_t> _freeHead;
+
+    /// The owner plus every buffer in use. The pool is deleted when it reaches 0.
+    std::atomic<size_t> _references = 1;
+
+    std::atomic<uint64_t> _misses = 0;
+
+    BufferPool(size_t bufferCount,
+               size_t bufferSize);
+    ~BufferPool();
+
+    void push(uint32_t index);
+    uint32_t pop();
+
+    void giveBack(PooledBuffer::Block* block);
+    void unreference();
+};
+
+}  // namespace rtnt
@@ -15,7 +15,22 @@ static constexpr uint16_t PROTOCOL_ID = 0x2204;
 
 /// @brief      Version of the protocol (@code rtntp@endcode).
 /// @warning    Changing this is considered as a breaking change.
-static constexpr uint16_t PROTOCOL_VER = 0x0003;
+static constexpr uint16_t PROTOCOL_VER = 0x0007;
+
+/// @brief  First protocol version packing several messages in a datagram (@code BUNDLE@endcode).
+static constexpr uint16_t BUNDLE_PROTOCOL_VER = 0x0004;
+
+/// @brief  First protocol version encoding @code RICH_ACK@endcode as selective acknowledgement
+///         blocks (instead of a list of Sequence IDs).
+static constexpr uint16_t SACK_PROTOCOL_VER = 0x0005;
+
+/// @brief  First protocol version splitting messages too large for a datagram into fragments
+///         (@code FRAGMENT@endcode).
+static constexpr uint16_t FRAGMENT_PROTOCOL_VER = 0x0006;
+
+/// @brief  First protocol version probing the path MTU after the handshake (@code PROBE@endcode),
+///         and sizing its datagrams after it.
+static constexpr uint16_t PMTU_PROTOCOL_VER = 0x0007;
 
 /// @brief  Maximum number of times a client will attempt a connection to a remote server. After
 /// reaching that number, it will just give up.
@@ -28,6 +43,66 @@ namespace core {
 
 using ByteBuffer = std::vector<uint8_t>;
 
+/// @brief  Maximum number of datagrams read by a single @code recvmmsg@endcode call (batched I/O
+///         backend). The Peer keeps that many reception buffers out of the pool.
+static constexpr size_t RECEIVE_BATCH_SIZE = 16;
+
+/// @brief  Number of full-size reception buffers each Peer allocates up front: the ones a
+///         @code recvmmsg@endcode call fills, plus the one being handled. A datagram is copied out
+///         of its reception buffer as soon as it is received (cf.
+///         @code DATAGRAM_BUFFER_SIZE@endcode), so these are only held by the receive calls.
+static constexpr size_t RECEPTION_POOL_SIZE = RECEIVE_BATCH_SIZE + 1;
+
+/// @brief  Size of the buffers received datagrams are copied into, so that the packets waiting to
+///         be handled (event queue, reorder buffers) do not hold a full-size reception buffer each.
+///         Larger datagrams keep their reception buffer. Must fit a datagram of the largest probed
+///         path MTU (cf. @code packet::MAX_PROBE_SIZE@endcode).
+static constexpr size_t DATAGRAM_BUFFER_SIZE = 2048;
+
+/// @brief  Number of datagram buffers each Peer allocates up front. Received packets keep their
+///         buffer until they are handled, so this bounds the number of datagrams in flight between
+///         the I/O thread and the main thread before the Peer has to allocate.
+static constexpr size_t DATAGRAM_POOL_SIZE = 256;
+
+/// @brief  Maximum number of datagrams sent by a single @code sendmmsg@endcode call (batched I/O
+///         backend).
+static constexpr size_t SEND_BATCH_SIZE = 64;
+
+/// @brief  Maximum number of datagrams merged in a single segmented send (UDP GSO). The kernel
+///         refuses more than 64 segments.
+static constexpr size_t MAX_GSO_SEGMENTS = 64;
+
+/// @brief  Maximum size of a datagram sent through UDP GSO: the IPv4 UDP payload that fits in a
+///         1500 bytes MTU. Larger datagrams are sent on their own.
+static constexpr size_t MAX_GSO_SEGMENT_SIZE = 1472;
+
+/// @brief  Number of submission queue entries of a Peer's io_uring (io_uring I/O backend). This is
+///         also the maximum number of sends in flight: datagrams that do not fit are handed to asio.
+static constexpr unsigned URING_SUBMISSION_ENTRIES = 256;
+
+/// @brief  Number of completion queue entries of a Peer's io_uring. Each received datagram produces
+///         a completion, so this is sized for bursts.
+static constexpr unsigned URING_COMPLETION_ENTRIES = 4096;
+
+/// @brief  Number of reception buffers lent to the kernel by a Peer using io_uring. Its reception
+///         pool holds that many, plus the one being handled. Must be a power of two.
+static constexpr uint16_t URING_RECEIVE_BUFFERS = 32;
+
+/// @brief  Duration of a tick of the timer wheels (retransmissions, ACK delays, session timeouts).
+///         A timer fires at most this late.
+static constexpr auto TIMER_WHEEL_RESOLUTION = std::chrono::milliseconds(4);
+
+/// @brief  Number of slots of a timer wheel. A revolution lasts
+///         @code TIMER_WHEEL_SIZE * TIMER_WHEEL_RESOLUTION@endcode, which covers the longest
+///         retransmission timeout: later timers are looked at once per revolution. Must be a power
+///         of two, and a multiple of 64.
+static constexpr size_t TIMER_WHEEL_SIZE = 1 << 8;
+
+/// @brief  Number of slots a server session table starts with. The table grows (by copying it)
+///         before it is half full, so this is twice the number of sessions it holds without
+///         growing. Must be a power of two.
+static constexpr size_t SESSION_TABLE_INITIAL_CAPACITY = 64;
+
 }
 
 namespace core::packet {
@@ -35,6 +110,9 @@ namespace core::packet {
 static constexpr uint8_t INTERNAL_CHANNEL_ID = 0x00;
 static constexpr uint8_t DEFAULT_CHANNEL_ID = 0x01;
 
+/// @brief  Number of channels (every value of a Channel ID).
+static constexpr size_t CHANNEL_COUNT = 1 << 8;
+
 static constexpr std::string_view UNKNOWN_PACKET_NAME = "__rtnt_UNKNOWN";
 
 /// @brief  Maximum timespan a peer can remain silent. If no packets are being sent, an ACK packet
@@ -56,8 +134,54 @@ static constexpr auto ACK_TIMEOUT = std::chrono::milliseconds(100);
 /// higher.
 static constexpr uint8_t ACK_PACKET_THRESHOLD = 16;
 
-/// @brief  Amount of time between each packet resend.
-static constexpr auto RESEND_TIMEOUT = std::chrono::milliseconds(200);
+/// @brief  Retransmission timeout (RTO) of a session, until its first RTT sample. Afterwards, it is
+///         derived from the measured RTT (cf. @code RttEstimator@endcode).
+static constexpr auto INITIAL_RESEND_TIMEOUT = std::chrono::milliseconds(200);
+
+/// @brief  Lower bound of the retransmission timeout. RFC 6298 recommends 1 second, which is far
+///         too long for real-time traffic: this only has to absorb the scheduling jitter of the
+///         update loops.
+static constexpr auto MIN_RESEND_TIMEOUT = std::chrono::milliseconds(25);
+
+/// @brief  Longest a peer with nothing to send holds back an ACK: the @code ACK_TIMEOUT@endcode,
+///         plus a tick of the timer wheel that fires it. The retransmission timeout never goes
+///         below the smoothed RTT plus this delay, otherwise a packet sent while the other side is
+///         quiet would be retransmitted (and counted as lost) before its ACK could come back.
+static constexpr auto MAX_ACK_DELAY = ACK_TIMEOUT + TIMER_WHEEL_RESOLUTION;
+
+/// @brief  Upper bound of the retransmission timeout, exponential backoff included.
+static constexpr auto MAX_RESEND_TIMEOUT = std::chrono::milliseconds(1000);
+
+/// @brief  Number of reliable packets transmitted later that must be acknowledged before a
+///         reliable packet still waiting for its ACK is considered as lost, and retransmitted
+///         without waiting for its timeout (fast retransmit). Below, reordering would trigger
+///         spurious retransmissions.
+static constexpr uint32_t FAST_RETRANSMIT_THRESHOLD = 3;
+
+/// @brief  Initial number of slots of the window holding the reliable packets waiting for an ACK.
+///         Must be a power of two, and a multiple of 64.
+static constexpr size_t SENT_PACKET_WINDOW_INITIAL_SIZE = 1 << 6;
+
+/// @brief  Maximum number of slots of the window holding the reliable packets waiting for an ACK.
+///         The window grows up to this size when the Sequence IDs in flight span more slots than it
+///         has. Beyond, the packets whose slot is taken are kept in a map. Must be a power of two.
+static constexpr size_t MAX_SENT_PACKET_WINDOW_SIZE = 1 << 15;
+
+/// @brief  Initial number of slots of the window buffering the ordered packets received ahead of
+///         the next expected one, on a channel. It is only allocated on the first gap. Must be a
+///         power of two, and a multiple of 64.
+static constexpr size_t REORDER_BUFFER_INITIAL_SIZE = 1 << 6;
+
+/// @brief  Maximum number of slots of a reorder window. Its congestion window keeps a sender far
+///         below that many reliable packets in flight. An ordered packet further ahead is left
+///         unacknowledged, to be resent once the window has room. Must be a power of two.
+static constexpr size_t MAX_REORDER_BUFFER_SIZE = MAX_SENT_PACKET_WINDOW_SIZE;
+
+/// @brief  Number of keys of a channel whose newest sequenced packet is remembered (cf.
+///         @code Flag::kSequenced@endcode). Keys sharing a slot evict each other: a stale packet
+///         may then be delivered, but a fresh one is never dropped. Only allocated on the first
+///         sequenced packet of the channel. Must be a power of two.
+static constexpr size_t SEQUENCE_FILTER_SIZE = 1 << 8;
 
 /// @brief  Maximum number of times a peer will attempt to resend a packet. If reached, the
 /// connection will be considered as dead.
@@ -69,15 +193,69 @@ static constexpr uint8_t MAX_RESEND_ATTEMPTS =
 #endif
 ;
 
-/// @brief  Maximum number of packet IDs that can be stored in the missing packet history (in
-/// addition to acknowledge bitfield).
-static constexpr size_t MAX_PACKET_HISTORY_SIZE =
-    1 << 15;  /// Should be 1 << 6 (64), but we needa pass 80% packet loss
+/// @brief  Number of Sequence IDs, up to the highest one received, whose reception is remembered
+///         (bitmap of the reception history). A reliable packet stalled for longer (while
+///         unreliable ones kept taking Sequence IDs) is still delivered, older unreliable packets
+///         are dropped. Must be a power of two, and a multiple of 64.
+static constexpr size_t MAX_PACKET_HISTORY_SIZE = MAX_SENT_PACKET_WINDOW_SIZE;
+
+/// @brief  Size of a datagram packing several messages (@code BUNDLE@endcode) until the path MTU is
+///         known (cf. @code MAX_PROBE_SIZE@endcode). It stays below the IPv6 minimum MTU (1280
+///         bytes, minus the IP and UDP headers), so that it is never fragmented by the network.
+static constexpr size_t MAX_BUNDLE_SIZE = 1200;
+
+/// @brief  Largest datagram probed by the path MTU discovery: the IPv4 UDP payload that fits in a
+///         1500 bytes Ethernet MTU.
+static constexpr size_t MAX_PROBE_SIZE = 1472;
+
+/// @brief  The path MTU discovery stops once the largest datagram that got through is within this
+///         many bytes of the smallest one that did not.
+static constexpr size_t PROBE_PRECISION = 16;
 
-/// @brief  Maximum number of packet IDs that can be stored in a single RICH_ACK packet (to avoid
-/// exceeding MTU).
+/// @brief  Number of unanswered probes of a size before the path is considered unable to carry it.
+///         A single one may just have been lost.
+static constexpr uint8_t MAX_PROBE_ATTEMPTS = 3;
+
+/// @brief  Maximum number of packet IDs (4 bytes each) in a single legacy RICH_ACK packet, so that
+///         it fits in @code MAX_BUNDLE_SIZE@endcode (peers older than SACK never probe the path).
 static constexpr size_t MAX_ACK_PER_PACKET = 1 << 8;
 
+/// @brief  Size of a SACK block of a RICH_ACK packet on the wire. A RICH_ACK carries as many as
+///         fit in the maximum datagram size of its session.
+static constexpr size_t ACK_BLOCK_SIZE = 10;
+
+/// @brief  Size of the chunk of a message carried by each of its fragments (the last one carries
+///         the rest) for peers that do not probe the path. With its headers, a fragment fits in
+///         @code MAX_BUNDLE_SIZE@endcode. Other peers fill their maximum datagram size instead.
+static constexpr size_t FRAGMENT_SIZE = 1100;
+
+/// @brief  Maximum number of fragments of a message, which bounds messages to about 1.1 to 1.5 MB.
+static constexpr size_t MAX_FRAGMENT_COUNT = 1 << 10;
+
+/// @brief  Memory a session may use to reassemble the fragmented messages it receives. It holds
+///         at least one message of the maximum size. Beyond, incomplete unreliable messages are
+///         evicted, and fragments of new reliable ones are left unacknowledged (so resent later).
+static constexpr size_t REASSEMBLY_BUFFER_SIZE = 1 << 21;
+
+/// @brief  Congestion window of a session until its first loss, in bytes of reliable messages in
+///         flight (ten full bundles, like the initial window of RFC 6928).
+static constexpr size_t INITIAL_CONGESTION_WINDOW = 10 * MAX_BUNDLE_SIZE;
+
+/// @brief  Lower bound of the congestion window, in bytes. Losses never shrink it below two full
+///         bundles, so that a session always keeps some reliable messages in flight.
+static constexpr size_t MIN_CONGESTION_WINDOW = 2 * MAX_BUNDLE_SIZE;
+
+/// @brief  Pacing rate of a session, relative to its congestion window per smoothed RTT, while the
+///         window doubles every RTT (slow start), and once it grows linearly. Sending a bit faster
+///         than the window lets the ACKs come back before the window is exhausted.
+static constexpr unsigned SLOW_START_PACING_GAIN_PERCENT = 200;
+static constexpr unsigned PACING_GAIN_PERCENT = 125;
+
+/// @brief  Minimum number of bytes the pacer lets through at once. The bucket also holds what the
+///         pacing rate yields in a tick of the timer wheels, since the session cannot be woken up
+///         more often.
+static constexpr size_t MIN_PACING_BURST_SIZE = 2 * MAX_BUNDLE_SIZE;
+
 /**
  * @brief   Internal packet IDs
  * @warning Modifying the order or changing any assigned value is considered as a breaking change.
@@ -91,6 +269,10 @@ enum class SystemMessageId : uint16_t
     kDisconnect,
     kPing,
     kPong,
+    kBundle,
+    kFragment,
+    kProbe,
+    kProbeAck,
 };
 
 }  // namespace core::packet
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <bit>
+#include <span>
 #include <string>
 
 #include "rtnt/common/constants.hpp"
@@ -61,7 +62,7 @@ std::string byteBufferToHexString(core::ByteBuffer::const_iterator begin,
  * @param   buffer      Buffer to convert
  * @return  Converted buffer
  */
-std::string byteBufferToHexString(const core::ByteBuffer& buffer);
+std::string byteBufferToHexString(std::span<const uint8_t> buffer);
 
 /**
  * @brief   Converts a bitfield to a readable string with filled or outlined dots.
@@ -91,7 +91,9 @@ public:
     }
 
     /**
-     * @brief   Main maintenance loop. Checks for timeouts and lost packets.
+     * @brief   Main maintenance loop. Checks for timeouts and lost packets, packs the messages sent
+     *          since the last update into datagrams (cf. @code Session::flush()@endcode), then
+     *          flushes them.
      * @param   timeout The duration after which the server is considered unresponsive and so, dead
      * @note    This should be called regularly (e.g., in a main game loop).
      */
@@ -107,7 +109,7 @@ public:
 
 protected:
     void onReceive(const udp::endpoint& sender,
-                   std::shared_ptr<ByteBuffer> data) override;
+                   PooledBuffer data) override;
 
 private:
     friend class stat::Recorder;
@@ -130,6 +132,12 @@ private:
     OnDisconnectFunction _onDisconnect;
     OnMessageFunction _onMessage;
 
+    /**
+     * @brief   Checks for timeouts, reconnections and lost packets.
+     * @param   timeout The duration after which the server is considered unresponsive and so, dead
+     */
+    void _internal_update(milliseconds timeout);
+
     /**
      * @brief   Binds all internal packet handlers
      */
@@ -156,6 +164,9 @@ private:
             LOG_DEBUG("Client sending Packet #{} {}...", T::kId, packet::getName<T>());
 
             Packet packetToSend(T::kId, packet::getFlag<T>(), packet::getChannelId<T>());
+            packetToSend.setSequenceKey(packet::getSequenceKey(packetData));
+            packetToSend.setPriority(packet::getPriority<T>());
+            packetToSend.setLifetime(packet::getLifetime<T>());
             packetToSend << packetData;
             _serverSession->send(packetToSend);
         }
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+using namespace std::chrono;
+
+/**
+ * @class   CongestionController
+ * @brief   Loss-based AIMD congestion control of a session (NewReno-like, in bytes).
+ *
+ * The congestion window bounds the bytes of reliable messages in flight:
+ * - Slow start: every acknowledged byte grows the window by one byte, so it doubles every RTT,
+ *   until the first loss.
+ * - Congestion avoidance: afterwards, the window grows by one bundle per RTT.
+ * - On loss, the window is halved (at most once per RTT: losses of messages sent before the last
+ *   reduction belong to the same congestion event), down to
+ *   @code packet::MIN_CONGESTION_WINDOW@endcode.
+ *
+ * The window only grows while it limits the sender: a session sending less than its window does
+ * not learn whether the path could carry more.
+ *
+ * @note    Only reliable messages are tracked (the ACKs of the other ones are not), so the window
+ *          does not hold back unreliable messages. Every datagram goes through the pacer, whose
+ *          rate follows the window (cf. @code getPacingRate()@endcode).
+ */
+class CongestionController final
+{
+public:
+    /**
+     * @brief   Counts a reliable message of the given size as in flight.
+     */
+    void onSent(size_t bytes);
+
+    /**
+     * @brief   Removes an acknowledged message from the flight, and grows the window.
+     * @param   bytes       Size of the message
+     * @param   sentTime    Time of its last transmission
+     */
+    void onAcknowledged(size_t bytes,
+                        time_point<steady_clock> sentTime);
+
+    /**
+     * @brief   Removes a lost message from the flight (its retransmission is a new send), and
+     *          shrinks the window.
+     * @param   bytes       Size of the message
+     * @param   sentTime    Time of its last transmission
+     * @param   now         Current time
+     */
+    void onLost(size_t bytes,
+                time_point<steady_clock> sentTime,
+                time_point<steady_clock> now);
+
+    /**
+     * @return  @code true@endcode if a reliable message of the given size fits in the window. A
+     *          message is always allowed when nothing is in flight, whatever its size.
+     */
+    [[nodiscard]] bool canSend(size_t bytes) const;
+
+    /**
+     * @return  The rate at which the pacer lets datagrams through, in bytes per second: the window
+     *          per smoothed RTT, scaled by @code packet::SLOW_START_PACING_GAIN_PERCENT@endcode or
+     *          @code packet::PACING_GAIN_PERCENT@endcode. @code 0@endcode (no pacing) until the
+     *          first RTT sample.
+     */
+    [[nodiscard]] uint64_t getPacingRate(microseconds smoothedRtt) const;
+
+    [[nodiscard]] size_t getCongestionWindow() const { return _congestionWindow; }
+    [[nodiscard]] size_t getBytesInFlight() const { return _bytesInFlight; }
+    [[nodiscard]] bool isInSlowStart() const { return _congestionWindow < _slowStartThreshold; }
+
+private:
+    size_t _congestionWindow = packet::INITIAL_CONGESTION_WINDOW;
+    size_t _slowStartThreshold = SIZE_MAX;  ///< Window below which it grows exponentially
+    size_t _bytesInFlight = 0;
+    time_point<steady_clock> _recoveryStart;  ///< Last reduction of the window
+};
+
+}  // namespace rtnt::core
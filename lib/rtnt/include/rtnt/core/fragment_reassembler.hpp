@@ -0,0 +1,101 @@
+#pragma once
+
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "packet.hpp"
+
+namespace rtnt::core {
+
+/**
+ * @class   FragmentReassembler
+ * @brief   Rebuilds the fragmented messages received by a session (cf.
+ *          @code packet::FragmentHeader@endcode), within a bounded memory budget.
+ *
+ * Every fragment but the last one carries the same number of bytes, which depends on the maximum
+ * datagram size of the sender: it is learnt from the first of them received. Until then, the last
+ * fragment is kept aside.
+ *
+ * The first fragment received of a message reserves room for all of them. The reservations never
+ * exceed @code packet::REASSEMBLY_BUFFER_SIZE@endcode bytes: when a new message does not fit, the
+ * oldest incomplete unreliable messages are evicted (some of their fragments were lost, they may
+ * never complete). Incomplete reliable messages are never evicted, since their fragments have
+ * already been acknowledged: the fragment of a new message is then refused, and must be left
+ * unacknowledged, so that it is retransmitted once some room has been freed.
+ */
+class FragmentReassembler final
+{
+public:
+    enum class Result : uint8_t
+    {
+        kIncomplete,  ///< Fragment stored, the message is still missing some.
+        kComplete,    ///< Last missing fragment: the message is rebuilt.
+        kRefused,     ///< No room for the message: the fragment must not be acknowledged.
+        kInvalid,     ///< Malformed fragment, or inconsistent with the other ones of its message.
+    };
+
+    struct Message
+    {
+        packet::SequenceId firstSequenceId = 0;  ///< Identifies the message
+        packet::Id messageId = 0;
+        ByteBuffer payload;
+    };
+
+    /**
+     * @brief   Stores a fragment.
+     * @param   sequenceId  Sequence ID of the fragment
+     * @param   payload     Payload of the fragment (sub-header then chunk)
+     * @param   isReliable  Whether the message is reliable (cf. @code packet::isReliable()@endcode)
+     * @param   message     Set to the rebuilt message, if complete
+     */
+    Result receive(packet::SequenceId sequenceId,
+                   std::span<const uint8_t> payload,
+                   bool isReliable,
+                   Message& message);
+
+    /**
+     * @return  The number of bytes reserved by the messages being reassembled.
+     */
+    [[nodiscard]] size_t getReservedBytes() const { return _reservedBytes; }
+
+    /**
+     * @return  The number of messages being reassembled.
+     */
+    [[nodiscard]] size_t size() const { return _assemblies.size(); }
+
+private:
+    struct Assembly
+    {
+        packet::Id messageId = 0;
+        uint16_t count = 0;
+        uint16_t received = 0;
+        bool isReliable = false;
+        uint64_t creation = 0;            ///< Creation order, to evict the oldest first
+        size_t size = 0;                  ///< Size of the message, known with its last fragment
+        size_t fragmentSize = 0;          ///< Size of the fragments but the last (0 until known)
+        size_t reservation = 0;           ///< Bytes reserved in the budget
+        std::vector<uint64_t> fragments;  ///< One bit per fragment received
+        ByteBuffer lastFragment;          ///< Last fragment, until the fragment size is known
+        ByteBuffer data;
+    };
+
+    std::unordered_map<packet::SequenceId, Assembly> _assemblies;  ///< By first Sequence ID
+    size_t _reservedBytes = 0;
+    uint64_t _nextCreation = 0;
+
+    /**
+     * @brief   Evicts incomplete unreliable messages, oldest first, until the given number of bytes
+     *          fits in the budget.
+     * @return  @code false@endcode if it cannot fit.
+     */
+    bool reserve(size_t bytes);
+
+    /**
+     * @brief   Sets the size of the fragments of a message, and shrinks its reservation to it.
+     */
+    void setFragmentSize(Assembly& assembly,
+                         size_t fragmentSize);
+};
+
+}  // namespace rtnt::core
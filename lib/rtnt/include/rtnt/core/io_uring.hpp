@@ -0,0 +1,157 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <linux/io_uring.h>
+#include <sys/socket.h>
+
+#include <array>
+#include <asio/post.hpp>
+#include <asio/posix/stream_descriptor.hpp>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "rtnt/common/buffer_pool.hpp"
+#include "rtnt/core/peer.hpp"
+
+namespace rtnt::core {
+
+/**
+ * @class   IoUring
+ * @brief   io_uring transport of a Peer (see @code Peer::IoBackend::kIoUring@endcode).
+ *
+ * - Reception: a single multishot @code recvmsg@endcode keeps receiving into buffers lent to the
+ *   kernel through a registered buffer ring. These buffers come from the Peer's reception pool,
+ *   and each one is replaced by a fresh pool buffer as soon as it is filled. Received datagrams
+ *   are copied once into the datagram pool (cf. @code Peer::deliverDatagram@endcode), so that
+ *   their reception buffer goes back to the pool right away.
+ * - Emission: every datagram queued since the last @code Peer::flush()@endcode becomes a
+ *   @code sendmsg@endcode submission, and they are all submitted with a single syscall.
+ *
+ * The socket is registered in the ring, so that the kernel does not look it up for every operation.
+ * Completions are reaped by the I/O thread, which waits for the ring to be readable through asio
+ * like for any other file descriptor.
+ *
+ * @note    Talks to the kernel directly (no liburing). Requires Linux 6.0 or newer.
+ */
+class IoUring final
+{
+public:
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * @brief   Sets up a ring for the socket of a Peer.
+     * @param   peer    The Peer to receive and send for
+     * @return  The ring, or @code nullptr@endcode if the kernel does not support what is needed.
+     */
+    static std::unique_ptr<IoUring> create(Peer& peer);
+
+    /**
+     * @brief   Cancels every pending operation, waits for them, then releases the ring.
+     * @warning The I/O thread must not be reaping completions at the same time.
+     */
+    ~IoUring();
+
+    /**
+     * @brief   Starts receiving. The receive operation is armed from the I/O thread, so that the
+     *          kernel runs its completions there.
+     */
+    void start();
+
+    /**
+     * @brief   Submits a @code sendmsg@endcode for each datagram, with a single syscall.
+     * @param   datagrams   Datagrams to send
+     * @return  The number of datagrams submitted, from the front. The others could not fit in the
+     *          ring and must be sent another way.
+     */
+    size_t send(std::vector<Peer::OutgoingDatagram>& datagrams);
+
+private:
+    struct SendSlot
+    {
+        std::shared_ptr<ByteBuffer> data;
+        std::shared_ptr<const ByteBuffer> payload;
+        udp::endpoint target;
+        std::array<iovec, 2> vectors{};
+        msghdr header{};
+    };
+
+    /// @code user_data@endcode of the multishot receive. Sends use the index of their slot.
+    static constexpr uint64_t RECEIVE_TAG = UINT64_MAX;
+    static constexpr uint64_t CANCEL_TAG = UINT64_MAX - 1;
+    static constexpr uint16_t BUFFER_GROUP = 0;
+
+    Peer& _peer;
+    int _fd = -1;
+    asio::posix::stream_descriptor _descriptor;
+
+    // Ring memory, shared with the kernel.
+    void* _ringMemory = nullptr;
+    size_t _ringMemorySize = 0;
+    io_uring_sqe* _sqes = nullptr;
+    size_t _sqesSize = 0;
+    unsigned* _sqHead = nullptr;
+    unsigned* _sqTail = nullptr;
+    unsigned _sqMask = 0;
+    unsigned _sqEntries = 0;
+    unsigned _sqLocalTail = 0;
+    unsigned* _cqHead = nullptr;
+    unsigned* _cqTail = nullptr;
+    unsigned _cqMask = 0;
+    io_uring_cqe* _cqes = nullptr;
+
+    // Provided buffers, lent to the kernel for the multishot receive.
+    io_uring_buf_ring* _bufferRing = nullptr;
+    size_t _bufferRingSize = 0;
+    uint16_t _bufferTail = 0;
+    std::vector<PooledBuffer> _lentBuffers;
+    msghdr _receiveHeader{};
+    bool _isReceiveArmed = false;
+    bool _isStopping = false;
+
+    // Protects the submission queue and the send slots, as the Peer can flush from any thread.
+    std::mutex _submissionMutex;
+    std::vector<SendSlot> _sendSlots;
+    std::vector<uint32_t> _freeSendSlots;
+    size_t _pendingOperations = 0;
+
+    explicit IoUring(Peer& peer);
+
+    bool setup();
+
+    /**
+     * @return  A cleared submission entry, or @code nullptr@endcode if the submission queue is
+     *          full.
+     * @note    Requires @code _submissionMutex@endcode.
+     */
+    io_uring_sqe* getSqe();
+
+    /**
+     * @brief   Publishes the prepared entries and enters the kernel.
+     * @note    Requires @code _submissionMutex@endcode.
+     */
+    int submit(unsigned minComplete = 0,
+               unsigned flags = 0);
+
+    void armReceive();
+    void lendBuffer(uint16_t bufferId);
+    void wait();
+
+    /**
+     * @brief   Handles every available completion.
+     * @return  The number of datagrams received.
+     */
+    size_t reap();
+
+    /**
+     * @return  @code 1@endcode if a datagram was handed to the Peer, @code 0@endcode otherwise.
+     */
+    size_t handleReception(const io_uring_cqe& cqe);
+    void handleSendCompletion(const io_uring_cqe& cqe);
+};
+
+}  // namespace rtnt::core
+
+#endif
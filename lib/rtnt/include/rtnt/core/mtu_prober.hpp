@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+/**
+ * @class   MtuProber
+ * @brief   Searches the largest datagram the path to a peer carries (Path MTU discovery, in the
+ *          spirit of RFC 8899).
+ *
+ * The session sends @code PROBE@endcode datagrams of the sizes this class asks for, with the
+ * "don't fragment" bit set where the platform allows it, and reports whether the peer answered
+ * them. The search starts from @code packet::MAX_BUNDLE_SIZE@endcode, which every path carries:
+ * - The largest size (@code packet::MAX_PROBE_SIZE@endcode) is probed first, since most paths
+ *   carry it. If it gets through, the search is over after a single round trip.
+ * - Otherwise, the sizes between the largest that got through and the smallest that did not are
+ *   searched by dichotomy, until they are within @code packet::PROBE_PRECISION@endcode bytes.
+ *
+ * A size is only considered too large after @code packet::MAX_PROBE_ATTEMPTS@endcode unanswered
+ * probes, so that a probe lost to congestion does not shrink the datagrams of the session.
+ */
+class MtuProber final
+{
+public:
+    /**
+     * @return  The size of the next probe, or @code 0@endcode if the search is over.
+     */
+    [[nodiscard]] size_t getProbeSize() const;
+
+    /**
+     * @brief   Records that a probe got through.
+     */
+    void onAcknowledged(size_t probeSize);
+
+    /**
+     * @brief   Records that a probe was not answered in time.
+     */
+    void onLost(size_t probeSize);
+
+    /**
+     * @return  The largest datagram known to get through.
+     */
+    [[nodiscard]] size_t getMaxDatagramSize() const { return _low; }
+
+    [[nodiscard]] bool isDone() const { return getProbeSize() == 0; }
+
+private:
+    size_t _low = packet::MAX_BUNDLE_SIZE;  ///< Largest size that got through
+    size_t _high = packet::MAX_PROBE_SIZE;  ///< Largest size that may get through
+    uint8_t _attempts = 0;                  ///< Unanswered probes of the current size
+};
+
+}  // namespace rtnt::core
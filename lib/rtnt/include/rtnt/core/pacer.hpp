@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+namespace rtnt::core {
+
+using namespace std::chrono;
+
+/**
+ * @class   Pacer
+ * @brief   Token bucket spreading the datagrams of a session over time, instead of sending them in
+ *          bursts.
+ *
+ * Tokens (bytes) accumulate at the pacing rate, up to the size of the bucket. A datagram can be
+ * sent as long as some tokens are left, and consumes its size: a datagram larger than the tokens
+ * left puts the bucket in debt, which delays the next one accordingly.
+ *
+ * The bucket holds @code packet::MIN_PACING_BURST_SIZE@endcode bytes, or what the rate yields in a
+ * tick of the timer wheels if more: the datagrams queued in a game tick leave over the tick
+ * instead of all at once.
+ */
+class Pacer final
+{
+public:
+    /**
+     * @brief   Sets the pacing rate.
+     * @param   bytesPerSecond  Pacing rate, @code 0@endcode disabling pacing
+     * @param   now             Current time
+     */
+    void setRate(uint64_t bytesPerSecond,
+                 time_point<steady_clock> now);
+
+    /**
+     * @return  @code true@endcode if a datagram can be sent now.
+     */
+    [[nodiscard]] bool canSend(time_point<steady_clock> now);
+
+    /**
+     * @brief   Takes the size of a datagram sent out of the bucket.
+     */
+    void consume(size_t bytes,
+                 time_point<steady_clock> now);
+
+    /**
+     * @return  The earliest time the next datagram can be sent.
+     */
+    [[nodiscard]] time_point<steady_clock> getNextSendTime(time_point<steady_clock> now);
+
+    [[nodiscard]] uint64_t getRate() const { return _rate; }
+
+private:
+    uint64_t _rate = 0;  ///< Bytes per second, 0 if disabled
+    int64_t _tokens = 0;
+    int64_t _capacity = 0;
+    time_point<steady_clock> _lastRefill;
+
+    /**
+     * @brief   Adds the tokens accumulated since the last refill.
+     */
+    void refill(time_point<steady_clock> now);
+};
+
+}  // namespace rtnt::core
@@ -1,11 +1,15 @@
 #pragma once
 
+#include <chrono>
 #include <cstring>
 #include <limits>
+#include <memory>
+#include <span>
 #include <type_traits>
 #include <vector>
 
 #include "logger/Logger.h"
+#include "rtnt/common/buffer_pool.hpp"
 #include "rtnt/common/constants.hpp"
 #include "rtnt/common/utils.hpp"
 
@@ -23,6 +27,7 @@ using ProtocolVersion = uint16_t;
 using SequenceId = uint32_t;
 using ChannelId = uint8_t;
 using OrderId = uint32_t;
+using SequenceKey = uint32_t;
 using AcknowledgeId = uint32_t;
 using AcknowledgeBitfield = uint32_t;
 using Checksum = uint32_t;
@@ -37,11 +42,30 @@ enum class Flag : uint8_t
     kReliable = 1 << 1,    ///< Guaranteed delivery. Will be resent until ACKed.
     kOrdered = 1 << 2,     ///< Guaranteed order. Will be buffered until previous packets arrive.
     kHasAck = 1 << 3,      ///< Packets with this flag will have a valid ACK ID.
+    kSequenced = 1 << 4,   ///< Latest only. May be lost, and dropped if a newer one was received.
 };
 
 Flag operator&(Flag lhs,
                Flag rhs);
 
+/**
+ * @enum    packet::Priority
+ * @brief   Order in which the queued messages of a session are sent, when it cannot send all of
+ *          them at once (cf. @code Session::flush()@endcode).
+ */
+enum class Priority : uint8_t
+{
+    kLow = 0,
+    kNormal,
+    kHigh,
+};
+
+/**
+ * @return  @code true@endcode if packets with this flag are resent until acknowledged
+ *          (@code kReliable@endcode or @code kOrdered@endcode).
+ */
+bool isReliable(Flag flag);
+
 struct Header;
 
 namespace parsing {
@@ -130,17 +154,86 @@ struct Header final
     }
 
     /**
-     * @brief   Tries to parse a raw ByteBuffer to extract a rtnt header.
+     * @brief   Tries to parse raw bytes to extract a rtnt header.
      * @param   data    Raw buffer data
      * @return  A @code parsing::Result@endcode instance with details in it.
      *          If an error occurred during parsing, @code parsing::Result::header@endcode will be set to
      *          @code std::nullopt@endcode and @code parsing::Result::header@endcode will be set to something
      *          different from @code parsing::Error::kNone@endcode.
      */
-    static parsing::Result parse(const ByteBuffer& data);
+    static parsing::Result parse(std::span<const uint8_t> data);
+};
+
+/**
+ * @struct  packet::BundleEntry
+ * @brief   Sub-header of a message carried by a @code BUNDLE@endcode datagram.
+ *
+ * A bundle packs several messages in a single datagram. Its Header carries the ACK information
+ * once for all of them, and each message follows as a BundleEntry and its payload. The entry only
+ * keeps the fields that are specific to a message.
+ * @warning All multibyte fields MUST be converted to Network Byte Order (Big Endian) before
+ *          sending.
+ */
+struct BundleEntry final
+{
+    SequenceId sequenceId = 0;  ///< The unique, incrementing ID of this message
+    ChannelId channelId = 0;    ///< ID of the channel the message will be processed in.
+    OrderId orderId = 0;        ///< The unique, incrementing order ID of this message.
+    Id messageId = 0x0;         ///< Command type (user-defined)
+    uint8_t flags =
+        static_cast<uint8_t>(Flag::kUnreliable);  ///< Reliability flags (cf. packet::Flag)
+    uint16_t packetSize = 0;                      ///< Size of the payload
+
+    /**
+     * @brief   Converts all fields from Host Byte Order to Network Byte Order, or the other way.
+     */
+    void convertEndianness()
+    {
+        sequenceId = endian::swap(sequenceId);
+        orderId = endian::swap(orderId);
+        messageId = endian::swap(messageId);
+        packetSize = endian::swap(packetSize);
+    }
+};
+
+/**
+ * @struct  packet::FragmentHeader
+ * @brief   Sub-header at the start of the payload of a @code FRAGMENT@endcode message.
+ *
+ * A message too large for a datagram is split into fragments of the same size (the last one carries
+ * the rest, cf. @code FRAGMENT_SIZE@endcode), sent with consecutive Sequence IDs: the message is
+ * identified by the Sequence ID of its first fragment. Each fragment keeps the channel, Order ID and flags of the
+ * message, and is acknowledged and retransmitted on its own.
+ * @warning All multibyte fields MUST be converted to Network Byte Order (Big Endian) before
+ *          sending.
+ */
+struct FragmentHeader final
+{
+    uint16_t index = 0;  ///< Position of the fragment in the message
+    uint16_t count = 0;  ///< Number of fragments of the message
+    Id messageId = 0x0;  ///< Command type of the message
+
+    /**
+     * @brief   Converts all fields from Host Byte Order to Network Byte Order, or the other way.
+     */
+    void convertEndianness()
+    {
+        index = endian::swap(index);
+        count = endian::swap(count);
+        messageId = endian::swap(messageId);
+    }
 };
 #pragma pack(pop)
 
+/// @brief  Largest chunk of a message a fragment may carry: it fills a datagram of
+///         @code MAX_PROBE_SIZE@endcode bytes.
+static constexpr size_t MAX_FRAGMENT_SIZE = MAX_PROBE_SIZE - sizeof(Header) - sizeof(FragmentHeader);
+
+static_assert(sizeof(Header) + sizeof(FragmentHeader) + FRAGMENT_SIZE <= MAX_BUNDLE_SIZE);
+static_assert(MAX_FRAGMENT_COUNT <= UINT16_MAX);
+static_assert(REASSEMBLY_BUFFER_SIZE >= MAX_FRAGMENT_COUNT * MAX_FRAGMENT_SIZE);
+static_assert(DATAGRAM_BUFFER_SIZE >= MAX_PROBE_SIZE);
+
 namespace parsing {
 
 /**
@@ -247,6 +340,56 @@ constexpr Flag getFlag()
     }
 }
 
+/**
+ * @brief   Key of a @code Flag::kSequenced@endcode packet: only the newest packet of each key (on
+ *          its channel) is delivered. A packet struct provides it with a
+ *          @code sequenceKey()@endcode member function, e.g. the entity a position update is
+ *          about.
+ * @tparam  T   Packet struct
+ * @return  The key of the packet. Default to 0 (a single key for the whole channel).
+ */
+template <typename T>
+constexpr SequenceKey getSequenceKey(const T& packetData)
+{
+    if constexpr (requires { packetData.sequenceKey(); }) {
+        return static_cast<SequenceKey>(packetData.sequenceKey());
+    } else {
+        return 0;
+    }
+}
+
+/**
+ * @tparam  T   Packet struct
+ * @return  The priority that is contained in the packet struct.
+ *          Default to @code Priority::kNormal@endcode.
+ */
+template <typename T>
+constexpr Priority getPriority()
+{
+    if constexpr (requires { T::kPriority; }) {
+        return T::kPriority;
+    } else {
+        return Priority::kNormal;
+    }
+}
+
+/**
+ * @brief   Time after which an unreliable packet that is still queued is not worth sending anymore
+ *          (e.g. a position update superseded by the next tick). It is then dropped.
+ * @tparam  T   Packet struct
+ * @return  The lifetime that is contained in the packet struct (@code kLifetime@endcode).
+ *          Default to 0 (no deadline). Ignored for reliable packets.
+ */
+template <typename T>
+constexpr std::chrono::milliseconds getLifetime()
+{
+    if constexpr (requires { T::kLifetime; }) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(T::kLifetime);
+    } else {
+        return std::chrono::milliseconds::zero();
+    }
+}
+
 /**
  * @brief   Verifies if a given struct has the layout of a packet.
  *
@@ -365,7 +508,7 @@ void verifyPacketIntegratedCallback()
  * @return  @code true@endcode if given ByteBuffer contains a valid T header
  */
 template <typename T>
-bool is(const ByteBuffer& rawData)
+bool is(std::span<const uint8_t> rawData)
 {
     verifyPacketData<T>();
     parsing::Result res = Header::parse(rawData);
@@ -452,13 +595,15 @@ public:
                      Packet&>
     operator>>(T& data)
     {
-        if (_readPosition + sizeof(T) > _buffer.size()) {
+        const auto payload = getPayload();
+
+        if (_readPosition + sizeof(T) > payload.size()) {
             throw std::runtime_error("Packet Underflow");
         }
 
         T networkData;
 
-        std::memcpy(&networkData, _buffer.data() + _readPosition, sizeof(T));
+        std::memcpy(&networkData, payload.data() + _readPosition, sizeof(T));
         data = endian::swap(networkData);
         _readPosition += sizeof(T);
         return *this;
@@ -473,12 +618,15 @@ public:
         uint16_t size = 0;
 
         *this >> size;
-        if (_readPosition + size > _buffer.size()) {
+
+        const auto payload = getPayload();
+
+        if (_readPosition + size > payload.size()) {
             throw std::runtime_error("Packet Underflow");
         }
 
-        str.assign(_buffer.begin() + static_cast<long>(_readPosition),
-                   _buffer.begin() + static_cast<long>(_readPosition) + size);
+        str.assign(payload.begin() + static_cast<long>(_readPosition),
+                   payload.begin() + static_cast<long>(_readPosition) + size);
         _readPosition += size;
         return *this;
     }
@@ -493,7 +641,64 @@ public:
     [[nodiscard]] packet::Id getId() const { return _messageId; }
     [[nodiscard]] packet::Flag getReliability() const { return _flag; }
     [[nodiscard]] packet::ChannelId getChannel() const { return _channelId; }
-    [[nodiscard]] const ByteBuffer& getPayload() const { return _buffer; }
+    /**
+     * @return  The key of a @code Flag::kSequenced@endcode packet (cf.
+     *          @code packet::getSequenceKey()@endcode). Only known for packets being sent.
+     */
+    [[nodiscard]] packet::SequenceKey getSequenceKey() const { return _sequenceKey; }
+    void setSequenceKey(const packet::SequenceKey key) { _sequenceKey = key; }
+    [[nodiscard]] packet::Priority getPriority() const { return _priority; }
+    void setPriority(const packet::Priority priority) { _priority = priority; }
+    /**
+     * @return  The lifetime of an unreliable packet being sent (cf.
+     *          @code packet::getLifetime()@endcode), 0 if it has no deadline.
+     */
+    [[nodiscard]] std::chrono::milliseconds getLifetime() const { return _lifetime; }
+    void setLifetime(const std::chrono::milliseconds lifetime) { _lifetime = lifetime; }
+    /**
+     * @return  A read-only view of the payload.
+     * @note    For received packets, the view points into the reception buffer of the Peer: it
+     *          stays valid as long as the Packet (or any copy of it) does.
+     */
+    [[nodiscard]] std::span<const uint8_t> getPayload() const
+    {
+        if (_source) {
+            return _source.view().subspan(_sourceOffset);
+        }
+        if (_shared) {
+            return *_shared;
+        }
+        return _buffer;
+    }
+
+    /**
+     * @brief   Moves the payload into an immutable buffer, shared by every copy of the Packet: a
+     *          copy then no longer copies the payload.
+     *
+     * Used to send the same Packet to many sessions (cf. @code Server::broadcast()@endcode): it
+     * is serialized once, and each session only builds its own header in front of the shared
+     * payload. Writing into a shared Packet gives it its own copy of the payload again.
+     */
+    void share()
+    {
+        if (_shared) {
+            return;
+        }
+        if (_source) {
+            const auto payload = getPayload();
+
+            _shared = std::make_shared<const ByteBuffer>(payload.begin(), payload.end());
+            _source = {};
+        } else {
+            _shared = std::make_shared<const ByteBuffer>(std::move(_buffer));
+        }
+        _buffer.clear();
+    }
+
+    /**
+     * @return  Whether the payload is shared with other Packets (cf. @code share()@endcode).
+     */
+    [[nodiscard]] bool isShared() const { return _shared != nullptr; }
 
 private:
     friend class Session;
@@ -502,14 +707,29 @@ private:
     packet::Id _messageId = 0x0;
     packet::Flag _flag = packet::Flag::kUnreliable;
     packet::ChannelId _channelId = 0;
+    packet::SequenceKey _sequenceKey = 0;
+    packet::Priority _priority = packet::Priority::kNormal;
+    std::chrono::milliseconds _lifetime{0};
 
     // Data
     ByteBuffer _buffer{};
+    PooledBuffer _source{};  ///< Received datagram the payload points into, if any.
+    std::shared_ptr<const ByteBuffer> _shared{};  ///< Payload shared with other Packets, if any.
+    size_t _sourceOffset = 0;
     size_t _readPosition = 0;
 
-    void _internal_setPayload(ByteBuffer&& data)
+    /**
+     * @brief   Makes the payload a view into a received datagram, without copying it.
+     * @param   source  The received datagram
+     * @param   offset  Offset of the payload in the datagram (i.e. the size of the header)
+     */
+    void _internal_setPayload(PooledBuffer source,
+                              const size_t offset)
     {
-        _buffer = std::move(data);
+        _buffer.clear();
+        _shared.reset();
+        _source = std::move(source);
+        _sourceOffset = std::min(offset, _source.size());
         _readPosition = 0;
     }
 
@@ -523,6 +743,13 @@ private:
     {
         const auto* ptr = static_cast<const uint8_t*>(data);
 
+        if (_source || _shared) {  // Writing into a viewed payload: the packet needs its own copy.
+            const auto payload = getPayload();
+
+            _buffer.assign(payload.begin(), payload.end());
+            _source = {};
+            _shared.reset();
+        }
         _buffer.insert(_buffer.end(), ptr, ptr + size);
     }
 };
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "rtnt/common/constants.hpp"
+#include "rtnt/core/packet.hpp"
+
+namespace rtnt::core::packet::internal {
+
+/**
+ * @struct  Probe
+ * @brief   Path MTU probe (cf. @code MtuProber@endcode).
+ *
+ * The payload is padded so that the datagram is exactly @code size@endcode bytes long. It is
+ * always sent on its own, with the "don't fragment" bit set where the platform allows it: if the
+ * peer receives it, the path carries datagrams of that size. The peer answers with a
+ * @code PROBE_ACK@endcode.
+ *
+ * @note    Sent to peers speaking @code PMTU_PROTOCOL_VER@endcode or newer.
+ */
+struct Probe
+{
+    static constexpr Id kId = static_cast<uint16_t>(SystemMessageId::kProbe);
+    static constexpr ChannelId kChannel = INTERNAL_CHANNEL_ID;
+    static constexpr Flag kFlag = Flag::kUnreliable;
+    static constexpr Name kName = INTERNAL_PACKET_NAME("PROBE");
+
+    uint16_t size = 0;  ///< Size of the whole datagram, padding included.
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & size;
+    }
+};
+
+/**
+ * @struct  ProbeAck
+ * @brief   Answer to a @code PROBE@endcode, carrying the size of the datagram that got through.
+ */
+struct ProbeAck
+{
+    static constexpr Id kId = static_cast<uint16_t>(SystemMessageId::kProbeAck);
+    static constexpr ChannelId kChannel = INTERNAL_CHANNEL_ID;
+    static constexpr Flag kFlag = Flag::kUnreliable;
+    static constexpr Name kName = INTERNAL_PACKET_NAME("PROBE_ACK");
+
+    uint16_t size = 0;
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & size;
+    }
+};
+
+}  // namespace rtnt::core::packet::internal
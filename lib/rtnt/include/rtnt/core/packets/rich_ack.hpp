@@ -1,10 +1,38 @@
 #pragma once
 
+#include <bit>
+#include <deque>
+#include <vector>
+
 #include "rtnt/common/constants.hpp"
 #include "rtnt/core/packet.hpp"
 
 namespace rtnt::core::packet::internal {
 
+/**
+ * @struct  AckBlock
+ * @brief   Selective acknowledgement (SACK) block of a @code RICH_ACK@endcode.
+ *
+ * A block acknowledges a run of consecutive Sequence IDs, then up to 32 sparse Sequence IDs after
+ * it: the ID following the run is known to be missing, so bit @code i@endcode of the tail stands
+ * for @code start + length + 1 + i@endcode. Under bursty loss, a single 10 bytes block replaces
+ * dozens of IDs.
+ */
+struct AckBlock
+{
+    SequenceId start = 0;
+    uint16_t length = 0;  ///< Number of consecutive IDs acknowledged from @code start@endcode.
+    uint32_t tail = 0;    ///< Sparse IDs after the run.
+
+    bool operator==(const AckBlock&) const = default;
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & start & length & tail;
+    }
+};
+
 /**
  * @struct  RichAck
  * @brief   Internal packet used for out-of-band (OOB) acknowledgments.
@@ -16,9 +44,12 @@ namespace rtnt::core::packet::internal {
  * 32-bit window. Since the header cannot represent this, the sender would normally keep
  * retransmitting it forever.
  *
- * The @code RICH_ACK@endcode solves this by carrying an explicit list of these "old" Sequence IDs
- * in its payload. When the sender receives this, it marks those specific IDs as received, stopping
- * the retransmission loop.
+ * The @code RICH_ACK@endcode solves this by carrying the Sequence IDs that are outside the
+ * bitfield window in its payload, as SACK blocks (cf. @code AckBlock@endcode). When the sender
+ * receives this, it marks those specific IDs as received, stopping the retransmission loop.
+ *
+ * @note    Sent to peers speaking @code SACK_PROTOCOL_VER@endcode or newer. Older ones get a
+ *          @code LegacyRichAck@endcode.
  */
 struct RichAck
 {
@@ -27,6 +58,89 @@ struct RichAck
     static constexpr Flag kFlag = Flag::kUnreliable;
     static constexpr Name kName = INTERNAL_PACKET_NAME("RICH_ACK");
 
+    std::vector<AckBlock> blocks;
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & blocks;
+    }
+
+    /**
+     * @brief   Encodes Sequence IDs into SACK blocks.
+     * @param   sequenceIds Sequence IDs to acknowledge, sorted from the oldest and without
+     *                      duplicates
+     * @return  The blocks, in the same order.
+     */
+    static std::vector<AckBlock> encode(const std::deque<SequenceId>& sequenceIds)
+    {
+        std::vector<AckBlock> blocks;
+        size_t i = 0;
+
+        while (i < sequenceIds.size()) {
+            AckBlock block{.start = sequenceIds[i], .length = 1};
+
+            for (i++; i < sequenceIds.size() && block.length < UINT16_MAX; i++) {
+                if (sequenceIds[i] != block.start + block.length) {
+                    break;
+                }
+                block.length++;
+            }
+
+            const SequenceId tailStart = block.start + block.length + 1;
+
+            for (; i < sequenceIds.size() && sequenceIds[i] - tailStart < 32; i++) {
+                block.tail |= 1U << (sequenceIds[i] - tailStart);
+            }
+            blocks.push_back(block);
+        }
+        return blocks;
+    }
+
+    /**
+     * @return  The maximum number of blocks of a @code RICH_ACK@endcode that fits in a datagram of
+     *          the given size, alone or in a bundle.
+     */
+    static constexpr size_t getMaxBlockCount(const size_t datagramSize)
+    {
+        constexpr size_t overhead = sizeof(Header) + sizeof(BundleEntry) + sizeof(uint16_t);
+
+        return (datagramSize - overhead) / ACK_BLOCK_SIZE;
+    }
+
+    /**
+     * @brief   Calls a function on every Sequence ID acknowledged by the blocks.
+     * @param   function    Function signature: @code void(SequenceId)@endcode
+     */
+    template <typename Function>
+    void forEach(Function&& function) const
+    {
+        for (const AckBlock& block : blocks) {
+            for (uint32_t i = 0; i < block.length; i++) {
+                function(block.start + i);
+            }
+
+            const SequenceId tailStart = block.start + block.length + 1;
+
+            for (uint32_t bits = block.tail; bits != 0; bits &= bits - 1) {
+                function(tailStart + static_cast<SequenceId>(std::countr_zero(bits)));
+            }
+        }
+    }
+};
+
+/**
+ * @struct  LegacyRichAck
+ * @brief   @code RICH_ACK@endcode of the protocol versions older than
+ *          @code SACK_PROTOCOL_VER@endcode: an explicit list of Sequence IDs.
+ */
+struct LegacyRichAck
+{
+    static constexpr Id kId = static_cast<uint16_t>(SystemMessageId::kRichAck);
+    static constexpr ChannelId kChannel = INTERNAL_CHANNEL_ID;
+    static constexpr Flag kFlag = Flag::kUnreliable;
+    static constexpr Name kName = INTERNAL_PACKET_NAME("RICH_ACK");
+
     std::deque<uint32_t> oobAcks;
 
     template <typename Archive>
@@ -36,4 +150,8 @@ struct RichAck
     }
 };
 
+static_assert(sizeof(Header) + sizeof(BundleEntry) + sizeof(uint16_t) +
+                  MAX_ACK_PER_PACKET * sizeof(SequenceId) <=
+              MAX_BUNDLE_SIZE);
+
 }  // namespace rtnt::core::packet::internal
@@ -2,8 +2,10 @@
 
 #include <asio/io_context.hpp>
 #include <asio/ip/udp.hpp>
+#include <mutex>
 
 #include "packet.hpp"
+#include "rtnt/common/buffer_pool.hpp"
 #include "rtnt/stat/metrics.hpp"
 
 static constexpr size_t BUFFER_SIZE = USHRT_MAX;
@@ -12,6 +14,10 @@ namespace rtnt::core {
 
 using asio::ip::udp;
 
+#if defined(__linux__)
+class IoUring;
+#endif
+
 /**
  * @class   Peer
  * @brief   Abstract base class for any network entity (Client or Server).
@@ -24,38 +30,126 @@ using asio::ip::udp;
  * - Asynchronous receiving loop
  * - Sending raw byte buffers
  *
+ * Several I/O backends are available (see @code IoBackend@endcode). The asio one is portable and
+ * used by default, the others trade latency within a tick for far fewer syscalls.
+ *
  * @warning This class does NOT parse packets. It sticks to raw bytes, both for
  * receiving and sending data.
  */
 class Peer
 {
 public:
-    virtual ~Peer() = default;
+    /**
+     * @enum    Peer::IoBackend
+     * @brief   How the Peer talks to its socket.
+     */
+    enum class IoBackend : uint8_t
+    {
+        kAsio,     ///< One asio operation per datagram, sent as soon as possible. Portable.
+        kBatched,  ///< Linux only. Drains up to @code RECEIVE_BATCH_SIZE@endcode datagrams per
+                   ///< wakeup with @code recvmmsg@endcode, and queues outgoing datagrams until
+                   ///< @code flush()@endcode sends them with @code sendmmsg@endcode.
+        kIoUring,  ///< Linux 6.0+ only. Receives with a multishot @code recvmsg@endcode into
+                   ///< buffers lent to the kernel, and queues outgoing datagrams until
+                   ///< @code flush()@endcode submits them all at once. Falls back to
+                   ///< @code kBatched@endcode if io_uring is not available.
+                   ///< See @code IoUring@endcode.
+    };
+
+    virtual ~Peer();
 
     /**
      * @brief   Starts the asynchronous @code receive@endcode loop.
      * @note    Requires the associated `io_context` to be running.
      * @note    Requires the Peer not to be in a degraded state. See protected constructor.
      */
-    void start() { receive(); }
+    virtual void start();
+
+    /**
+     * @brief   Selects the I/O backend of the Peer.
+     * @note    Must be called before @code start()@endcode.
+     * @note    Falls back to @code IoBackend::kAsio@endcode (with a warning) on platforms that do
+     *          not support the requested backend.
+     * @param   backend Backend to use
+     */
+    void setIoBackend(IoBackend backend);
+
+    [[nodiscard]] IoBackend getIoBackend() const { return _ioBackend; }
+
+    /**
+     * @brief   Enables UDP segmentation offload, so that the kernel splits and merges datagrams.
+     *
+     * - On send (GSO, @code UDP_SEGMENT@endcode): consecutive same-sized datagrams queued for the
+     *   same target are given to the kernel as a single buffer, cut in datagrams by the kernel (or
+     *   the network card).
+     * - On receive (GRO, @code UDP_GRO@endcode): the kernel can hand several datagrams from the
+     *   same sender in one buffer, which is split back into its datagrams.
+     *
+     * Each direction falls back to plain datagrams if the kernel does not support it, or if a
+     * segmented send fails.
+     *
+     * @note    Linux only, requires @code IoBackend::kBatched@endcode. Must be called before
+     *          @code start()@endcode.
+     * @param   enabled Whether to enable the offload
+     */
+    void setUdpOffload(bool enabled);
+
+    /**
+     * @return  Whether UDP offload was requested (cf. @code setUdpOffload()@endcode).
+     */
+    [[nodiscard]] bool isUdpOffloadRequested() const { return _isUdpOffloadRequested; }
+
+    /**
+     * @return  Whether segmented sends (GSO) are currently used.
+     */
+    [[nodiscard]] bool isGsoEnabled() const
+    {
+        return _isGsoEnabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @return  Whether coalesced receptions (GRO) are currently used.
+     */
+    [[nodiscard]] bool isGroEnabled() const { return _isGroEnabled; }
+
+    /**
+     * @brief   Sends every datagram queued since the last flush.
+     *
+     * Does nothing with @code IoBackend::kAsio@endcode, which sends datagrams right away.
+     * @code Server::update@endcode and @code Client::update@endcode flush automatically, as does
+     * the I/O thread after handling a batch of received datagrams. Call this at the end of a tick
+     * if packets are sent after the update.
+     */
+    virtual void flush();
 
     /**
      * @brief   Shuts down and closes the Peer's socket.
      * @note    Peer will switch to a degraded state unless @code server()@endcode or
      *          @code client()@endcode is called.
+     * @note    With the io_uring backend, the ring is torn down by the thread running the
+     *          associated `io_context`, and this waits for it: the `io_context` must still be run,
+     *          unless it is stopped.
      */
-    void stop();
+    virtual void stop();
 
     /**
      * @brief   Sends raw bytes to a specific target.
      *
+     * The datagram can be given in two parts, sent with a single scatter-gather send: the data,
+     * then a payload shared with other datagrams (cf. @code Packet::share()@endcode), which is
+     * never copied.
+     *
      * @param   target  Target to send the data to
      * @param   data    Data to send (raw bytes)
+     * @param   payload Bytes sent right after the data, if any
      * @note    This is a fire-and-forget operation. No delivery guarantee at this level (managed by
      *          RUDP, Session).
+     * @note    With any other backend than @code IoBackend::kAsio@endcode, the data is only sent on
+     *          the next @code flush()@endcode.
      */
     void sendToTarget(const udp::endpoint& target,
-                      std::shared_ptr<ByteBuffer> data);
+                      std::shared_ptr<ByteBuffer> data,
+                      std::shared_ptr<const ByteBuffer> payload = nullptr);
 
     /**
      * @return  The local port the Peer is bound to.
@@ -88,18 +182,27 @@ protected:
      *          @code client()@endcode to initialize the Peer.
      * @param   context Asio I/O context
      */
-    explicit Peer(asio::io_context& context)
-        : _context(context),
-          _socket(context)
-    {
-    }
+    explicit Peer(asio::io_context& context);
+
+    /**
+     * @brief   Same as above, but the Peer accounts its traffic in the metrics of another one (cf.
+     *          @code getNetworkMetrics()@endcode), which must outlive it.
+     * @param   context Asio I/O context
+     * @param   metrics Metrics to account the traffic in
+     */
+    Peer(asio::io_context& context,
+         stat::NetworkMetrics& metrics);
 
     /**
      * @brief   Server mode.
      *
-     * @param   port    Port the server will listen to
+     * @param   port        Port the server will listen to
+     * @param   reusePort   Whether other sockets can bind the same port
+     *                      (@code SO_REUSEPORT@endcode), the kernel then spreads the remote peers
+     *                      between them. Linux only.
      */
-    void server(unsigned short port);
+    void server(unsigned short port,
+                bool reusePort = false);
 
     /**
      * @brief   Client mode.
@@ -111,24 +214,125 @@ protected:
     /**
      * @brief   Callback triggered when raw bytes are received.
      * @param   sender  The endpoint that sent the data
-     * @param   data    The raw data received (raw bytes)
+     * @param   data    The raw data received (raw bytes). The buffer goes back to the datagram pool
+     *                  once every copy of it (including the Packets viewing it) is destroyed.
      */
     virtual void onReceive(const udp::endpoint& sender,
-                           std::shared_ptr<ByteBuffer> data) = 0;
+                           PooledBuffer data) = 0;
 
 private:
+#if defined(__linux__)
+    friend class IoUring;
+#endif
+
+    struct OutgoingDatagram
+    {
+        udp::endpoint target;
+        std::shared_ptr<ByteBuffer> data;
+        std::shared_ptr<const ByteBuffer> payload;  ///< Shared tail of the datagram, if any.
+
+        [[nodiscard]] size_t size() const { return data->size() + (payload ? payload->size() : 0); }
+    };
+
     asio::io_context& _context;
     udp::socket _socket;
     udp::endpoint _tmpEndpoint;
-    std::array<char, BUFFER_SIZE> _receptionBuffer{};
+    BufferPool::Ptr _receptionPool = BufferPool::create(RECEPTION_POOL_SIZE, BUFFER_SIZE);
+    BufferPool::Ptr _datagramPool = BufferPool::create(DATAGRAM_POOL_SIZE, DATAGRAM_BUFFER_SIZE);
+    PooledBuffer _receptionBuffer;
+
+    IoBackend _ioBackend = IoBackend::kAsio;
+    std::array<PooledBuffer, RECEIVE_BATCH_SIZE> _receptionBatch;
+    std::vector<OutgoingDatagram> _outgoingDatagrams;
+    std::mutex _outgoingMutex;
+
+    bool _isUdpOffloadRequested = false;
+    std::atomic<bool> _isGsoEnabled = false;
+    bool _isGroEnabled = false;
 
 #if defined(RTNT_TESTS)
     std::atomic<uint8_t> _simulatedPacketLossPercentage = 0;
 #endif
 
-    stat::NetworkMetrics _networkMetrics;
+    stat::NetworkMetrics _ownNetworkMetrics;
+    stat::NetworkMetrics& _networkMetrics;  ///< Own metrics, or the ones given on construction
+
+#if defined(__linux__)
+    std::unique_ptr<IoUring> _ioUring;  ///< Last, so that it is destroyed first.
+#endif
 
     void receive();
+
+    /**
+     * @brief   Hands a datagram to asio, which sends it as soon as the socket is writable.
+     */
+    void asyncSend(const udp::endpoint& target,
+                   std::shared_ptr<ByteBuffer> data,
+                   std::shared_ptr<const ByteBuffer> payload);
+
+    /**
+     * @return  A reception buffer from the pool, accounting for pool misses.
+     */
+    PooledBuffer acquireReceptionBuffer();
+
+    /**
+     * @brief   Hands a received datagram to @code onReceive@endcode, copied into a buffer of the
+     *          datagram pool: the full-size reception buffer goes back to its pool right away,
+     *          instead of being held until every packet of the datagram is handled. A datagram too
+     *          large for the datagram pool is handed in its reception buffer.
+     */
+    void deliverDatagram(const udp::endpoint& sender,
+                         PooledBuffer datagram);
+
+    /**
+     * @brief   Sets the "don't fragment" bit on the datagrams of the socket, where the platform
+     *          allows it, so that path MTU probes larger than the path are dropped instead of being
+     *          fragmented (cf. @code MtuProber@endcode).
+     *
+     * On Linux, the path MTU cached by the kernel is ignored: the sessions search it themselves.
+     */
+    void disableFragmentation();
+
+#if defined(__linux__)
+    /**
+     * @brief   Enables GRO on the socket and checks that the kernel supports GSO.
+     */
+    void enableUdpOffload();
+
+    /**
+     * @brief   Counts how many consecutive datagrams can be sent as a single segmented (GSO) send.
+     *
+     * The kernel cuts a segmented send in equal parts, so the datagrams must go to the same target
+     * and have the same size, except the last one that can be smaller.
+     *
+     * @param   datagrams   Datagrams to send
+     * @param   first       Index of the first datagram of the run
+     * @param   maxVectors  Maximum number of I/O vectors the run can use (each datagram uses one,
+     *                      or two with a shared payload)
+     * @return  The number of datagrams in the run (at least @code 1@endcode).
+     */
+    static size_t countSegments(const std::vector<OutgoingDatagram>& datagrams,
+                                size_t first,
+                                size_t maxVectors);
+
+    /**
+     * @brief   Waits for the socket to be readable, then drains it with @code recvmmsg@endcode.
+     */
+    void receiveBatch();
+
+    /**
+     * @brief   Reads every pending datagram, @code RECEIVE_BATCH_SIZE@endcode per syscall.
+     */
+    void drainSocket();
+
+    /**
+     * @brief   Sends datagrams with as few @code sendmmsg@endcode calls as possible.
+     *
+     * If the socket send buffer is full, the remaining datagrams are handed to asio instead of
+     * being dropped.
+     */
+    void sendBatch(std::vector<OutgoingDatagram>& datagrams);
+#endif
 };
 
 }  // namespace rtnt::core
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+
+#include "packet.hpp"
+
+namespace rtnt::core {
+
+/**
+ * @class   ReceiveHistory
+ * @brief   Sliding bitmap of the Sequence IDs received from the remote peer.
+ *
+ * The window covers the @code packet::MAX_PACKET_HISTORY_SIZE@endcode Sequence IDs up to the
+ * highest one received (the head). The reception of an ID is stored in the bit
+ * @code sequenceId % MAX_PACKET_HISTORY_SIZE@endcode, so that checking for a duplicate, or
+ * recording a reception, is O(1). When the head moves forward, the bits of the IDs that slide out
+ * of the window are cleared.
+ *
+ * A second bitmap keeps the received IDs the remote peer must be told about explicitly
+ * (@code RICH_ACK@endcode), as the 32-bit bitfield of the headers does not reach them anymore. IDs
+ * received when already too old for the window are kept aside until then.
+ *
+ * Sequence IDs are compared with serial number arithmetic, so the window keeps working when they
+ * wrap around.
+ */
+class ReceiveHistory final
+{
+public:
+    /**
+     * @return  @code true@endcode if no packet has been received yet.
+     */
+    [[nodiscard]] bool isEmpty() const { return !_hasReceived; }
+
+    /**
+     * @return  The highest Sequence ID received (the head of the window).
+     */
+    [[nodiscard]] packet::AcknowledgeId getHead() const { return _head; }
+
+    /**
+     * @return  The reception status of the 32 Sequence IDs preceding the head (bit @code i@endcode
+     *          stands for @code head - (i + 1)@endcode), as written in the headers.
+     */
+    [[nodiscard]] packet::AcknowledgeBitfield getBitfield() const;
+
+    /**
+     * @return  @code true@endcode if the Sequence ID has been received.
+     */
+    [[nodiscard]] bool contains(packet::SequenceId sequenceId) const;
+
+    /**
+     * @return  @code true@endcode if the Sequence ID is too old for the window: whether it has been
+     *          received is not known anymore.
+     */
+    [[nodiscard]] bool isTooOld(packet::SequenceId sequenceId) const;
+
+    /**
+     * @brief   Records the reception of a Sequence ID. The head moves forward if it is newer.
+     * @param   sequenceId  Received Sequence ID. If too old (cf. @code isTooOld@endcode), it is
+     *                      only marked as to be acknowledged in the next @code RICH_ACK@endcode.
+     */
+    void record(packet::SequenceId sequenceId);
+
+    /**
+     * @brief   Marks a received Sequence ID as to be acknowledged in the next
+     *          @code RICH_ACK@endcode. Marking it several times has no effect.
+     */
+    void markPendingAck(packet::SequenceId sequenceId);
+
+    /**
+     * @return  @code true@endcode if there are Sequence IDs to acknowledge in a
+     *          @code RICH_ACK@endcode.
+     */
+    [[nodiscard]] bool hasPendingAcks() const { return _pendingAckCount != 0; }
+
+    /**
+     * @brief   Takes the oldest Sequence IDs marked as to be acknowledged, starting with the ones
+     *          too old for the window.
+     * @param   acks        Container the Sequence IDs are appended to, from the oldest
+     * @param   maxCount    Maximum number of Sequence IDs to take
+     */
+    void takePendingAcks(std::deque<packet::SequenceId>& acks,
+                         size_t maxCount);
+
+private:
+    static constexpr size_t WORD_COUNT = packet::MAX_PACKET_HISTORY_SIZE / 64;
+
+    using Bitmap = std::array<uint64_t, WORD_COUNT>;
+
+    bool _hasReceived = false;
+    packet::AcknowledgeId _head = 0;
+    Bitmap _received{};
+    Bitmap _pendingAcks{};
+    std::deque<packet::SequenceId> _oldPendingAcks;  ///< Received when already too old
+    size_t _pendingAckCount = 0;  ///< In the bitmap and in @code _oldPendingAcks@endcode
+
+    [[nodiscard]] static size_t getBit(const packet::SequenceId sequenceId)
+    {
+        return sequenceId & (packet::MAX_PACKET_HISTORY_SIZE - 1);
+    }
+
+    [[nodiscard]] static bool test(const Bitmap& bitmap,
+                                   const size_t bit)
+    {
+        return (bitmap[bit / 64] >> (bit % 64) & 1) != 0;
+    }
+
+    /**
+     * @brief   Clears the bits of @code count@endcode Sequence IDs, from @code first@endcode.
+     */
+    void clear(packet::SequenceId first,
+               size_t count);
+};
+
+}  // namespace rtnt::core
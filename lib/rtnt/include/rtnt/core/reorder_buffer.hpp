@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "packet.hpp"
+
+namespace rtnt::core {
+
+/**
+ * @class   ReorderBuffer
+ * @brief   Delivers the ordered packets of a channel in order, buffering the ones received ahead
+ *          of the next expected Order ID in a ring indexed by their Order ID.
+ *
+ * A buffered packet lives in the slot @code orderId % capacity@endcode, and a parallel bitmap tells
+ * which slots are occupied. Buffering a packet is O(1), and once the missing packet arrives, the
+ * consecutive ones are popped linearly from the ring.
+ *
+ * The ring is only allocated on the first gap, then doubles (up to
+ * @code packet::MAX_REORDER_BUFFER_SIZE@endcode) when a packet arrives further ahead than it can
+ * hold.
+ *
+ * Order IDs are compared with serial number arithmetic, so the window keeps working when they wrap
+ * around.
+ */
+class ReorderBuffer final
+{
+public:
+    enum class Result : uint8_t
+    {
+        kDelivered,  ///< The packet was the next expected one (and may have released others).
+        kBuffered,   ///< The packet is ahead of the next expected one, it waits for the gap.
+        kDuplicate,  ///< The packet was already delivered or buffered, it is dropped.
+        kTooFar,     ///< The packet is too far ahead to be buffered, it is dropped.
+    };
+
+    ReorderBuffer() = default;
+
+    /**
+     * @param   nextExpected    Order ID of the first packet to deliver
+     */
+    explicit ReorderBuffer(const packet::OrderId nextExpected)
+        : _nextExpected(nextExpected)
+    {
+    }
+
+    /**
+     * @brief   Receives an ordered packet.
+     * @param   orderId         Order ID of the packet
+     * @param   packet          The packet
+     * @param   readyPackets    Packets that can be handled by the user, in order. The packet, and
+     *                          the buffered ones following it, are appended when it is the next
+     *                          expected one.
+     */
+    Result receive(packet::OrderId orderId,
+                   Packet&& packet,
+                   std::vector<Packet>& readyPackets);
+
+    /**
+     * @return  Whether a packet of this Order ID is too far ahead to be buffered (cf.
+     *          @code Result::kTooFar@endcode).
+     */
+    [[nodiscard]] bool isTooFar(const packet::OrderId orderId) const
+    {
+        const auto distance = static_cast<int32_t>(orderId - _nextExpected);
+
+        return distance > 0 && static_cast<size_t>(distance) >= packet::MAX_REORDER_BUFFER_SIZE;
+    }
+
+    /**
+     * @return  The Order ID of the next packet to deliver.
+     */
+    [[nodiscard]] packet::OrderId getNextExpected() const { return _nextExpected; }
+
+    /**
+     * @return  The number of buffered packets.
+     */
+    [[nodiscard]] size_t size() const { return _size; }
+
+    [[nodiscard]] size_t capacity() const { return _slots.size(); }
+
+private:
+    std::vector<Packet> _slots;
+    std::vector<uint64_t> _occupancy;  ///< One bit per slot.
+    packet::OrderId _nextExpected = 0;
+    size_t _size = 0;
+
+    [[nodiscard]] size_t getSlot(const packet::OrderId orderId) const
+    {
+        return orderId & (_slots.size() - 1);
+    }
+
+    [[nodiscard]] bool isOccupied(const size_t slot) const
+    {
+        return (_occupancy[slot / 64] >> (slot % 64) & 1) != 0;
+    }
+
+    /**
+     * @brief   Grows the ring until it can hold a packet @code distance@endcode Order IDs ahead of
+     *          the next expected one, moving every buffered packet to its new slot.
+     */
+    void grow(size_t distance);
+};
+
+}  // namespace rtnt::core
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+using namespace std::chrono;
+
+/**
+ * @class   RttEstimator
+ * @brief   Computes the retransmission timeout (RTO) of a session from its RTT samples, as
+ *          described by RFC 6298.
+ *
+ * The estimator keeps a smoothed RTT (SRTT) and the variation of the RTT (RTTVAR):
+ * - First sample R: SRTT = R, RTTVAR = R / 2
+ * - Next samples: RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, then SRTT = 7/8 SRTT + 1/8 R
+ *
+ * The RTO is SRTT + 4 RTTVAR, bounded by @code packet::MIN_RESEND_TIMEOUT@endcode and
+ * @code packet::MAX_RESEND_TIMEOUT@endcode. It is also at least SRTT +
+ * @code packet::MAX_ACK_DELAY@endcode, as the samples taken from ACKs sent along other packets do
+ * not account for the delayed ACKs of a quiet peer. Until the first sample, it is
+ * @code packet::INITIAL_RESEND_TIMEOUT@endcode.
+ *
+ * @note    Samples must only be taken from packets that were never retransmitted (Karn's
+ *          algorithm): the ACK of a retransmitted packet cannot tell which transmission it
+ *          acknowledges.
+ */
+class RttEstimator final
+{
+public:
+    /**
+     * @brief   Updates the estimation with a new RTT sample.
+     */
+    void addSample(microseconds rtt);
+
+    /**
+     * @return  @code true@endcode if at least one sample has been taken.
+     */
+    [[nodiscard]] bool hasSample() const { return _hasSample; }
+
+    [[nodiscard]] microseconds getSmoothedRtt() const { return _smoothedRtt; }
+    [[nodiscard]] microseconds getRttVariation() const { return _rttVariation; }
+
+    /**
+     * @return  The retransmission timeout of a packet sent for the first time.
+     */
+    [[nodiscard]] microseconds getRetransmitTimeout() const { return _retransmitTimeout; }
+
+    /**
+     * @brief   Exponential backoff: every retransmission of a packet doubles its timeout, up to
+     *          @code packet::MAX_RESEND_TIMEOUT@endcode.
+     * @param   retries Number of times the packet has already been retransmitted
+     * @return  The timeout after which the packet must be retransmitted again.
+     */
+    [[nodiscard]] microseconds getRetransmitTimeout(uint8_t retries) const;
+
+    /**
+     * @return  The timeout of a packet the remote peer answers right away (e.g. a path MTU probe):
+     *          the retransmission timeout, without room for a delayed ACK.
+     */
+    [[nodiscard]] microseconds getAnswerTimeout() const { return _answerTimeout; }
+
+private:
+    bool _hasSample = false;
+    microseconds _smoothedRtt{0};
+    microseconds _rttVariation{0};
+    microseconds _retransmitTimeout = packet::INITIAL_RESEND_TIMEOUT;
+    microseconds _answerTimeout = packet::INITIAL_RESEND_TIMEOUT;
+};
+
+}  // namespace rtnt::core
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "packet.hpp"
+
+namespace rtnt::core {
+
+using namespace std::chrono;
+
+struct SentPacketInfo final
+{
+    Packet packet;  ///< Payload shared with its queued copies (cf. @code Packet::share()@endcode)
+    time_point<steady_clock> sentTime;  ///< Last transmission
+    packet::SequenceId sequenceId = 0;
+    packet::OrderId orderId = 0;
+    uint8_t retries =
+        0;  // fixme: Careful because if the maximum limit is greater than this, then on est foutus
+    bool isInFlight = false;  ///< Transmitted and not lost since (not waiting in the send queue)
+    /// Rank of the last transmission among the reliable ones of the session, from 1 (0 if not
+    /// transmitted yet). Sequence IDs are assigned when queued, not in the order on the wire.
+    uint64_t transmissionId = 0;
+    /// Wire-format datagram of the last transmission, if the packet was alone in it. Reused by
+    /// the next retransmission, with its ACK fields patched. Only the header if the payload was
+    /// gathered (cf. @code Session::setGatherSendFunction()@endcode).
+    std::shared_ptr<ByteBuffer> datagram = nullptr;
+};
+
+/**
+ * @class   SentPacketWindow
+ * @brief   Reliable packets waiting for an acknowledgement, stored in a ring indexed by their
+ *          Sequence ID.
+ *
+ * A packet lives in the slot @code sequenceId % capacity@endcode, and a parallel bitmap tells which
+ * slots are occupied. Inserting, finding and erasing a packet are O(1) and never allocate, and
+ * iterating only visits the occupied slots (64 slots are skipped at once when they are all free).
+ *
+ * The ring starts small and doubles (up to @code packet::MAX_SENT_PACKET_WINDOW_SIZE@endcode) when
+ * the Sequence IDs in flight span more slots than it has. Unreliable packets take Sequence IDs too,
+ * so a packet that waits long for its ACK under heavy traffic may span more: beyond the maximum,
+ * the packets whose slot is taken spill into a map.
+ */
+class SentPacketWindow final
+{
+public:
+    SentPacketWindow();
+
+    /**
+     * @brief   Stores a packet in the slot of its Sequence ID, or in the overflow map if the slot
+     *          is taken and the ring cannot grow anymore.
+     * @param   info    Packet to store
+     */
+    void insert(SentPacketInfo info);
+
+    /**
+     * @return  The packet with the given Sequence ID, or @code nullptr@endcode if it is not in the
+     *          window.
+     */
+    [[nodiscard]] SentPacketInfo* find(packet::SequenceId sequenceId);
+
+    /**
+     * @brief   Removes the packet with the given Sequence ID, if it is in the window.
+     * @return  @code true@endcode if a packet was removed.
+     */
+    bool erase(packet::SequenceId sequenceId);
+
+    /**
+     * @brief   Removes every packet acknowledged by a bitfield (bit @code i@endcode acknowledges
+     *          @code acknowledgeId - (i + 1)@endcode).
+     * @return  The number of packets removed.
+     */
+    size_t erase(packet::AcknowledgeId acknowledgeId,
+                 packet::AcknowledgeBitfield bitfield);
+
+    /**
+     * @brief   Same as above, but calls a function on every packet right before removing it.
+     * @param   function    Function signature: @code void(SentPacketInfo&)@endcode
+     */
+    template <typename Function>
+    size_t erase(const packet::AcknowledgeId acknowledgeId,
+                 packet::AcknowledgeBitfield bitfield,
+                 Function&& function)
+    {
+        size_t erased = 0;
+
+        while (bitfield != 0) {
+            const packet::SequenceId sequenceId = acknowledgeId - (std::countr_zero(bitfield) + 1);
+
+            if (SentPacketInfo* info = find(sequenceId)) {
+                function(*info);
+                erase(sequenceId);
+                erased++;
+            }
+            bitfield &= bitfield - 1;
+        }
+        return erased;
+    }
+
+    /**
+     * @brief   Calls a function on every packet in the window, in slot order, then on the ones of
+     *          the overflow map.
+     * @param   function    Function signature: @code bool(SentPacketInfo&)@endcode. Iteration stops
+     *                      as soon as it returns @code false@endcode.
+     * @return  @code false@endcode if the iteration was stopped.
+     */
+    template <typename Function>
+    bool forEach(Function&& function)
+    {
+        for (size_t word = 0; word < _occupancy.size(); word++) {
+            uint64_t bits = _occupancy[word];
+
+            while (bits != 0) {
+                const size_t slot = word * 64 + static_cast<size_t>(std::countr_zero(bits));
+
+                if (!function(_slots[slot])) {
+                    return false;
+                }
+                bits &= bits - 1;
+            }
+        }
+        for (auto& [sequenceId, info] : _overflow) {
+            if (!function(info)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    [[nodiscard]] size_t size() const { return _size; }
+    [[nodiscard]] bool empty() const { return _size == 0; }
+    [[nodiscard]] size_t capacity() const { return _slots.size(); }
+
+private:
+    std::vector<SentPacketInfo> _slots;
+    std::vector<uint64_t> _occupancy;  ///< One bit per slot.
+    /// Packets whose slot was taken once the ring reached its maximum size.
+    std::unordered_map<packet::SequenceId, SentPacketInfo> _overflow;
+    size_t _size = 0;  ///< Packets in the ring and in the overflow map.
+
+    [[nodiscard]] size_t getSlot(const packet::SequenceId sequenceId) const
+    {
+        return sequenceId & (_slots.size() - 1);
+    }
+
+    [[nodiscard]] bool isOccupied(const size_t slot) const
+    {
+        return (_occupancy[slot / 64] >> (slot % 64) & 1) != 0;
+    }
+
+    /**
+     * @brief   Doubles the capacity of the ring, moving every packet to its new slot.
+     */
+    void grow();
+};
+
+}  // namespace rtnt::core
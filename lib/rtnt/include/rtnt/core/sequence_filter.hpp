@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+
+#include "packet.hpp"
+
+namespace rtnt::core {
+
+/**
+ * @class   SequenceFilter
+ * @brief   Remembers the newest Sequence ID received for each key of a channel, to drop the
+ *          @code Flag::kSequenced@endcode packets that arrive after a newer one.
+ *
+ * Keys are hashed into @code packet::SEQUENCE_FILTER_SIZE@endcode slots, each remembering a single
+ * key. When two keys share a slot, the last one received replaces the other: a stale packet of
+ * the evicted key is then accepted, as nothing is known about it anymore. A fresh packet is never
+ * dropped.
+ *
+ * Sequence IDs are compared with serial number arithmetic, so the filter keeps working when they
+ * wrap around.
+ */
+class SequenceFilter final
+{
+public:
+    /**
+     * @brief   Checks whether a sequenced packet is the newest of its key, and records it if so.
+     * @param   key         Key of the packet
+     * @param   sequenceId  Sequence ID of the packet
+     * @return  @code false@endcode if a newer packet with the same key has been received: this one
+     *          is stale and must be dropped.
+     */
+    bool accept(packet::SequenceKey key,
+                packet::SequenceId sequenceId);
+
+private:
+    struct Entry
+    {
+        packet::SequenceKey key = 0;
+        packet::SequenceId newestSequenceId = 0;
+        bool isUsed = false;
+    };
+
+    std::vector<Entry> _entries;
+};
+
+}  // namespace rtnt::core
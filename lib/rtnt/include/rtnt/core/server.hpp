@@ -1,12 +1,16 @@
 #pragma once
 
-#include <map>
-#include <ranges>
+#include <memory>
+#include <span>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "dispatcher.hpp"
 #include "peer.hpp"
 #include "session.hpp"
+#include "session_table.hpp"
+#include "timer_wheel.hpp"
 
 namespace rtnt::stat {
 
@@ -20,8 +24,12 @@ namespace rtnt::core {
  * @class   Server
  * @brief   Manages multiple client sessions and routes traffic (TCAS haha lol traffic traffic)
  *
- * The Server listens on a specific port and maintains a map of active Sessions.
+ * The Server listens on a specific port and maintains a table of active Sessions.
  * It routes incoming data from the Peer to the correct Session according to the sender's Endpoint.
+ * The I/O threads look the sessions up without locking (cf. @code SessionTable@endcode).
+ *
+ * The reception can be spread over several I/O threads (cf. @code setShardCount()@endcode): each
+ * shard has its own socket bound to the same port, its own thread and its own sessions.
  */
 class Server : public Peer
 {
@@ -34,6 +42,47 @@ class Server : public Peer
 public:
     explicit Server(asio::io_context& context,
                     unsigned short port);
+    ~Server() override;
+
+    /**
+     * @brief   Spreads the remote peers over several sockets bound to the same port
+     *          (@code SO_REUSEPORT@endcode), each one receiving on its own I/O thread.
+     *
+     * The kernel picks the socket of a remote peer from its address, so a session always lives in
+     * the same shard: each shard keeps its own sessions and timers, and sends through its own
+     * socket. The first shard is the Server itself, and runs on the given @code io_context@endcode.
+     * The others run their own, each one on a thread of its own. They use the I/O backend and UDP
+     * offload settings of the Server, and account their traffic in its metrics.
+     *
+     * The public API is the same whatever the number of shards: callbacks are still called by
+     * @code update()@endcode, on the main thread.
+     *
+     * @note    Linux only, other platforms keep a single shard (with a warning). Must be called
+     *          before @code start()@endcode.
+     * @param   count   Number of shards (@code 1@endcode by default)
+     */
+    void setShardCount(size_t count);
+
+    /**
+     * @return  The number of shards running (@code 1@endcode until @code start()@endcode).
+     */
+    [[nodiscard]] size_t getShardCount() const { return _shards.size(); }
+
+    /**
+     * @brief   Starts receiving, on every shard.
+     */
+    void start() override;
+
+    /**
+     * @brief   Sends every datagram queued since the last flush, on every shard (cf.
+     *          @code Peer::flush()@endcode).
+     */
+    void flush() override;
+
+    /**
+     * @brief   Closes the sockets of every shard, once the I/O threads of the shards are stopped.
+     */
+    void stop() override;
 
     /**
      * @brief   Sets the callback for when a remote Peer connects to the Server.
@@ -60,7 +109,14 @@ public:
     void onMessage(OnMessageFunction callback) { _onMessage = std::move(callback); }
 
     /**
-     * @brief   Main maintenance loop. Checks for timeouts.
+     * @brief   Main maintenance loop. Checks for timeouts, packs the messages sent since the last
+     *          update into datagrams (cf. @code Session::flush()@endcode), then flushes them.
+     *
+     * Sessions are not iterated: each one requests a wake-up when it has something to do
+     * (cf. @code Session::setWakeUpFunction()@endcode), and its timeout is checked when it could
+     * have expired. Both are scheduled in a timer wheel, so an update only looks at the sessions
+     * whose timers expired.
+     *
      * @param   timeout The duration after which a client is considered unresponsive and so, dead
      * @note    This should be called regularly (e.g., in a main game loop).
      */
@@ -74,14 +130,42 @@ public:
         _internal_sendTo(session, packetData);
     }
 
+    /**
+     * @brief   Sends a packet to every connected session.
+     *
+     * The packet is serialized once, and its payload is shared by all the sessions (cf.
+     * @code Packet::share()@endcode): each one only builds its own header in front of it.
+     */
     template <typename T>
     void broadcast(const T& packetData)
     {
         packet::verifyUserPacketData<T>();
 
-        std::lock_guard lock(_sessionsMutex);
-        for (auto& session : _sessions | std::views::values) {
-            _internal_sendTo(session, packetData);
+        Packet packetToSend = _internal_makePacket(packetData);
+
+        packetToSend.share();
+
+        for (const auto& shard : _shards) {
+            shard->sessions.forEach(
+                [&](const std::shared_ptr<Session>& session) { session->send(packetToSend); });
+        }
+    }
+
+    /**
+     * @brief   Sends a packet to the given sessions, serializing it once (cf.
+     *          @code broadcast(const T&)@endcode).
+     */
+    template <typename T>
+    void broadcast(const std::span<const std::shared_ptr<Session>> sessions,
+                   const T& packetData)
+    {
+        packet::verifyUserPacketData<T>();
+
+        Packet packetToSend = _internal_makePacket(packetData);
+
+        packetToSend.share();
+        for (const auto& session : sessions) {
+            session->send(packetToSend);
         }
     }
 
@@ -89,13 +173,43 @@ public:
 
 protected:
     void onReceive(const udp::endpoint& sender,
-                   std::shared_ptr<ByteBuffer> data) override;
+                   PooledBuffer data) override;
 
 private:
     friend class stat::Recorder;
 
-    std::map<udp::endpoint, std::shared_ptr<Session>> _sessions;
-    mutable std::mutex _sessionsMutex;
+    /**
+     * @struct  SessionTimer
+     * @brief   Timer of the server's wheel: either a wake-up requested by a session, or the next
+     *          check of its timeout.
+     */
+    struct SessionTimer
+    {
+        std::shared_ptr<Session> session;
+        bool isTimeoutCheck = false;
+    };
+
+    /**
+     * @struct  Shard
+     * @brief   A socket of the server, and the sessions of the remote peers it receives from.
+     */
+    struct Shard
+    {
+        Peer& peer;  ///< Receives the datagrams of the sessions, and sends theirs.
+
+        SessionTable sessions;  ///< Removed sessions are reclaimed by update().
+
+        TimerWheel<SessionTimer> timers;
+        std::mutex timersMutex;  ///< Always locked last (sessions may request wake-ups).
+    };
+
+    class ShardPeer;
+
+    std::vector<std::unique_ptr<asio::io_context>> _shardContexts;  ///< Shards but the first
+    std::vector<std::unique_ptr<ShardPeer>> _shardPeers;            ///< Shards but the first
+    std::vector<std::thread> _shardThreads;
+    std::vector<std::unique_ptr<Shard>> _shards;
+    size_t _requestedShardCount = 1;
 
     ThreadSafeQueue<Task> _eventQueue;
 
@@ -108,16 +222,49 @@ private:
     template <typename T>
     void _internal_sendTo(const std::shared_ptr<Session>& session,
                           const T& packetData)
+    {
+        Packet packetToSend = _internal_makePacket(packetData);
+
+        session->send(packetToSend);
+    }
+
+    /**
+     * @brief   Serializes a packet struct, along with the metadata of its type.
+     */
+    template <typename T>
+    static Packet _internal_makePacket(const T& packetData)
     {
         packet::verifyPacketData<T>();
 
         LOG_DEBUG("Server sending Packet #{} {}...", T::kId, packet::getName<T>());
 
         Packet packetToSend(T::kId, packet::getFlag<T>(), packet::getChannelId<T>());
+        packetToSend.setSequenceKey(packet::getSequenceKey(packetData));
+        packetToSend.setPriority(packet::getPriority<T>());
+        packetToSend.setLifetime(packet::getLifetime<T>());
         packetToSend << packetData;
-        session->send(packetToSend);
+        return packetToSend;
     }
 
+    /**
+     * @brief   Routes a datagram received by a shard to its session, creating it on a
+     *          @code CONNECT@endcode.
+     * @note    Called from the I/O thread of the shard.
+     */
+    void _internal_receive(Shard& shard,
+                           const udp::endpoint& sender,
+                           PooledBuffer data);
+
+    /**
+     * @brief   Creates the sockets and threads of the shards but the first one.
+     */
+    void _internal_startShards();
+
+    /**
+     * @brief   Stops the I/O threads of the shards but the first one, and waits for them.
+     */
+    void _internal_stopShardThreads();
+
     /**
      * @brief   Processes the events that have been received so far.
      * @note    This function MUST be called from the main thread. Not doing so would result in
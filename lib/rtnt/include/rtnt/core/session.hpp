@@ -1,10 +1,23 @@
 #pragma once
 
+#include <array>
 #include <asio/ip/udp.hpp>
 #include <chrono>
-#include <map>
+#include <deque>
+#include <span>
+#include <vector>
 
 #include "packet.hpp"
+#include "rtnt/core/congestion_controller.hpp"
+#include "rtnt/core/fragment_reassembler.hpp"
+#include "rtnt/core/mtu_prober.hpp"
+#include "rtnt/core/pacer.hpp"
+#include "rtnt/core/receive_history.hpp"
+#include "rtnt/core/reorder_buffer.hpp"
+#include "rtnt/core/rtt_estimator.hpp"
+#include "rtnt/core/sent_packet_window.hpp"
+#include "rtnt/core/sequence_filter.hpp"
+#include "rtnt/core/timer_wheel.hpp"
 #include "rtnt/stat/metrics.hpp"
 
 namespace rtnt::core {
@@ -18,14 +31,27 @@ using Id = uint32_t;
 
 }
 
-struct SentPacketInfo final
+/**
+ * @struct  QueuedMessage
+ * @brief   A message waiting for the next @code Session::flush()@endcode, with its assigned IDs.
+ */
+struct QueuedMessage final
 {
     Packet packet;
-    time_point<steady_clock> sentTime;
     packet::SequenceId sequenceId = 0;
     packet::OrderId orderId = 0;
-    uint8_t retries =
-        0;  // fixme: Careful because if the maximum limit is greater than this, then on est foutus
+    time_point<steady_clock> deadline = time_point<steady_clock>::max();  ///< Dropped past it
+};
+
+/**
+ * @struct  ChannelState
+ * @brief   Ordering state of a channel, in both directions.
+ */
+struct ChannelState final
+{
+    packet::OrderId nextLocalOrderId = 0;  ///< Order ID of the next ordered packet sent.
+    ReorderBuffer reorderBuffer;           ///< Ordered packets received.
+    SequenceFilter sequenceFilter;         ///< Newest sequenced packets received.
 };
 
 /**
@@ -40,6 +66,9 @@ struct SentPacketInfo final
 class Session
 {
     using SendToPeerFunction = std::function<void(std::shared_ptr<ByteBuffer>)>;
+    using GatherSendFunction =
+        std::function<void(std::shared_ptr<ByteBuffer>, std::shared_ptr<const ByteBuffer>)>;
+    using WakeUpFunction = std::function<void(time_point<steady_clock>)>;
 
 public:
     explicit Session(udp::endpoint endpoint,
@@ -53,10 +82,11 @@ public:
      * - Protocol ID check (security)
      * - RUDP Sequence update
      *
-     * @param   rawData     The raw buffer received from the Peer
+     * @param   rawData     The raw buffer received from the Peer. Returned packets view their
+     *                      payload directly in it, no copy is made.
      * @returns Vector of valid packets that should be handled by the user.
      */
-    std::vector<Packet> handleIncoming(std::shared_ptr<ByteBuffer> rawData);
+    std::vector<Packet> handleIncoming(const PooledBuffer& rawData);
 
     template <typename T>
     void send(const T& packetData)
@@ -66,22 +96,95 @@ public:
         LOG_DEBUG("Session sending packet #{} {}...", T::kId, packet::getName<T>());
 
         Packet packet(T::kId, packet::getFlag<T>(), packet::getChannelId<T>());
+        packet.setSequenceKey(packet::getSequenceKey(packetData));
+        packet.setPriority(packet::getPriority<T>());
+        packet.setLifetime(packet::getLifetime<T>());
         packet << packetData;
         send(packet);
     }
 
     /**
-     * @brief   Encapsulates a user-defined Packet into a protocol frame (RUDP) and sends it.
+     * @brief   Assigns the RUDP IDs (Sequence ID, Order ID) of a user-defined Packet and queues it.
      *
-     * This attaches the header (Sequence ID, ACK ID, etc.) and gives the result to the Peer for network transmission.
+     * A @code Flag::kSequenced@endcode packet has no Order ID: that field carries its key instead
+     * (cf. @code packet::getSequenceKey()@endcode).
+     *
+     * The Packet is only given to the Peer on the next @code flush()@endcode, along with every
+     * other message queued in the meantime. An unreliable Packet with a lifetime (cf.
+     * @code packet::getLifetime()@endcode) is dropped if it is still queued when it expires.
+     *
+     * A Packet too large for a datagram is split into @code FRAGMENT@endcode messages (cf.
+     * @code packet::FragmentHeader@endcode), each acknowledged and retransmitted on its own. Peers
+     * older than fragments get it in a single datagram, which the network may fragment instead.
      */
     void send(Packet& packet);
 
     /**
      * @brief   Applies RUDP logic: reliable packets (resend logic) etc.
+     *
+     * Once the handshake negotiated a protocol version probing the path MTU
+     * (@code PMTU_PROTOCOL_VER@endcode), this also sends the path MTU probes (cf.
+     * @code MtuProber@endcode).
+     *
+     * A reliable packet is resent when its retransmission timeout expires. The timeout adapts to
+     * the measured RTT, and doubles on every retransmission of the packet (cf.
+     * @code RttEstimator@endcode). Retransmissions are scheduled in a timer wheel, so only the
+     * packets whose timeout expired are looked at.
+     *
+     * @note    Resent packets and ACKs are queued, they are sent on the next @code flush()@endcode.
      */
     void update();
 
+    /**
+     * @brief   Packs every queued message into as few datagrams as possible, and gives them to the
+     *          Peer.
+     *
+     * Messages are packed in order into @code BUNDLE@endcode datagrams of at most
+     * @code getMaxDatagramSize()@endcode bytes. Each bundle carries the ACK information once,
+     * and each message only keeps a small sub-header (cf. @code packet::BundleEntry@endcode).
+     * A message that ends up alone in its datagram is sent as a regular packet.
+     *
+     * Datagrams leave at the pace of the session (cf. @code Pacer@endcode), and those carrying
+     * reliable messages only while the congestion window allows (cf.
+     * @code CongestionController@endcode): unreliable messages behind a full window still go.
+     * The rest stays queued, and the session requests a wake-up for when it can be sent.
+     *
+     * Queued messages are sent by decreasing priority (cf. @code packet::Priority@endcode), then
+     * in the order they were queued. Expired messages are dropped before they are packed, so a
+     * backed up queue never delays the fresh ones behind stale ones.
+     */
+    void flush();
+
+    /**
+     * @brief   Sets the function called when the session needs an @code update()@endcode and a
+     *          @code flush()@endcode earlier than previously requested: a message was queued, a
+     *          retransmission or ACK timer was scheduled, or the session was marked as closed.
+     *
+     * This lets the owner of many sessions only update the ones that have something to do (cf.
+     * @code Server::update()@endcode). After an @code update()@endcode, the session requests its
+     * next wake-up itself.
+     *
+     * @note    The function is called with @code _mutex@endcode held: it must not call the session
+     *          back.
+     * @param   function    Function signature: @code void(time_point<steady_clock>)@endcode
+     */
+    void setWakeUpFunction(WakeUpFunction function);
+
+    /**
+     * @brief   Sets the function handing the Peer a datagram in two parts: the header built by the
+     *          session, then the payload of a shared Packet (cf. @code Packet::share()@endcode).
+     *
+     * A shared Packet sent alone in its datagram then goes without any copy of its payload, which
+     * is what a broadcast sends to every session (cf. @code Server::broadcast()@endcode). Without
+     * this function, or in a bundle, the payload is copied into the datagram.
+     *
+     * @note    The function is called with @code _mutex@endcode held: it must not call the session
+     *          back.
+     * @param   function    Function signature: @code void(std::shared_ptr<ByteBuffer> header,
+     *                      std::shared_ptr<const ByteBuffer> payload)@endcode
+     */
+    void setGatherSendFunction(GatherSendFunction function);
+
     /**
      * @brief   Marks the session as closed.
      * @note    This function does NOT remove the session from anywhere. It is up to the Peer child to do this.
@@ -116,28 +219,61 @@ public:
 
     [[nodiscard]] const stat::SessionMetrics& getSessionMetrics() const { return _sessionMetrics; }
 
+    /**
+     * @return  The protocol version spoken with the remote peer: the oldest of both versions,
+     *          negotiated during the handshake. Until then, @code PROTOCOL_VER@endcode.
+     */
+    [[nodiscard]] packet::ProtocolVersion getProtocolVersion() const
+    {
+        std::lock_guard lock(_mutex);
+        return _protocolVersion;
+    }
+
+    /**
+     * @return  The largest datagram the path to the remote peer carries: it bounds the bundles and
+     *          the fragments sent. Until the path MTU has been probed,
+     *          @code packet::MAX_BUNDLE_SIZE@endcode.
+     */
+    [[nodiscard]] size_t getMaxDatagramSize() const
+    {
+        std::lock_guard lock(_mutex);
+        return _maxDatagramSize;
+    }
+
 private:
     const session::Id _id;
 
     const udp::endpoint _endpoint;
     SendToPeerFunction _sendToPeerFunction;
+    GatherSendFunction _gatherSendFunction;
+    WakeUpFunction _wakeUpFunction;
+    time_point<steady_clock> _wakeUpTime = time_point<steady_clock>::max();  ///< Requested wake-up
 
     // RUDP state //
-    bool _hasReceivedRemotePacket = false;
-
     packet::SequenceId _localSequenceId = 0;
     // packet::SequenceId _remoteSequenceId = 0;
 
-    packet::AcknowledgeId _remoteAcknowledgeId = 0;
-    packet::AcknowledgeBitfield _remoteAcknowledgeBitfield = 0;
-
-    std::map<packet::ChannelId, packet::OrderId> _localOrderIds{};
-    std::map<packet::ChannelId, packet::OrderId> _nextExpectedOrderIds{};
-
-    std::map<packet::ChannelId, std::map<packet::OrderId, Packet>> _reorderBuffers;
-    std::map<packet::SequenceId, SentPacketInfo> _sentPackets;
-    std::deque<packet::AcknowledgeId> _oldPacketHistory;
-    std::vector<packet::SequenceId> _pendingRichAcks;
+    ReceiveHistory _receiveHistory;
+    packet::ProtocolVersion _protocolVersion = PROTOCOL_VER;
+
+    MtuProber _mtuProber;
+    size_t _maxDatagramSize = packet::MAX_BUNDLE_SIZE;
+    size_t _probeSize = 0;  ///< Size of the probe waiting for its answer, 0 if none
+    time_point<steady_clock> _probeTime = time_point<steady_clock>::max();  ///< Next probe
+
+    std::array<ChannelState, packet::CHANNEL_COUNT> _channels;
+    FragmentReassembler _reassembler;
+    SentPacketWindow _sentPackets;
+    RttEstimator _rttEstimator;
+    CongestionController _congestionController;
+    Pacer _pacer;
+    size_t _blockedReliableBytes = 0;  ///< Reliable bytes the window held back on the last flush
+    TimerWheel<packet::SequenceId> _resendTimers;
+    uint64_t _transmissionCount = 0;    ///< Reliable transmissions, the last one's rank
+    uint64_t _largestAckedTransmissionId = 0;  ///< Latest transmission acknowledged, 0 if none
+    /// Sequence IDs of the reliable transmissions not checked for loss yet, in transmission order.
+    std::deque<packet::SequenceId> _uncheckedTransmissions;
+    std::vector<QueuedMessage> _outgoingMessages;
     uint32_t _packetsSinceLastAck = 0;
     mutable std::mutex _mutex;
 
@@ -156,56 +292,191 @@ private:
      * This is the lowest-level sending function in the session.
      * It performs the following:
      * - Header construction: Populates the @code packet::Header@endcode fields.
-     * - ACK Piggybacking: Attaches the current @code _remoteAcknowledgeId@endcode and bitfield to
+     * - ACK Piggybacking: Attaches the head of @code _receiveHistory@endcode and its bitfield to
      *                     the header, ensuring that every outgoing packet helps acknowledge
      *                     received data.
      *                     Sets the @code kHasAck@endcode flag if valid ACK data is present.
      * - Serialization: Combines the header and the packet payload into a contiguous
-     *                  @code ByteBuffer@endcode, handling network byte order conversion.
+     *                  @code ByteBuffer@endcode, handling network byte order conversion. The
+     *                  payload of a shared Packet is not copied: it follows the header buffer (cf.
+     *                  @code setGatherSendFunction()@endcode).
      * - Transmission: Invokes the @code _sendToPeerFunction@endcode to hand the buffer off to the
      *                 network socket.
      *
+     * A reliable packet keeps its datagram (cf. @code SentPacketInfo::datagram@endcode): its
+     * retransmissions only patch the ACK fields of the header, in place if the Peer is done with
+     * the buffer, or in a copy otherwise.
+     *
      * @param   packet      The high-level packet object containing metadata and payload
      * @param   sequenceId  The assigned Sequence ID for this frame
      * @param   orderId     The assigned Order ID for this frame (0 if unordered)
+     * @param   info        The reliable packet being sent, if any
      */
     void rawSend(Packet& packet,
                  packet::SequenceId sequenceId,
-                 packet::OrderId orderId);
+                 packet::OrderId orderId,
+                 SentPacketInfo* info = nullptr);
+
+    /**
+     * @brief   Sends the datagram a reliable packet was last transmitted in again, with up to date
+     *          ACK fields (cf. @code rawSend()@endcode).
+     */
+    void _internal_retransmit(const Packet& packet,
+                              SentPacketInfo& info);
+
+    /**
+     * @brief   Constructs a @code BUNDLE@endcode datagram carrying several messages and transmits
+     *          it to the Peer.
+     *
+     * The header of the datagram carries the piggybacked ACK, then each message is written as a
+     * @code packet::BundleEntry@endcode followed by its payload.
+     *
+     * @param   messages    The messages to pack (at least two)
+     */
+    void bundleSend(std::span<const QueuedMessage> messages);
+
+    /**
+     * @brief   Hands a datagram to the Peer, and marks the piggybacked ACK as sent.
+     * @param   datagram    The wire-format datagram, or its header if a payload is given
+     * @param   payload     The shared payload following the header, if any
+     */
+    void transmit(std::shared_ptr<ByteBuffer> datagram,
+                  std::shared_ptr<const ByteBuffer> payload = nullptr);
+
+    /**
+     * @brief   Assigns a Sequence ID to a message and queues it. A reliable message is also kept
+     *          until it is acknowledged.
+     */
+    void _internal_queue(const Packet& packet,
+                         packet::OrderId orderId,
+                         time_point<steady_clock> now);
+
+    /**
+     * @brief   Packs the queued messages into datagrams (cf. @code flush()@endcode).
+     * @note    This function expects the caller to hold @code _mutex@endcode.
+     */
+    void _internal_flush();
+
+    /**
+     * @brief   Drops the expired messages of the queue, and sorts it by priority.
+     */
+    void _internal_prepareOutgoingMessages(time_point<steady_clock> now);
+
+    /**
+     * @return  The size a message takes in a bundle, which is what the congestion window counts.
+     */
+    static size_t getMessageSize(const Packet& message);
+
+    /**
+     * @brief   Puts a reliable message just transmitted in flight: its retransmission timeout and
+     *          RTT sample start now, and it counts in the congestion window.
+     */
+    void _internal_onTransmitted(const QueuedMessage& message,
+                                 time_point<steady_clock> now);
+
+    /**
+     * @brief   Removes an acknowledged reliable message from the congestion window, and records its
+     *          transmission for the loss detection. The caller erases it from
+     *          @code _sentPackets@endcode.
+     */
+    void _internal_onAcknowledged(const SentPacketInfo& info);
+
+    /**
+     * @brief   Removes a lost reliable message from the congestion window, before it is queued
+     *          again for retransmission.
+     */
+    void _internal_onLost(SentPacketInfo& info,
+                          time_point<steady_clock> now);
+
+    void _internal_updateCongestionMetrics();
+
+    /**
+     * @brief   Runs the RUDP reception logic on a single message: duplicate check, ACK tracking,
+     *          then ordering.
+     *
+     * A message is either a whole regular packet, or one of the messages of a @code BUNDLE@endcode.
+     * A @code FRAGMENT@endcode is stored until its message is complete (cf.
+     * @code FragmentReassembler@endcode). It is only acknowledged once stored.
+     *
+     * @param   header          The header of the message. For a bundled message, it is made of
+     *                          the bundle header and of the message's sub-header.
+     * @param   payload         The payload of the message (it views the received datagram)
+     * @param   readyPackets    Packets that are ready to be handled by the user
+     */
+    void _internal_handleMessage(const packet::Header& header,
+                                 const PooledBuffer& payload,
+                                 std::vector<Packet>& readyPackets);
+
+    /**
+     * @brief   Hands a received message to the user, through the sequencing or ordering logic of
+     *          its channel.
+     *
+     * @param   header          The header of the message. For a reassembled message, it carries
+     *                          the Sequence ID of its first fragment.
+     * @param   incomingPacket  The message
+     * @param   readyPackets    Packets that are ready to be handled by the user
+     */
+    void _internal_deliver(const packet::Header& header,
+                           Packet&& incomingPacket,
+                           std::vector<Packet>& readyPackets);
 
     /**
      * @brief   Updates the local RUDP tracking state (which we call the Sliding Window) based on a
      *          received Sequence ID.
      *
-     * This function manages the head (@code _remoteAcknowledgeId@endcode) and the tail
-     * (the bitfield) of the reception window.
-     *
-     * It handles three eventualities:
-     * - New head: The received ID is newer than the current head. The bitfield is shifted left.
-     *             Any set bits that "fall off" the left side of the 32-bit window during the shift
-     *             are moved into the @code _oldPacketHistory@endcode to maintain replay protection
-     *             for older packets.
-     * - Inside window: The received ID is older than head but in the 32-cell window.
-     *                  The corresponding bit in the bitfield is set.
-     * - Out of window: The received ID is too old for the bitfield. It is added directly to
-     *                  @code _oldPacketHistory@endcode.
+     * The reception is recorded in @code _receiveHistory@endcode, whose head moves forward if the
+     * received ID is newer. The headers acknowledge the head and the 32 IDs before it (the
+     * bitfield): if the received ID is older than that, it is marked for the next
+     * @code RICH_ACK@endcode.
      *
      * @param   sequenceId  The Sequence ID of the packet just received
      */
     void updateAcknowledgeInfo(packet::SequenceId sequenceId);
 
+    /**
+     * @brief   Sends the next path MTU probe, if it is time to. A probe still waiting for its
+     *          answer is considered as lost.
+     *
+     * Probes are sent on their own, outside of the send queue: they are few, and must not be
+     * bundled.
+     */
+    void _internal_probe(time_point<steady_clock> now);
+
+    /**
+     * @brief   Records the answer to a path MTU probe, and sends the next one right away.
+     * @param   probeSize   The size of the probe that got through
+     */
+    void _internal_onProbeAcknowledged(size_t probeSize);
+
     /**
      * @brief   Constructs and sends an acknowledgement packet (@code ACK@endcode or
      *          @code RICH_ACK@endcode) to the remote peer.
      *
      * This function decides which type of ACK to send based on the current state:
-     * - Standard ACK: If @code _oldPacketHistory@endcode is empty, sends a lightweight header-only
-     *                 packet containing just the highest ID and the 32-bit bitfield.
-     * - Rich ACK: If @code _oldPacketHistory@endcode contains data, sends a @code RICH_ACK@endcode
-     *             packet containing the history in the payload.
+     * - Standard ACK: If no ID is pending in @code _receiveHistory@endcode, sends a lightweight
+     *                 header-only packet containing just the highest ID and the 32-bit bitfield.
+     * - Rich ACK: If IDs are pending in @code _receiveHistory@endcode, sends
+     *             @code RICH_ACK@endcode packets listing them in their payload.
+     *
+     * The ACKs are queued. If other messages are already queued, no standard ACK is needed, since
+     * the datagrams carrying them will piggyback it.
      */
     void _internal_sendAck();
 
+    /**
+     * @brief   Calls the wake-up function if the given time is earlier than the wake-up already
+     *          requested (cf. @code setWakeUpFunction()@endcode).
+     */
+    void _internal_requestWakeUp(time_point<steady_clock> time);
+
+    /**
+     * @brief   Requests a wake-up for the earliest timer: retransmissions, delayed ACK, path MTU
+     *          probe, and messages held back by the pacer (or by the congestion window, once it has
+     *          room).
+     * @note    Newly queued messages request an immediate wake-up themselves.
+     */
+    void _internal_scheduleWakeUp();
+
     /**
      * @brief   Marks the session for closure.
      *
@@ -219,15 +490,15 @@ private:
      * @brief   Checks if a packet has already been received to prevent replay attacks or redundant
      *          processing.
      *
-     * 3 verifications are done:
-     * - Is it equal to the last received packet?
-     * - If within the last 32 packets, is the bit set in the bitfield?
-     * - If older than 32 packets, is it present in the @code _oldPacketHistory@endcode buffer?
+     * This is a single lookup in @code _receiveHistory@endcode. Whether a packet too old for the
+     * history was received is not known anymore: a reliable one was stalled while unreliable ones
+     * kept taking Sequence IDs, and is delivered rather than lost (an ordered channel still drops
+     * it if already delivered). An unreliable one is considered as a duplicate.
      *
-     * @param   sequenceId  The sequence ID to check
+     * @param   header  The header of the packet to check
      * @return  @code true@endcode if the packet is a duplicate, @code false@endcode otherwise.
      */
-    bool isDuplicate(packet::SequenceId sequenceId) const;
+    bool isDuplicate(const packet::Header& header) const;
 
     /**
      * @brief   Parses the payload of a @code kRichAck@endcode packet.
@@ -236,13 +507,25 @@ private:
      * from the local @code _sentPackets@endcode buffer.
      *
      * @see     rtnt::core::packet::internal::RichAck
-     * @param   rawData The raw buffer containing the packet payload
+     * @param   payload The payload of the packet
      * @param   header  The parsed header of the packet
      */
-    void checkForOldPackets(std::shared_ptr<ByteBuffer> rawData,
+    void checkForOldPackets(const PooledBuffer& payload,
                             const packet::Header& header);
 
-    void _updateRtt(milliseconds rtt);
+    /**
+     * @brief   Fast retransmit: resends the reliable packets that are still waiting for their ACK
+     *          while a reliable packet transmitted @code packet::FAST_RETRANSMIT_THRESHOLD@endcode
+     *          transmissions later has been acknowledged, without waiting for their timeout.
+     *
+     * Packets are compared by transmission, not by Sequence ID: priorities and the congestion
+     * window send the queued messages out of order. Each transmission is checked once, when the
+     * acknowledgements first go past it, so this costs O(1) per packet sent. Packets that have
+     * already been retransmitted are left to their timeout.
+     */
+    void _internal_detectLosses();
+
+    void _updateRtt(microseconds rtt);
 };
 
 }  // namespace rtnt::core
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <array>
+#include <asio/ip/udp.hpp>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace rtnt::core {
+
+using asio::ip::udp;
+
+class Session;
+
+/**
+ * @class   SessionTable
+ * @brief   Concurrent hash table of the sessions of a Server, keyed by their remote endpoint.
+ *
+ * Lookups (@code find()@endcode, @code forEach()@endcode) never lock: they probe an open addressing
+ * table of atomic entry pointers (linear probing), which is kept at most half full so that a probe
+ * always ends on an empty slot. Inserts and removals are serialized between themselves, but
+ * lookups never wait for them: a removed entry is replaced by a tombstone, and a table too full is
+ * copied into a larger one, published at once.
+ *
+ * A removed entry (or a replaced table) may still be read by a lookup that started before its
+ * removal. It is retired, and only freed by @code reclaim()@endcode once those lookups are over
+ * (epoch-based reclamation): each lookup registers in the current epoch, and
+ * @code reclaim()@endcode moves to the next epoch, then waits for the lookups registered in the
+ * previous one, which only last a few probes.
+ *
+ * @note    @code reclaim()@endcode must not be called from within @code forEach()@endcode, nor from
+ *          the I/O thread, which must never wait.
+ */
+class SessionTable final
+{
+public:
+    SessionTable();
+    ~SessionTable();
+
+    SessionTable(const SessionTable&) = delete;
+    SessionTable& operator=(const SessionTable&) = delete;
+
+    /**
+     * @return  The session of the given endpoint, or @code nullptr@endcode if there is none.
+     */
+    [[nodiscard]] std::shared_ptr<Session> find(const udp::endpoint& endpoint) const;
+
+    /**
+     * @brief   Inserts a session, unless its endpoint already has one.
+     * @return  The session of the endpoint: the given one, or the one it already had.
+     */
+    std::shared_ptr<Session> insert(const udp::endpoint& endpoint,
+                                    std::shared_ptr<Session> session);
+
+    /**
+     * @brief   Removes the session of an endpoint, if it is the given one. The entry is retired
+     *          until the next @code reclaim()@endcode.
+     * @return  Whether the session was removed.
+     */
+    bool erase(const udp::endpoint& endpoint,
+               const std::shared_ptr<Session>& session);
+
+    /**
+     * @brief   Calls a function on every session of the table. Sessions inserted or removed
+     *          meanwhile may or may not be visited.
+     * @param   function    Function signature: @code void(const std::shared_ptr<Session>&)@endcode
+     */
+    template <typename Function>
+    void forEach(Function&& function) const
+    {
+        const ReadGuard guard(*this);
+        const Table* table = _table.load();
+
+        for (size_t i = 0; i <= table->mask; i++) {
+            const Entry* entry = table->slots[i].load();
+
+            if (entry != nullptr && entry != &_tombstone) {
+                function(entry->session);
+            }
+        }
+    }
+
+    [[nodiscard]] size_t size() const { return _size.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief   Frees the entries and tables retired so far, once no lookup can read them anymore.
+     */
+    void reclaim();
+
+private:
+    struct Entry
+    {
+        udp::endpoint endpoint;
+        std::shared_ptr<Session> session;
+    };
+
+    struct Table
+    {
+        explicit Table(size_t capacity);
+
+        size_t mask;  ///< Capacity - 1 (a power of two)
+        std::unique_ptr<std::atomic<Entry*>[]> slots;
+    };
+
+    /**
+     * @class   SessionTable::ReadGuard
+     * @brief   Registers a lookup in the current epoch for its lifetime.
+     */
+    class ReadGuard final
+    {
+    public:
+        explicit ReadGuard(const SessionTable& table);
+        ~ReadGuard();
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        std::atomic<uint32_t>* _readers;
+    };
+
+    static Entry _tombstone;  ///< Marks a removed entry, so that probes go on past its slot.
+
+    std::atomic<Table*> _table;
+    std::atomic<size_t> _size = 0;
+
+    std::mutex _writeMutex;
+    size_t _tombstones = 0;
+    std::vector<std::unique_ptr<Entry>> _retiredEntries;
+    std::vector<std::unique_ptr<Table>> _retiredTables;
+
+    std::mutex _reclaimMutex;  ///< Epochs only move by one at a time.
+    std::atomic<uint64_t> _epoch = 0;
+    mutable std::array<std::atomic<uint32_t>, 2> _readers{};  ///< Lookups per epoch parity
+
+    /**
+     * @return  The slot the probes for the given endpoint start from.
+     */
+    static size_t getHomeSlot(const Table& table,
+                              const udp::endpoint& endpoint);
+
+    /**
+     * @brief   Copies the live entries into a new table, sized for @code minSize@endcode of them,
+     *          and retires the current one.
+     * @note    This function expects the caller to hold @code _writeMutex@endcode.
+     */
+    void _internal_grow(size_t minSize);
+};
+
+}  // namespace rtnt::core
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+using namespace std::chrono;
+
+/**
+ * @class   TimerWheel
+ * @brief   Hashed timing wheel: timers are stored in the slot of their deadline tick, so that
+ *          scheduling one is O(1), and advancing the wheel only visits the slots of the elapsed
+ *          ticks.
+ *
+ * A timer due in more than a revolution (@code TIMER_WHEEL_SIZE@endcode ticks) shares its slot with
+ * nearer ones: it is kept when the slot is visited, until the revolution of its deadline.
+ *
+ * Timers cannot be cancelled. Their owner checks, when they fire, whether they are still relevant
+ * (e.g. a retransmission timer firing for a packet acknowledged since is ignored).
+ *
+ * @tparam  Key Value given back when the timer fires
+ */
+template <typename Key>
+class TimerWheel final
+{
+public:
+    explicit TimerWheel(const time_point<steady_clock> start = steady_clock::now())
+        : _start(start)
+    {
+    }
+
+    /**
+     * @brief   Schedules a timer. A deadline already passed fires on the next tick.
+     */
+    void schedule(const time_point<steady_clock> deadline,
+                  Key key)
+    {
+        const uint64_t tick = std::max(getTick(deadline), _currentTick);
+        const size_t slot = tick & (TIMER_WHEEL_SIZE - 1);
+
+        _slots[slot].push_back({tick, std::move(key)});
+        _occupancy[slot / 64] |= 1ULL << (slot % 64);
+        _size++;
+    }
+
+    /**
+     * @brief   Fires every timer whose deadline has passed, and removes it from the wheel.
+     * @param   now         Current time
+     * @param   function    Function signature: @code void(Key&)@endcode. It may schedule new
+     *                      timers.
+     */
+    template <typename Function>
+    void advance(const time_point<steady_clock> now,
+                 Function&& function)
+    {
+        if (now < _start) {
+            return;
+        }
+
+        const auto elapsed = duration_cast<nanoseconds>(now - _start);
+        const auto lastTick = static_cast<uint64_t>(elapsed / TIMER_WHEEL_RESOLUTION);
+
+        if (lastTick < _currentTick) {
+            return;
+        }
+
+        std::vector<Key> expired;
+        // After a long pause, every slot is visited once.
+        const uint64_t count = std::min<uint64_t>(lastTick - _currentTick + 1, TIMER_WHEEL_SIZE);
+
+        for (uint64_t i = 0; i < count; i++) {
+            const size_t slot = (_currentTick + i) & (TIMER_WHEEL_SIZE - 1);
+            std::vector<Timer>& timers = _slots[slot];
+
+            for (size_t j = 0; j < timers.size();) {
+                if (timers[j].tick > lastTick) {  // Due in a later revolution.
+                    j++;
+                    continue;
+                }
+                expired.push_back(std::move(timers[j].key));
+                timers[j] = std::move(timers.back());
+                timers.pop_back();
+                _size--;
+            }
+            if (timers.empty()) {
+                _occupancy[slot / 64] &= ~(1ULL << (slot % 64));
+            }
+        }
+        _currentTick = lastTick + 1;
+
+        // Fired once the wheel is consistent, so that the function can schedule new timers.
+        for (Key& key : expired) {
+            function(key);
+        }
+    }
+
+    /**
+     * @return  The start of the next tick holding a timer, or @code std::nullopt@endcode if the
+     *          wheel is empty. The timers of that tick may be due in a later revolution: this is
+     *          the earliest time the next timer can fire.
+     */
+    [[nodiscard]] std::optional<time_point<steady_clock>> getNextExpiry() const
+    {
+        if (_size == 0) {
+            return std::nullopt;
+        }
+
+        const size_t first = _currentTick & (TIMER_WHEEL_SIZE - 1);
+
+        for (size_t i = 0; i < TIMER_WHEEL_SIZE;) {
+            const size_t slot = (first + i) & (TIMER_WHEEL_SIZE - 1);
+            const uint64_t bits = _occupancy[slot / 64] >> (slot % 64);
+
+            if (bits != 0) {
+                const auto offset = static_cast<size_t>(std::countr_zero(bits));
+
+                return _start + TIMER_WHEEL_RESOLUTION * (_currentTick + i + offset);
+            }
+            i += 64 - slot % 64;  // Skips to the next word of the bitmap.
+        }
+        return std::nullopt;
+    }
+
+    [[nodiscard]] size_t size() const { return _size; }
+    [[nodiscard]] bool empty() const { return _size == 0; }
+
+private:
+    struct Timer
+    {
+        uint64_t tick;
+        Key key;
+    };
+
+    time_point<steady_clock> _start;
+    uint64_t _currentTick = 0;  ///< First tick not advanced through yet.
+    std::array<std::vector<Timer>, TIMER_WHEEL_SIZE> _slots;
+    std::array<uint64_t, TIMER_WHEEL_SIZE / 64> _occupancy{};  ///< One bit per non-empty slot.
+    size_t _size = 0;
+
+    /**
+     * @return  The tick of a deadline, rounded up so that timers never fire early.
+     */
+    [[nodiscard]] uint64_t getTick(const time_point<steady_clock> deadline) const
+    {
+        if (deadline <= _start) {
+            return 0;
+        }
+
+        const auto elapsed = duration_cast<nanoseconds>(deadline - _start);
+
+        return static_cast<uint64_t>((elapsed + TIMER_WHEEL_RESOLUTION - nanoseconds(1)) /
+                                     TIMER_WHEEL_RESOLUTION);
+    }
+};
+
+}  // namespace rtnt::core
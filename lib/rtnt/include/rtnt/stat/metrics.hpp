@@ -28,6 +28,11 @@ struct NetworkMetrics
     std::atomic<uint64_t> totalBytesReceived = 0;
     std::atomic<uint64_t> totalPacketsSent = 0;
     std::atomic<uint64_t> totalPacketsReceived = 0;
+    std::atomic<uint64_t> totalSendCalls = 0;       ///< Send syscalls (or asio operations)
+    std::atomic<uint64_t> totalReceiveCalls = 0;    ///< Receive syscalls (or asio operations)
+    std::atomic<uint64_t> receptionPoolMisses = 0;  ///< Receptions that had to allocate a buffer
+    std::atomic<uint64_t> totalSegmentedDatagramsSent = 0;      ///< Datagrams sent through GSO
+    std::atomic<uint64_t> totalCoalescedDatagramsReceived = 0;  ///< Datagrams received through GRO
 };
 
 /**
@@ -36,11 +41,22 @@ struct NetworkMetrics
  */
 struct SessionMetrics
 {
-    std::atomic<uint32_t> rtt = 0;              ///< Last measured RTT (ping) in milliseconds
-    std::atomic<uint32_t> maxRtt = 0;           ///< Max RTT (ping) observed
-    std::atomic<uint64_t> retransmitCount = 0;  ///< Number of packets re-sent
-    std::atomic<uint64_t> duplicateCount = 0;   ///< Number of duplicate packets received
-    std::atomic<uint64_t> packetLossCount = 0;  ///< Packets confirmed lost (approx.)
+    std::atomic<uint32_t> rtt = 0;                  ///< Last measured RTT (ping) in milliseconds
+    std::atomic<uint32_t> maxRtt = 0;               ///< Max RTT (ping) observed
+    std::atomic<uint32_t> smoothedRtt = 0;          ///< SRTT (RFC 6298) in microseconds
+    std::atomic<uint32_t> rttVariation = 0;         ///< RTTVAR (RFC 6298) in microseconds
+    std::atomic<uint32_t> retransmitTimeout = 0;    ///< RTO in microseconds (0 until the first RTT)
+    std::atomic<uint64_t> retransmitCount = 0;      ///< Number of packets re-sent
+    std::atomic<uint64_t> fastRetransmitCount = 0;  ///< Re-sent before their timeout (in the above)
+    std::atomic<uint64_t> duplicateCount = 0;       ///< Number of duplicate packets received
+    std::atomic<uint64_t> staleCount = 0;           ///< Sequenced packets dropped (newer received)
+    std::atomic<uint64_t> expiredCount = 0;         ///< Queued messages dropped past their deadline
+    std::atomic<uint64_t> refusedCount = 0;         ///< Left unacked to be resent (buffer full)
+    std::atomic<uint64_t> packetLossCount = 0;      ///< Packets confirmed lost (approx.)
+    std::atomic<uint64_t> datagramsSent = 0;        ///< Datagrams sent (a bundle counts once)
+    std::atomic<uint64_t> congestionWindow = 0;     ///< Congestion window (cwnd) in bytes
+    std::atomic<uint64_t> bytesInFlight = 0;        ///< Reliable bytes sent and not yet acked
+    std::atomic<uint64_t> pacingRate = 0;           ///< Bytes per second (0 until the first RTT)
 
     std::array<ChannelMetrics, 256> channels;
 };
@@ -77,6 +93,8 @@ struct SessionSnapshot
     uint32_t rtt;
     uint64_t retransmitCount;
     uint64_t duplicateCount;
+    uint64_t congestionWindow;
+    uint64_t pacingRate;
 
     std::vector<ChannelSnapshot> activeChannels;
 };
@@ -88,6 +106,8 @@ struct SystemSnapshot
     // Global
     uint64_t totalBytesSent;
     uint64_t totalBytesReceived;
+    uint64_t totalPacketsSent;
+    uint64_t totalSendCalls;
 
     // Breakdowns
     std::vector<SessionSnapshot> sessions;
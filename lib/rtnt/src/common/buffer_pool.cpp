@@ -0,0 +1,208 @@
+#include "rtnt/common/buffer_pool.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace rtnt {
+
+struct PooledBuffer::Block
+{
+    std::atomic<uint32_t> references = 0;
+    std::atomic<uint32_t> next = UINT32_MAX;  ///< Next free block, only meaningful when free.
+    uint32_t index = 0;
+    uint8_t* data = nullptr;
+    BufferPool* pool = nullptr;
+    bool isPooled = true;
+};
+
+// =======================
+//      PooledBuffer
+// =======================
+
+PooledBuffer::PooledBuffer(const PooledBuffer& other)
+    : _block(other._block),
+      _offset(other._offset),
+      _size(other._size)
+{
+    if (_block) {
+        _block->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer&& other) noexcept
+    : _block(std::exchange(other._block, nullptr)),
+      _offset(std::exchange(other._offset, 0)),
+      _size(std::exchange(other._size, 0))
+{
+}
+
+PooledBuffer& PooledBuffer::operator=(const PooledBuffer& other)
+{
+    if (this != &other) {
+        if (other._block) {
+            other._block->references.fetch_add(1, std::memory_order_relaxed);
+        }
+        release();
+        _block = other._block;
+        _offset = other._offset;
+        _size = other._size;
+    }
+    return *this;
+}
+
+PooledBuffer& PooledBuffer::operator=(PooledBuffer&& other) noexcept
+{
+    if (this != &other) {
+        release();
+        _block = std::exchange(other._block, nullptr);
+        _offset = std::exchange(other._offset, 0);
+        _size = std::exchange(other._size, 0);
+    }
+    return *this;
+}
+
+PooledBuffer::~PooledBuffer() { release(); }
+
+void PooledBuffer::release()
+{
+    if (!_block) {
+        return;
+    }
+    if (_block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        _block->pool->giveBack(_block);
+    }
+    _block = nullptr;
+    _offset = 0;
+    _size = 0;
+}
+
+uint8_t* PooledBuffer::data() { return _block ? _block->data + _offset : nullptr; }
+
+const uint8_t* PooledBuffer::data() const { return _block ? _block->data + _offset : nullptr; }
+
+void PooledBuffer::resize(const size_t size) { _size = std::min(size, capacity()); }
+
+size_t PooledBuffer::capacity() const
+{
+    return _block ? _block->pool->getBufferSize() - _offset : 0;
+}
+
+PooledBuffer PooledBuffer::slice(const size_t offset,
+                                 const size_t size) const
+{
+    PooledBuffer part(*this);
+    const size_t start = std::min(offset, _size);
+
+    part._offset += start;
+    part._size = std::min(size, _size - start);
+    return part;
+}
+
+std::span<const uint8_t> PooledBuffer::view() const { return {data(), size()}; }
+
+bool PooledBuffer::isPooled() const { return _block && _block->isPooled; }
+
+// =======================
+//       BufferPool
+// =======================
+
+void BufferPool::OwnerRelease::operator()(BufferPool* pool) const { pool->unreference(); }
+
+BufferPool::BufferPool(const size_t bufferCount,
+                       const size_t bufferSize)
+    : _bufferCount(std::min<size_t>(bufferCount, NIL)),
+      _bufferSize(bufferSize),
+      _blocks(std::make_unique<PooledBuffer::Block[]>(_bufferCount)),
+      _storage(std::make_unique_for_overwrite<uint8_t[]>(_bufferCount * _bufferSize)),
+      _freeHead(NIL)
+{
+    for (uint32_t i = 0; i < _bufferCount; i++) {
+        PooledBuffer::Block& block = _blocks[i];
+
+        block.index = i;
+        block.data = _storage.get() + i * _bufferSize;
+        block.pool = this;
+        push(i);
+    }
+}
+
+BufferPool::~BufferPool() = default;
+
+BufferPool::Ptr BufferPool::create(const size_t bufferCount,
+                                   const size_t bufferSize)
+{
+    return Ptr(new BufferPool(bufferCount, bufferSize));
+}
+
+PooledBuffer BufferPool::acquire()
+{
+    _references.fetch_add(1, std::memory_order_relaxed);
+
+    PooledBuffer::Block* block = nullptr;
+    const uint32_t index = pop();
+
+    if (index != NIL) {
+        block = &_blocks[index];
+    } else {
+        _misses.fetch_add(1, std::memory_order_relaxed);
+        block = new PooledBuffer::Block;
+        block->data = new uint8_t[_bufferSize];
+        block->pool = this;
+        block->isPooled = false;
+    }
+
+    block->references.store(1, std::memory_order_relaxed);
+    return PooledBuffer(block);
+}
+
+void BufferPool::push(const uint32_t index)
+{
+    uint64_t head = _freeHead.load(std::memory_order_relaxed);
+    uint64_t newHead = 0;
+
+    do {
+        _blocks[index].next.store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        newHead = (((head >> 32) + 1) << 32) | index;
+    } while (!_freeHead.compare_exchange_weak(
+        head, newHead, std::memory_order_release, std::memory_order_relaxed));
+}
+
+uint32_t BufferPool::pop()
+{
+    uint64_t head = _freeHead.load(std::memory_order_acquire);
+    uint64_t newHead = 0;
+
+    do {
+        const auto index = static_cast<uint32_t>(head);
+
+        if (index == NIL) {
+            return NIL;
+        }
+        // The tag makes the exchange fail if the block has been popped and pushed back meanwhile.
+        const uint32_t next = _blocks[index].next.load(std::memory_order_relaxed);
+        newHead = (((head >> 32) + 1) << 32) | next;
+    } while (!_freeHead.compare_exchange_weak(
+        head, newHead, std::memory_order_acquire, std::memory_order_acquire));
+
+    return static_cast<uint32_t>(head);
+}
+
+void BufferPool::giveBack(PooledBuffer::Block* block)
+{
+    if (block->isPooled) {
+        push(block->index);
+    } else {
+        delete[] block->data;
+        delete block;
+    }
+    unreference();
+}
+
+void BufferPool::unreference()
+{
+    if (_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete this;
+    }
+}
+
+}  // namespace rtnt
@@ -7,7 +7,12 @@ namespace rtnt {
 std::string byteBufferToHexString(const core::ByteBuffer::const_iterator begin,
                                   const core::ByteBuffer::const_iterator end)
 {
-    const size_t size = std::distance(begin, end);
+    return byteBufferToHexString(std::span<const uint8_t>(begin, end));
+}
+
+std::string byteBufferToHexString(const std::span<const uint8_t> buffer)
+{
+    const size_t size = buffer.size();
 
     if (size == 0) {
         return "[]";
@@ -17,8 +22,8 @@ std::string byteBufferToHexString(const core::ByteBuffer::const_iterator begin,
     result.reserve(1 + size * 3 - 1 + 1);
 
     result += '[';
-    for (auto it = begin; it != end; ++it) {
-        if (it != begin) {
+    for (auto it = buffer.begin(); it != buffer.end(); ++it) {
+        if (it != buffer.begin()) {
             result += ' ';
         }
         result += std::format(
@@ -30,11 +35,6 @@ std::string byteBufferToHexString(const core::ByteBuffer::const_iterator begin,
     return result;
 }
 
-std::string byteBufferToHexString(const core::ByteBuffer &buffer)
-{
-    return byteBufferToHexString(buffer.begin(), buffer.end());
-}
-
 std::string bitfieldToString(const uint32_t bitfield)
 {
     std::string res;
@@ -52,6 +52,8 @@ void Client::disconnect()
     if (_isConnected && _serverSession) {
         packet::internal::Disconnect packet{};
         _serverSession->send(packet);
+        _serverSession->flush();
+        flush();
     }
 
     _serverSession.reset();
@@ -67,6 +69,12 @@ void Client::disconnect()
 }
 
 void Client::update(milliseconds timeout)
+{
+    _internal_update(timeout);
+    flush();
+}
+
+void Client::_internal_update(milliseconds timeout)
 {
     _processEvents();
 
@@ -123,10 +131,11 @@ void Client::update(milliseconds timeout)
     }
 
     session->update();
+    session->flush();
 }
 
 void Client::onReceive(const udp::endpoint& sender,
-                       std::shared_ptr<ByteBuffer> data)
+                       PooledBuffer data)
 {
     std::shared_ptr<Session> session;
 
@@ -149,7 +158,7 @@ void Client::onReceive(const udp::endpoint& sender,
     }
 
     for (Packet& packet : packetsToProcess) {
-        _eventQueue.push([this, session, pkt = packet]() mutable {
+        _eventQueue.push([this, session, pkt = std::move(packet)]() mutable {
             _packetDispatcher.dispatch(session, pkt);
 
             bool isConnected;
@@ -199,6 +208,8 @@ void Client::_internal_attemptConnection()
 
     constexpr packet::internal::Connect packet;
     _serverSession->send(packet);
+    _serverSession->flush();
+    flush();
 }
 
 /// Used to process events on the main thread and not on io thread
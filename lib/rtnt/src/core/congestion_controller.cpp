@@ -0,0 +1,66 @@
+#include "rtnt/core/congestion_controller.hpp"
+
+#include <algorithm>
+
+namespace rtnt::core {
+
+void CongestionController::onSent(const size_t bytes)
+{
+    _bytesInFlight += bytes;
+}
+
+void CongestionController::onAcknowledged(const size_t bytes,
+                                          const time_point<steady_clock> sentTime)
+{
+    // Growing while application-limited would inflate the window past what the path was tested at.
+    const bool isWindowLimited = _bytesInFlight * 2 >= _congestionWindow;
+
+    _bytesInFlight -= std::min(bytes, _bytesInFlight);
+
+    if (!isWindowLimited || sentTime <= _recoveryStart) {
+        return;
+    }
+
+    if (isInSlowStart()) {
+        _congestionWindow += bytes;
+    } else {
+        const size_t increase = packet::MAX_BUNDLE_SIZE * bytes / _congestionWindow;
+
+        _congestionWindow += std::max<size_t>(1, increase);
+    }
+}
+
+void CongestionController::onLost(const size_t bytes,
+                                  const time_point<steady_clock> sentTime,
+                                  const time_point<steady_clock> now)
+{
+    _bytesInFlight -= std::min(bytes, _bytesInFlight);
+
+    if (sentTime <= _recoveryStart) {  // Already reduced for this congestion event.
+        return;
+    }
+
+    _slowStartThreshold = std::max(_congestionWindow / 2, packet::MIN_CONGESTION_WINDOW);
+    _congestionWindow = _slowStartThreshold;
+    _recoveryStart = now;
+}
+
+bool CongestionController::canSend(const size_t bytes) const
+{
+    return _bytesInFlight == 0 || _bytesInFlight + bytes <= _congestionWindow;
+}
+
+uint64_t CongestionController::getPacingRate(const microseconds smoothedRtt) const
+{
+    if (smoothedRtt <= microseconds::zero()) {
+        return 0;
+    }
+
+    const uint64_t gain =
+        isInSlowStart() ? packet::SLOW_START_PACING_GAIN_PERCENT : packet::PACING_GAIN_PERCENT;
+
+    return std::max<uint64_t>(
+        1, _congestionWindow * gain * 1'000'000 / 100 / static_cast<uint64_t>(smoothedRtt.count()));
+}
+
+}  // namespace rtnt::core
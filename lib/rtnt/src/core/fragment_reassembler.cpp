@@ -0,0 +1,153 @@
+#include "rtnt/core/fragment_reassembler.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "logger/Logger.h"
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+FragmentReassembler::Result FragmentReassembler::receive(const packet::SequenceId sequenceId,
+                                                         const std::span<const uint8_t> payload,
+                                                         const bool isReliable,
+                                                         Message& message)
+{
+    if (payload.size() < sizeof(packet::FragmentHeader)) {
+        return Result::kInvalid;
+    }
+
+    packet::FragmentHeader header;
+    std::memcpy(&header, payload.data(), sizeof(packet::FragmentHeader));
+    header.convertEndianness();
+
+    const auto chunk = payload.subspan(sizeof(packet::FragmentHeader));
+    const bool isLast = header.index + 1 == header.count;
+
+    if (header.count == 0 || header.count > packet::MAX_FRAGMENT_COUNT ||
+        header.index >= header.count || chunk.empty() ||
+        chunk.size() > packet::MAX_FRAGMENT_SIZE) {
+        return Result::kInvalid;
+    }
+
+    const packet::SequenceId firstSequenceId = sequenceId - header.index;
+    auto it = _assemblies.find(firstSequenceId);
+
+    if (it == _assemblies.end()) {
+        // The fragment size is not known yet: room is reserved for the largest.
+        const size_t reservation = header.count * packet::MAX_FRAGMENT_SIZE;
+
+        if (!reserve(reservation)) {
+            return Result::kRefused;
+        }
+
+        Assembly assembly;
+
+        assembly.messageId = header.messageId;
+        assembly.count = header.count;
+        assembly.isReliable = isReliable;
+        assembly.creation = _nextCreation++;
+        assembly.reservation = reservation;
+        assembly.fragments.resize((header.count + 63) / 64);
+
+        it = _assemblies.emplace(firstSequenceId, std::move(assembly)).first;
+        _reservedBytes += reservation;
+    }
+
+    Assembly& assembly = it->second;
+
+    if (assembly.messageId != header.messageId || assembly.count != header.count) {
+        return Result::kInvalid;
+    }
+
+    uint64_t& word = assembly.fragments[header.index / 64];
+    const uint64_t bit = 1ULL << (header.index % 64);
+
+    if ((word & bit) != 0) {
+        return Result::kIncomplete;
+    }
+
+    // Every fragment but the last one carries the same number of bytes, the last one at most that.
+    if (assembly.fragmentSize == 0 && !isLast) {
+        if (chunk.size() < assembly.lastFragment.size()) {
+            return Result::kInvalid;
+        }
+        setFragmentSize(assembly, chunk.size());
+    }
+    if (assembly.fragmentSize != 0 &&
+        (isLast ? chunk.size() > assembly.fragmentSize : chunk.size() != assembly.fragmentSize)) {
+        return Result::kInvalid;
+    }
+
+    word |= bit;
+    assembly.received++;
+    if (isLast) {
+        assembly.size = header.index * assembly.fragmentSize + chunk.size();
+    }
+    if (assembly.fragmentSize != 0) {
+        std::ranges::copy(chunk, assembly.data.begin() + header.index * assembly.fragmentSize);
+    } else {
+        assembly.lastFragment.assign(chunk.begin(), chunk.end());
+    }
+
+    if (assembly.received < assembly.count) {
+        return Result::kIncomplete;
+    }
+
+    message.firstSequenceId = firstSequenceId;
+    message.messageId = assembly.messageId;
+    message.payload = assembly.count == 1 ? std::move(assembly.lastFragment)
+                                          : std::move(assembly.data);
+    message.payload.resize(assembly.size);
+
+    _reservedBytes -= assembly.reservation;
+    _assemblies.erase(it);
+    return Result::kComplete;
+}
+
+bool FragmentReassembler::reserve(const size_t bytes)
+{
+    while (_reservedBytes + bytes > packet::REASSEMBLY_BUFFER_SIZE) {
+        auto oldest = _assemblies.end();
+
+        for (auto it = _assemblies.begin(); it != _assemblies.end(); ++it) {
+            if (!it->second.isReliable &&
+                (oldest == _assemblies.end() || it->second.creation < oldest->second.creation)) {
+                oldest = it;
+            }
+        }
+
+        if (oldest == _assemblies.end()) {
+            return false;
+        }
+
+        LOG_TRACE_R2("Evicting incomplete message #{} ({}/{} fragments).",
+                     oldest->second.messageId,
+                     oldest->second.received,
+                     oldest->second.count);
+        _reservedBytes -= oldest->second.reservation;
+        _assemblies.erase(oldest);
+    }
+    return true;
+}
+
+void FragmentReassembler::setFragmentSize(Assembly& assembly,
+                                          const size_t fragmentSize)
+{
+    const size_t reservation = assembly.count * fragmentSize;
+
+    _reservedBytes -= assembly.reservation - reservation;
+    assembly.reservation = reservation;
+    assembly.fragmentSize = fragmentSize;
+    assembly.data.resize(reservation);
+
+    if (!assembly.lastFragment.empty()) {  // Received first, it can now be put in place.
+        const size_t offset = (assembly.count - 1) * fragmentSize;
+
+        std::ranges::copy(assembly.lastFragment, assembly.data.begin() + offset);
+        assembly.size = offset + assembly.lastFragment.size();
+        assembly.lastFragment.clear();
+    }
+}
+
+}  // namespace rtnt::core
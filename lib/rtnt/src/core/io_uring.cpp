@@ -0,0 +1,488 @@
+#include "rtnt/core/io_uring.hpp"
+
+#if defined(__linux__)
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include "logger/Logger.h"
+
+namespace rtnt::core {
+
+/// Room the kernel needs in front of each received datagram (multishot @code recvmsg@endcode).
+static constexpr size_t RECEIVE_HEADER_SIZE =
+    sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_storage);
+
+IoUring::IoUring(Peer& peer)
+    : _peer(peer),
+      _descriptor(peer._context)
+{
+}
+
+std::unique_ptr<IoUring> IoUring::create(Peer& peer)
+{
+    std::unique_ptr<IoUring> ring(new IoUring(peer));
+
+    if (!ring->setup()) {
+        return nullptr;
+    }
+    return ring;
+}
+
+IoUring::~IoUring()
+{
+    if (_fd < 0) {
+        return;
+    }
+
+    _isStopping = true;
+    if (_descriptor.is_open()) {
+        _descriptor.release();  // Cancels the pending wait. The ring itself is closed below.
+    }
+
+    {
+        std::lock_guard lock(_submissionMutex);
+
+        if (_pendingOperations > 0) {
+            if (io_uring_sqe* sqe = getSqe()) {
+                sqe->opcode = IORING_OP_ASYNC_CANCEL;
+                sqe->fd = -1;
+                sqe->cancel_flags = IORING_ASYNC_CANCEL_ANY;
+                sqe->user_data = CANCEL_TAG;
+                submit();
+            }
+        }
+    }
+
+    // The kernel must be done with the lent buffers and the send slots before they are freed.
+    for (size_t attempt = 0; attempt < 1000; attempt++) {
+        reap();
+
+        std::lock_guard lock(_submissionMutex);
+        if (_pendingOperations == 0) {
+            break;
+        }
+        submit(0, IORING_ENTER_GETEVENTS);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (_pendingOperations > 0) {
+        LOG_WARN("Closing the io_uring with {} operations still pending.", _pendingOperations);
+    }
+
+    // The kernel frees a closed ring asynchronously: unregister the socket now, so that it can be
+    // closed (and its port reused) right away.
+    syscall(__NR_io_uring_register, _fd, IORING_UNREGISTER_FILES, nullptr, 0);
+
+    if (_bufferRing) {
+        munmap(_bufferRing, _bufferRingSize);
+    }
+    if (_sqes) {
+        munmap(_sqes, _sqesSize);
+    }
+    if (_ringMemory) {
+        munmap(_ringMemory, _ringMemorySize);
+    }
+    close(_fd);
+}
+
+bool IoUring::setup()
+{
+    io_uring_params params{};
+
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = URING_COMPLETION_ENTRIES;
+
+    _fd = static_cast<int>(syscall(__NR_io_uring_setup, URING_SUBMISSION_ENTRIES, &params));
+    if (_fd < 0) {
+        LOG_WARN("io_uring is not available: {}.", std::strerror(errno));
+        return false;
+    }
+    if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_NODROP)) {
+        LOG_WARN("io_uring is too old (features {:#x}).", params.features);
+        return false;
+    }
+
+    // Rings (the submission and completion rings share one mapping).
+    _ringMemorySize =
+        std::max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                 params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    _ringMemory = mmap(nullptr,
+                       _ringMemorySize,
+                       PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE,
+                       _fd,
+                       IORING_OFF_SQ_RING);
+    if (_ringMemory == MAP_FAILED) {
+        _ringMemory = nullptr;
+        LOG_WARN("Could not map the io_uring: {}.", std::strerror(errno));
+        return false;
+    }
+
+    _sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqes = mmap(nullptr,
+                      _sqesSize,
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE,
+                      _fd,
+                      IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        LOG_WARN("Could not map the io_uring submission entries: {}.", std::strerror(errno));
+        return false;
+    }
+    _sqes = static_cast<io_uring_sqe*>(sqes);
+
+    auto* base = static_cast<uint8_t*>(_ringMemory);
+    auto* array = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+
+    _sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+    _sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+    _sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+    _sqEntries = params.sq_entries;
+    _sqLocalTail = *_sqTail;
+    for (unsigned i = 0; i < _sqEntries; i++) {
+        array[i] = i;  // Entries are always submitted in order.
+    }
+
+    _cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+    _cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+    _cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+    _cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+    // Socket, registered so that the kernel does not look it up on every operation.
+    int socket = _peer._socket.native_handle();
+
+    if (syscall(__NR_io_uring_register, _fd, IORING_REGISTER_FILES, &socket, 1) < 0) {
+        LOG_WARN("Could not register the socket in the io_uring: {}.", std::strerror(errno));
+        return false;
+    }
+
+    // Buffer ring, through which reception buffers are lent to the kernel.
+    _bufferRingSize = URING_RECEIVE_BUFFERS * sizeof(io_uring_buf);
+    void* bufferRing = mmap(
+        nullptr, _bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (bufferRing == MAP_FAILED) {
+        LOG_WARN("Could not allocate the io_uring buffer ring: {}.", std::strerror(errno));
+        return false;
+    }
+    _bufferRing = static_cast<io_uring_buf_ring*>(bufferRing);
+
+    io_uring_buf_reg registration{};
+
+    registration.ring_addr = reinterpret_cast<uint64_t>(bufferRing);
+    registration.ring_entries = URING_RECEIVE_BUFFERS;
+    registration.bgid = BUFFER_GROUP;
+    if (syscall(__NR_io_uring_register, _fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0) {
+        LOG_WARN("Could not register the io_uring buffer ring: {}.", std::strerror(errno));
+        return false;
+    }
+
+    // The kernel writes a header and the sender address in front of each datagram.
+    _peer._receptionPool =
+        BufferPool::create(URING_RECEIVE_BUFFERS + 1, BUFFER_SIZE + RECEIVE_HEADER_SIZE);
+    _lentBuffers.resize(URING_RECEIVE_BUFFERS);
+    for (uint16_t bufferId = 0; bufferId < URING_RECEIVE_BUFFERS; bufferId++) {
+        lendBuffer(bufferId);
+    }
+    std::atomic_ref(_bufferRing->tail).store(_bufferTail, std::memory_order_release);
+
+    _receiveHeader.msg_namelen = sizeof(sockaddr_storage);
+
+    _sendSlots.resize(URING_SUBMISSION_ENTRIES);
+    _freeSendSlots.reserve(URING_SUBMISSION_ENTRIES);
+    for (uint32_t i = URING_SUBMISSION_ENTRIES; i > 0; i--) {
+        _freeSendSlots.push_back(i - 1);
+    }
+
+    _descriptor.assign(_fd);
+
+    LOG_INFO("io_uring set up ({} submission entries, {} completion entries).",
+             params.sq_entries,
+             params.cq_entries);
+    return true;
+}
+
+void IoUring::start()
+{
+    asio::post(_peer._context, [this]() {
+        {
+            std::lock_guard lock(_submissionMutex);
+            armReceive();
+        }
+        wait();
+    });
+}
+
+size_t IoUring::send(std::vector<Peer::OutgoingDatagram>& datagrams)
+{
+    std::lock_guard lock(_submissionMutex);
+    size_t count = 0;
+
+    if (_isStopping) {
+        return 0;
+    }
+
+    for (; count < datagrams.size() && !_freeSendSlots.empty(); count++) {
+        io_uring_sqe* sqe = getSqe();
+
+        if (!sqe) {
+            break;
+        }
+
+        const uint32_t index = _freeSendSlots.back();
+        SendSlot& slot = _sendSlots[index];
+
+        _freeSendSlots.pop_back();
+        slot.target = datagrams[count].target;
+        slot.data = std::move(datagrams[count].data);
+        slot.payload = std::move(datagrams[count].payload);
+        slot.vectors[0] = {slot.data->data(), slot.data->size()};
+        if (slot.payload) {  // Only read by the kernel.
+            slot.vectors[1] = {const_cast<uint8_t*>(slot.payload->data()), slot.payload->size()};
+        }
+        slot.header = {};
+        slot.header.msg_name = slot.target.data();
+        slot.header.msg_namelen = static_cast<socklen_t>(slot.target.size());
+        slot.header.msg_iov = slot.vectors.data();
+        slot.header.msg_iovlen = slot.payload ? 2 : 1;
+
+        sqe->opcode = IORING_OP_SENDMSG;
+        sqe->fd = 0;  // Index of the registered socket.
+        sqe->flags = IOSQE_FIXED_FILE;
+        sqe->addr = reinterpret_cast<uint64_t>(&slot.header);
+        sqe->len = 1;
+        sqe->user_data = index;
+        _pendingOperations++;
+    }
+
+    if (count > 0) {
+        submit();
+        _peer._networkMetrics.totalSendCalls.fetch_add(1, std::memory_order_relaxed);
+        LOG_TRACE_R3("Submitted {} datagrams in one call.", count);
+    }
+    return count;
+}
+
+io_uring_sqe* IoUring::getSqe()
+{
+    const unsigned head = std::atomic_ref(*_sqHead).load(std::memory_order_acquire);
+
+    if (_sqLocalTail - head >= _sqEntries) {
+        return nullptr;
+    }
+
+    io_uring_sqe* sqe = &_sqes[_sqLocalTail & _sqMask];
+
+    _sqLocalTail++;
+    std::memset(sqe, 0, sizeof(io_uring_sqe));
+    return sqe;
+}
+
+int IoUring::submit(const unsigned minComplete,
+                    const unsigned flags)
+{
+    std::atomic_ref(*_sqTail).store(_sqLocalTail, std::memory_order_release);
+
+    const unsigned toSubmit =
+        _sqLocalTail - std::atomic_ref(*_sqHead).load(std::memory_order_acquire);
+    int result;
+
+    do {
+        result = static_cast<int>(
+            syscall(__NR_io_uring_enter, _fd, toSubmit, minComplete, flags, nullptr, 0));
+    } while (result < 0 && errno == EINTR);
+
+    if (result < 0) {
+        LOG_ERR("Could not submit to the io_uring: {}.", std::strerror(errno));
+    }
+    return result;
+}
+
+void IoUring::armReceive()
+{
+    io_uring_sqe* sqe = getSqe();
+
+    if (!sqe) {
+        submit();
+        sqe = getSqe();
+    }
+    if (!sqe) {
+        LOG_ERR("io_uring submission queue is full, could not receive.");
+        return;
+    }
+
+    sqe->opcode = IORING_OP_RECVMSG;
+    sqe->fd = 0;  // Index of the registered socket.
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_BUFFER_SELECT;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->addr = reinterpret_cast<uint64_t>(&_receiveHeader);
+    sqe->len = 1;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = RECEIVE_TAG;
+    _isReceiveArmed = true;
+    _pendingOperations++;
+
+    LOG_DEBUG("Listening (io_uring)...");
+    submit();
+}
+
+void IoUring::lendBuffer(const uint16_t bufferId)
+{
+    PooledBuffer& buffer = _lentBuffers[bufferId];
+    // The entries start at the beginning of the ring. (@code bufs@endcode is misplaced in C++, as
+    // the kernel header declares it after an empty struct.)
+    auto* entries = reinterpret_cast<io_uring_buf*>(_bufferRing);
+    io_uring_buf& entry = entries[_bufferTail & (URING_RECEIVE_BUFFERS - 1)];
+
+    buffer = _peer.acquireReceptionBuffer();
+    // The reserved field of the first entry holds the tail of the ring: it must not be written.
+    entry.addr = reinterpret_cast<uint64_t>(buffer.data());
+    entry.len = static_cast<uint32_t>(buffer.capacity());
+    entry.bid = bufferId;
+    _bufferTail++;
+}
+
+void IoUring::wait()
+{
+    _descriptor.async_wait(asio::posix::stream_descriptor::wait_read, [this](std::error_code ec) {
+        if (ec) {
+            if (ec != asio::error::operation_aborted) {
+                LOG_ERR("Encountered an error while waiting for the io_uring: {}.", ec.message());
+                wait();
+            }
+            return;
+        }
+
+        if (reap() > 0) {
+            _peer._networkMetrics.totalReceiveCalls.fetch_add(1, std::memory_order_relaxed);
+        }
+        _peer.Peer::flush();  // Sends the ACKs and replies produced while handling the datagrams.
+        wait();
+    });
+}
+
+size_t IoUring::reap()
+{
+    const uint16_t bufferTail = _bufferTail;
+    unsigned head = *_cqHead;
+    size_t received = 0;
+
+    while (true) {
+        const unsigned tail = std::atomic_ref(*_cqTail).load(std::memory_order_acquire);
+
+        if (head == tail) {
+            break;
+        }
+        for (; head != tail; head++) {
+            const io_uring_cqe& cqe = _cqes[head & _cqMask];
+
+            if (cqe.user_data == RECEIVE_TAG) {
+                received += handleReception(cqe);
+            } else if (cqe.user_data != CANCEL_TAG) {
+                handleSendCompletion(cqe);
+            }
+        }
+        std::atomic_ref(*_cqHead).store(head, std::memory_order_release);
+    }
+
+    if (_bufferTail != bufferTail) {
+        std::atomic_ref(_bufferRing->tail).store(_bufferTail, std::memory_order_release);
+    }
+    if (!_isReceiveArmed && !_isStopping) {
+        std::lock_guard lock(_submissionMutex);
+        armReceive();
+    }
+    return received;
+}
+
+size_t IoUring::handleReception(const io_uring_cqe& cqe)
+{
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {  // The multishot receive ended, it must be re-armed.
+        std::lock_guard lock(_submissionMutex);
+        _isReceiveArmed = false;
+        _pendingOperations--;
+    }
+
+    if (cqe.res < 0) {
+        // ENOBUFS: every lent buffer was in use. They have been lent again since.
+        if (cqe.res != -ECANCELED && cqe.res != -ENOBUFS) {
+            LOG_ERR("Encountered an error while receiving data: {}.", std::strerror(-cqe.res));
+        }
+        return 0;
+    }
+    if (!(cqe.flags & IORING_CQE_F_BUFFER) || _isStopping) {
+        return 0;
+    }
+
+    const auto bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+    PooledBuffer buffer = std::move(_lentBuffers[bufferId]);
+    io_uring_recvmsg_out out{};
+
+    lendBuffer(bufferId);
+    buffer.resize(static_cast<size_t>(cqe.res));
+    if (buffer.size() < RECEIVE_HEADER_SIZE) {
+        return 0;
+    }
+    std::memcpy(&out, buffer.data(), sizeof(out));
+
+    if (out.flags & MSG_TRUNC) {
+        LOG_WARN("Dropped a datagram too large for the reception buffers.");
+        return 0;
+    }
+    if (out.payloadlen == 0) {
+        return 0;
+    }
+
+    udp::endpoint sender;
+    const size_t nameLength = std::min<size_t>(out.namelen, sender.capacity());
+
+    std::memcpy(sender.data(), buffer.data() + sizeof(io_uring_recvmsg_out), nameLength);
+    sender.resize(nameLength);
+
+    LOG_TRACE_R3("Received {} bytes from {}:{}.",
+                 out.payloadlen,
+                 sender.address().to_string(),
+                 sender.port());
+
+    _peer._networkMetrics.totalBytesReceived.fetch_add(out.payloadlen, std::memory_order_relaxed);
+    _peer._networkMetrics.totalPacketsReceived.fetch_add(1, std::memory_order_relaxed);
+    _peer.deliverDatagram(sender,
+                          buffer.slice(RECEIVE_HEADER_SIZE + _receiveHeader.msg_controllen,
+                                       out.payloadlen));
+    return 1;
+}
+
+void IoUring::handleSendCompletion(const io_uring_cqe& cqe)
+{
+    std::shared_ptr<ByteBuffer> data;
+    std::shared_ptr<const ByteBuffer> payload;
+
+    {
+        std::lock_guard lock(_submissionMutex);
+        const auto index = static_cast<uint32_t>(cqe.user_data);
+
+        data = std::move(_sendSlots[index].data);
+        payload = std::move(_sendSlots[index].payload);
+        _freeSendSlots.push_back(index);
+        _pendingOperations--;
+    }
+
+    if (cqe.res < 0) {
+        if (cqe.res != -ECANCELED) {
+            LOG_ERR("Encountered an error while sending data: {}.", std::strerror(-cqe.res));
+        }
+        return;
+    }
+
+    _peer._networkMetrics.totalBytesSent.fetch_add(cqe.res, std::memory_order_relaxed);
+    _peer._networkMetrics.totalPacketsSent.fetch_add(1, std::memory_order_relaxed);
+}
+
+}  // namespace rtnt::core
+
+#endif
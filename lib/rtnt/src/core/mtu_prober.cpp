@@ -0,0 +1,43 @@
+#include "rtnt/core/mtu_prober.hpp"
+
+#include <algorithm>
+
+namespace rtnt::core {
+
+size_t MtuProber::getProbeSize() const
+{
+    if (_high <= _low) {
+        return 0;
+    }
+    if (_high == packet::MAX_PROBE_SIZE) {
+        return _high;
+    }
+    if (_high - _low < packet::PROBE_PRECISION) {
+        return 0;
+    }
+    return _low + (_high - _low + 1) / 2;
+}
+
+void MtuProber::onAcknowledged(const size_t probeSize)
+{
+    if (probeSize <= _low || probeSize > packet::MAX_PROBE_SIZE) {
+        return;
+    }
+    _low = probeSize;
+    _high = std::max(_high, _low);
+    _attempts = 0;
+}
+
+void MtuProber::onLost(const size_t probeSize)
+{
+    if (probeSize <= _low || probeSize > _high) {  // Answered by another probe since.
+        return;
+    }
+    if (++_attempts < packet::MAX_PROBE_ATTEMPTS) {
+        return;
+    }
+    _high = probeSize - 1;
+    _attempts = 0;
+}
+
+}  // namespace rtnt::core
@@ -0,0 +1,79 @@
+#include "rtnt/core/pacer.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+void Pacer::setRate(const uint64_t bytesPerSecond,
+                    const time_point<steady_clock> now)
+{
+    refill(now);
+
+    const bool wasDisabled = _rate == 0;
+
+    _rate = bytesPerSecond;
+    _capacity = static_cast<int64_t>(
+        std::max<double>(packet::MIN_PACING_BURST_SIZE,
+                         duration<double>(TIMER_WHEEL_RESOLUTION).count() * _rate));
+
+    if (wasDisabled) {  // Starts with a full bucket.
+        _tokens = _capacity;
+        _lastRefill = now;
+    }
+    _tokens = std::min(_tokens, _capacity);
+}
+
+bool Pacer::canSend(const time_point<steady_clock> now)
+{
+    refill(now);
+    return _rate == 0 || _tokens > 0;
+}
+
+void Pacer::consume(const size_t bytes,
+                    const time_point<steady_clock> now)
+{
+    if (_rate == 0) {
+        return;
+    }
+    refill(now);
+    _tokens -= static_cast<int64_t>(bytes);
+}
+
+time_point<steady_clock> Pacer::getNextSendTime(const time_point<steady_clock> now)
+{
+    if (canSend(now)) {
+        return now;
+    }
+
+    const double deficit = static_cast<double>(1 - _tokens);
+
+    return now + nanoseconds(static_cast<int64_t>(std::ceil(deficit * 1e9 / _rate)));
+}
+
+void Pacer::refill(const time_point<steady_clock> now)
+{
+    if (_rate == 0 || now <= _lastRefill) {
+        return;
+    }
+    if (_tokens >= _capacity) {
+        _lastRefill = now;
+        return;
+    }
+
+    // Capped, so that a long pause cannot overflow the bucket arithmetic.
+    const double elapsed = std::min(duration<double>(now - _lastRefill).count(), 1.0);
+    const auto earned = static_cast<int64_t>(elapsed * static_cast<double>(_rate));
+
+    // Fractions of a byte stay accumulated, instead of being lost to the rounding.
+    if (earned == 0) {
+        return;
+    }
+
+    _tokens = std::min(_tokens + earned, _capacity);
+    _lastRefill = now;
+}
+
+}  // namespace rtnt::core
@@ -8,9 +8,15 @@ Flag operator&(Flag lhs,
     return static_cast<Flag>(static_cast<uint8_t>(lhs) & static_cast<uint8_t>(rhs));
 }
 
+bool isReliable(const Flag flag)
+{
+    return (static_cast<uint8_t>(flag) &
+            (static_cast<uint8_t>(Flag::kReliable) | static_cast<uint8_t>(Flag::kOrdered))) != 0;
+}
+
 using namespace parsing;
 
-Result Header::parse(const ByteBuffer& data)
+Result Header::parse(const std::span<const uint8_t> data)
 {
     if (data.size() < sizeof(Header)) {
         return Result::failure(Error::kDataTooSmall);
@@ -1,22 +1,213 @@
 #include "rtnt/core/peer.hpp"
 
+#include <asio/post.hpp>
+#include <cstring>
+#include <future>
 #include <random>
+#include <utility>
+
+#if defined(__linux__)
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#include <cerrno>
+
+// Older C libraries do not define the UDP offload options yet.
+#if !defined(UDP_SEGMENT)
+#define UDP_SEGMENT 103
+#endif
+#if !defined(UDP_GRO)
+#define UDP_GRO 104
+#endif
+#endif
 
 #include "logger/Logger.h"
+#include "rtnt/core/io_uring.hpp"
 
 namespace rtnt::core {
 
-void Peer::server(const unsigned short port)
+#if defined(__linux__)
+
+/// Largest UDP payload over IPv4, which bounds the size of a segmented send.
+static constexpr size_t MAX_UDP_PAYLOAD = 65507;
+
+/**
+ * @return  The size of the datagrams coalesced in a received message (GRO), or @code 0@endcode if
+ *          it holds a single datagram.
+ */
+static size_t receivedSegmentSize(const msghdr& header)
+{
+    for (const cmsghdr* control = CMSG_FIRSTHDR(&header); control != nullptr;
+         control = CMSG_NXTHDR(const_cast<msghdr*>(&header), const_cast<cmsghdr*>(control))) {
+        if (control->cmsg_level == SOL_UDP && control->cmsg_type == UDP_GRO) {
+            int segmentSize = 0;
+
+            std::memcpy(&segmentSize, CMSG_DATA(control), sizeof(segmentSize));
+            return segmentSize > 0 ? static_cast<size_t>(segmentSize) : 0;
+        }
+    }
+    return 0;
+}
+
+#endif
+
+Peer::Peer(asio::io_context& context)
+    : Peer(context, _ownNetworkMetrics)
+{
+}
+
+Peer::Peer(asio::io_context& context,
+           stat::NetworkMetrics& metrics)
+    : _context(context),
+      _socket(context),
+      _networkMetrics(metrics)
+{
+}
+
+Peer::~Peer() = default;
+
+void Peer::server(const unsigned short port,
+                  const bool reusePort)
+{
+    _socket = udp::socket(_context, udp::v4());
+#if defined(__linux__)
+    if (reusePort) {
+        const int fd = _socket.native_handle();
+        const int value = 1;
+
+        if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &value, sizeof(value)) != 0) {
+            LOG_ERR("Could not share the port between sockets ({}).", std::strerror(errno));
+        }
+    }
+#else
+    if (reusePort) {
+        LOG_WARN("Sharing a port between sockets is only available on Linux. Ignoring.");
+    }
+#endif
+    _socket.bind(udp::endpoint(udp::v4(), port));
+    disableFragmentation();
+}
+
+void Peer::client()
 {
-    _socket = udp::socket(_context, udp::endpoint(udp::v4(), port));
+    _socket = udp::socket(_context, udp::endpoint(udp::v4(), 0));
+    disableFragmentation();
 }
 
-void Peer::client() { _socket = udp::socket(_context, udp::endpoint(udp::v4(), 0)); }
+void Peer::start()
+{
+#if defined(__linux__)
+    if (_ioBackend == IoBackend::kIoUring) {
+        if (_ioUring) {
+            return;  // Already receiving.
+        }
+        _ioUring = IoUring::create(*this);
+        if (_ioUring) {
+            _ioUring->start();
+            return;
+        }
+        LOG_WARN("Could not set up io_uring. Falling back to the batched I/O backend.");
+        _ioBackend = IoBackend::kBatched;
+    }
+    if (_ioBackend == IoBackend::kBatched) {
+        if (_isUdpOffloadRequested) {
+            enableUdpOffload();
+        }
+        receiveBatch();
+        return;
+    }
+#endif
+    if (_isUdpOffloadRequested) {
+        LOG_WARN("UDP offload requires the batched I/O backend. Ignoring.");
+    }
+    receive();
+}
 
 void Peer::stop()
 {
-    _socket.shutdown(udp::socket::shutdown_send);
-    _socket.close();
+#if defined(__linux__)
+    // Completions are reaped by the I/O thread: the ring is torn down there, between two handlers.
+    if (_ioUring && !_context.stopped() && !_context.get_executor().running_in_this_thread()) {
+        std::promise<void> done;
+
+        asio::post(_context, [this, &done]() {
+            _ioUring.reset();
+            done.set_value();
+        });
+        done.get_future().wait();
+    }
+    _ioUring.reset();
+#endif
+    // A socket that never connected (e.g. a server's) has nothing to shut down.
+    asio::error_code ec;
+
+    _socket.shutdown(udp::socket::shutdown_send, ec);
+    _socket.close(ec);
+}
+
+void Peer::setIoBackend(const IoBackend backend)
+{
+#if !defined(__linux__)
+    if (backend != IoBackend::kAsio) {
+        LOG_WARN("This I/O backend is only available on Linux. Falling back to asio.");
+        return;
+    }
+#endif
+    _ioBackend = backend;
+}
+
+void Peer::setUdpOffload(const bool enabled)
+{
+#if !defined(__linux__)
+    if (enabled) {
+        LOG_WARN("UDP offload is only available on Linux. Ignoring.");
+        return;
+    }
+#endif
+    _isUdpOffloadRequested = enabled;
+}
+
+PooledBuffer Peer::acquireReceptionBuffer()
+{
+    PooledBuffer buffer = _receptionPool->acquire();
+
+    if (!buffer.isPooled()) {
+        _networkMetrics.receptionPoolMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+    return buffer;
+}
+
+void Peer::deliverDatagram(const udp::endpoint& sender,
+                           PooledBuffer datagram)
+{
+    if (datagram.size() > DATAGRAM_BUFFER_SIZE) {
+        onReceive(sender, std::move(datagram));
+        return;
+    }
+
+    PooledBuffer copy = _datagramPool->acquire();
+
+    if (!copy.isPooled()) {
+        _networkMetrics.receptionPoolMisses.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::memcpy(copy.data(), datagram.data(), datagram.size());
+    copy.resize(datagram.size());
+    datagram = {};
+    onReceive(sender, std::move(copy));
+}
+
+void Peer::disableFragmentation()
+{
+#if defined(__linux__)
+    const int fd = _socket.native_handle();
+    const int value = IP_PMTUDISC_PROBE;
+
+    if (setsockopt(fd, IPPROTO_IP, IP_MTU_DISCOVER, &value, sizeof(value)) != 0) {
+        LOG_WARN("Could not set the don't fragment bit ({}). Path MTU probes may be fragmented.",
+                 std::strerror(errno));
+    }
+#endif
 }
 
 void Peer::receive()
@@ -28,8 +219,10 @@ void Peer::receive()
 
     LOG_DEBUG("Listening...");
 
+    _receptionBuffer = acquireReceptionBuffer();
+
     _socket.async_receive_from(
-        asio::buffer(_receptionBuffer),
+        asio::buffer(_receptionBuffer.data(), _receptionBuffer.capacity()),
         _tmpEndpoint,
         [this](std::error_code ec, size_t bytesReceived) {
             if (ec) {
@@ -47,26 +240,27 @@ void Peer::receive()
                          _tmpEndpoint.address().to_string(),
                          _tmpEndpoint.port());
 
+            _networkMetrics.totalReceiveCalls.fetch_add(1, std::memory_order_relaxed);
             if (bytesReceived > 0) {
                 _networkMetrics.totalBytesReceived.fetch_add(
                     bytesReceived, std::memory_order_relaxed);
                 _networkMetrics.totalPacketsReceived.fetch_add(1, std::memory_order_relaxed);
 
-                // todo: optimization is possible by making a buffer pool (avoiding buffer recreation c;)
-                auto data = std::make_shared<ByteBuffer>(
-                    _receptionBuffer.begin(), _receptionBuffer.begin() + bytesReceived);
-
-                onReceive(_tmpEndpoint, data);
+                _receptionBuffer.resize(bytesReceived);
+                deliverDatagram(_tmpEndpoint, std::move(_receptionBuffer));
             }
             receive();
         });
 }
 
 void Peer::sendToTarget(const udp::endpoint &target,
-                        std::shared_ptr<ByteBuffer> data)
+                        std::shared_ptr<ByteBuffer> data,
+                        std::shared_ptr<const ByteBuffer> payload)
 {
-    LOG_TRACE_R3(
-        "Sending {} bytes to {}:{}.", data->size(), target.address().to_string(), target.port());
+    LOG_TRACE_R3("Sending {} bytes to {}:{}.",
+                 data->size() + (payload ? payload->size() : 0),
+                 target.address().to_string(),
+                 target.port());
 
 #if defined(RTNT_TESTS)
     uint8_t lossPercent = _simulatedPacketLossPercentage.load();
@@ -82,19 +276,353 @@ void Peer::sendToTarget(const udp::endpoint &target,
     }
 #endif
 
+    if (_ioBackend != IoBackend::kAsio) {
+        std::lock_guard lock(_outgoingMutex);
+        _outgoingDatagrams.push_back({target, std::move(data), std::move(payload)});
+        return;
+    }
+    asyncSend(target, std::move(data), std::move(payload));
+}
+
+void Peer::asyncSend(const udp::endpoint &target,
+                     std::shared_ptr<ByteBuffer> data,
+                     std::shared_ptr<const ByteBuffer> payload)
+{
+    const std::array buffers{asio::buffer(std::as_const(*data)),
+                             payload ? asio::buffer(*payload) : asio::const_buffer{}};
+
     _socket.async_send_to(
-        asio::buffer(*data), target, [this, target, data](std::error_code ec, size_t bytesSent) {
+        buffers,
+        target,
+        [this, target, data, payload](std::error_code ec, size_t bytesSent) {
             if (ec) {
                 LOG_ERR("Encountered an error while sending data: {}.", ec.message());
                 return;
             }
 
-            _networkMetrics.totalBytesSent.fetch_add(data->size(), std::memory_order_relaxed);
+            _networkMetrics.totalBytesSent.fetch_add(bytesSent, std::memory_order_relaxed);
             _networkMetrics.totalPacketsSent.fetch_add(1, std::memory_order_relaxed);
+            _networkMetrics.totalSendCalls.fetch_add(1, std::memory_order_relaxed);
 
             LOG_TRACE_R3(
                 "Sent {} bytes to {}:{}.", bytesSent, target.address().to_string(), target.port());
         });
 }
 
+void Peer::flush()
+{
+#if defined(__linux__)
+    if (_ioBackend == IoBackend::kAsio) {
+        return;
+    }
+
+    std::vector<OutgoingDatagram> datagrams;
+
+    {
+        std::lock_guard lock(_outgoingMutex);
+        datagrams.swap(_outgoingDatagrams);
+    }
+
+    if (datagrams.empty()) {
+        return;
+    }
+    if (_ioBackend == IoBackend::kIoUring && _ioUring) {
+        // Datagrams that do not fit in the ring are handed to asio instead of being dropped.
+        for (size_t i = _ioUring->send(datagrams); i < datagrams.size(); i++) {
+            asyncSend(datagrams[i].target,
+                      std::move(datagrams[i].data),
+                      std::move(datagrams[i].payload));
+        }
+        return;
+    }
+    sendBatch(datagrams);
+#endif
+}
+
+#if defined(__linux__)
+
+void Peer::enableUdpOffload()
+{
+    const int fd = _socket.native_handle();
+    int value = 1;
+
+    if (setsockopt(fd, SOL_UDP, UDP_GRO, &value, sizeof(value)) == 0) {
+        _isGroEnabled = true;
+    } else {
+        LOG_WARN("UDP GRO is not supported ({}). Falling back to plain receptions.",
+                 std::strerror(errno));
+    }
+
+    // The option can be read (and is 0) on every kernel supporting segmentation offload.
+    value = 0;
+    socklen_t size = sizeof(value);
+
+    if (getsockopt(fd, SOL_UDP, UDP_SEGMENT, &value, &size) == 0) {
+        _isGsoEnabled.store(true, std::memory_order_relaxed);
+    } else {
+        LOG_WARN("UDP GSO is not supported ({}). Falling back to plain sends.",
+                 std::strerror(errno));
+    }
+
+    LOG_INFO("UDP offload: GSO {}, GRO {}.",
+             _isGsoEnabled.load() ? "enabled" : "disabled",
+             _isGroEnabled ? "enabled" : "disabled");
+}
+
+void Peer::receiveBatch()
+{
+    if (!_socket.is_open()) {
+        LOG_WARN("Trying to receive with a closed socket.");
+        return;
+    }
+
+    LOG_DEBUG("Listening (batched)...");
+
+    _socket.async_wait(udp::socket::wait_read, [this](std::error_code ec) {
+        if (ec) {
+            if (ec != asio::error::operation_aborted) {
+                LOG_ERR("Encountered an error while waiting for data: {}.", ec.message());
+                receiveBatch();
+            }
+            return;
+        }
+
+        drainSocket();
+        Peer::flush();  // Sends the ACKs and replies produced while handling the batch.
+        receiveBatch();
+    });
+}
+
+void Peer::drainSocket()
+{
+    struct alignas(cmsghdr) Control
+    {
+        char data[CMSG_SPACE(sizeof(int))];
+    };
+
+    std::array<mmsghdr, RECEIVE_BATCH_SIZE> messages{};
+    std::array<iovec, RECEIVE_BATCH_SIZE> vectors{};
+    std::array<sockaddr_storage, RECEIVE_BATCH_SIZE> addresses{};
+    std::array<Control, RECEIVE_BATCH_SIZE> controls{};
+
+    while (true) {
+        for (size_t i = 0; i < RECEIVE_BATCH_SIZE; i++) {
+            if (!_receptionBatch[i]) {
+                _receptionBatch[i] = acquireReceptionBuffer();
+            }
+            vectors[i] = {_receptionBatch[i].data(), _receptionBatch[i].capacity()};
+            messages[i].msg_hdr = {};
+            messages[i].msg_hdr.msg_name = &addresses[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+            messages[i].msg_hdr.msg_iov = &vectors[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            if (_isGroEnabled) {
+                messages[i].msg_hdr.msg_control = controls[i].data;
+                messages[i].msg_hdr.msg_controllen = sizeof(Control);
+            }
+        }
+
+        const int count = recvmmsg(
+            _socket.native_handle(), messages.data(), RECEIVE_BATCH_SIZE, MSG_DONTWAIT, nullptr);
+
+        if (count < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                LOG_ERR("Encountered an error while receiving data: {}.", std::strerror(errno));
+            }
+            return;
+        }
+
+        _networkMetrics.totalReceiveCalls.fetch_add(1, std::memory_order_relaxed);
+        LOG_TRACE_R3("Received {} datagrams in one call.", count);
+
+        for (size_t i = 0; i < static_cast<size_t>(count); i++) {
+            const size_t bytesReceived = messages[i].msg_len;
+
+            if (bytesReceived == 0) {
+                continue;
+            }
+
+            udp::endpoint sender;
+            const size_t addressSize =
+                std::min<size_t>(messages[i].msg_hdr.msg_namelen, sender.capacity());
+
+            std::memcpy(sender.data(), &addresses[i], addressSize);
+            sender.resize(addressSize);
+
+            PooledBuffer buffer = std::move(_receptionBatch[i]);
+            const size_t segmentSize = _isGroEnabled ? receivedSegmentSize(messages[i].msg_hdr) : 0;
+
+            buffer.resize(bytesReceived);
+            _networkMetrics.totalBytesReceived.fetch_add(bytesReceived, std::memory_order_relaxed);
+
+            if (segmentSize == 0 || segmentSize >= bytesReceived) {
+                _networkMetrics.totalPacketsReceived.fetch_add(1, std::memory_order_relaxed);
+                deliverDatagram(sender, std::move(buffer));
+                continue;
+            }
+
+            // The kernel coalesced several datagrams (GRO): hand them one by one.
+            const size_t segmentCount = (bytesReceived + segmentSize - 1) / segmentSize;
+
+            _networkMetrics.totalPacketsReceived.fetch_add(segmentCount, std::memory_order_relaxed);
+            _networkMetrics.totalCoalescedDatagramsReceived.fetch_add(
+                segmentCount, std::memory_order_relaxed);
+            for (size_t offset = 0; offset < bytesReceived; offset += segmentSize) {
+                deliverDatagram(sender, buffer.slice(offset, segmentSize));
+            }
+        }
+
+        if (static_cast<size_t>(count) < RECEIVE_BATCH_SIZE) {
+            return;
+        }
+    }
+}
+
+size_t Peer::countSegments(const std::vector<OutgoingDatagram>& datagrams,
+                           const size_t first,
+                           const size_t maxVectors)
+{
+    const OutgoingDatagram& head = datagrams[first];
+    const size_t segmentSize = head.size();
+    const size_t limit = std::min(MAX_GSO_SEGMENTS, datagrams.size() - first);
+
+    if (segmentSize == 0 || segmentSize > MAX_GSO_SEGMENT_SIZE) {
+        return 1;
+    }
+
+    size_t length = 1;
+    size_t totalSize = segmentSize;
+    size_t vectorCount = head.payload ? 2 : 1;
+
+    while (length < limit) {
+        const OutgoingDatagram& datagram = datagrams[first + length];
+        const size_t size = datagram.size();
+        const size_t vectors = datagram.payload ? 2 : 1;
+
+        if (datagram.target != head.target || size == 0 || size > segmentSize ||
+            totalSize + size > MAX_UDP_PAYLOAD || vectorCount + vectors > maxVectors) {
+            break;
+        }
+        length++;
+        totalSize += size;
+        vectorCount += vectors;
+        if (size < segmentSize) {  // Only the last segment can be smaller.
+            break;
+        }
+    }
+    return length;
+}
+
+void Peer::sendBatch(std::vector<OutgoingDatagram>& datagrams)
+{
+    struct alignas(cmsghdr) Control
+    {
+        char data[CMSG_SPACE(sizeof(uint16_t))];
+    };
+
+    std::array<mmsghdr, SEND_BATCH_SIZE> messages{};
+    std::array<iovec, SEND_BATCH_SIZE * 4> vectors{};
+    std::array<Control, SEND_BATCH_SIZE> controls{};
+    std::array<size_t, SEND_BATCH_SIZE> segmentCounts{};
+    size_t sent = 0;
+
+    while (sent < datagrams.size()) {
+        const bool isGsoEnabled = _isGsoEnabled.load(std::memory_order_relaxed);
+        size_t messageCount = 0;
+        size_t vectorCount = 0;
+
+        // Each message is either a single datagram, or a run of datagrams segmented by the kernel.
+        // A datagram takes two vectors when its payload is shared.
+        for (size_t next = sent; next < datagrams.size() && messageCount < SEND_BATCH_SIZE &&
+                                 vectorCount + 2 <= vectors.size();) {
+            const size_t length =
+                isGsoEnabled ? countSegments(datagrams, next, vectors.size() - vectorCount) : 1;
+            OutgoingDatagram& datagram = datagrams[next];
+            msghdr& header = messages[messageCount].msg_hdr;
+
+            header = {};
+            header.msg_name = datagram.target.data();
+            header.msg_namelen = static_cast<socklen_t>(datagram.target.size());
+            header.msg_iov = &vectors[vectorCount];
+            for (size_t i = 0; i < length; i++) {
+                const OutgoingDatagram& segment = datagrams[next + i];
+
+                vectors[vectorCount++] = {segment.data->data(), segment.data->size()};
+                if (segment.payload) {  // Only read by the kernel.
+                    vectors[vectorCount++] = {const_cast<uint8_t*>(segment.payload->data()),
+                                              segment.payload->size()};
+                }
+                header.msg_iovlen += segment.payload ? 2 : 1;
+            }
+
+            if (length > 1) {
+                header.msg_control = controls[messageCount].data;
+                header.msg_controllen = sizeof(Control);
+
+                cmsghdr* control = CMSG_FIRSTHDR(&header);
+                const auto segmentSize = static_cast<uint16_t>(datagram.size());
+
+                control->cmsg_level = SOL_UDP;
+                control->cmsg_type = UDP_SEGMENT;
+                control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+                std::memcpy(CMSG_DATA(control), &segmentSize, sizeof(segmentSize));
+            }
+
+            segmentCounts[messageCount++] = length;
+            next += length;
+        }
+
+        const int result = sendmmsg(_socket.native_handle(),
+                                    messages.data(),
+                                    static_cast<unsigned>(messageCount),
+                                    MSG_DONTWAIT);
+
+        if (result == 0) {
+            break;
+        }
+        if (result < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            }
+            if (segmentCounts[0] > 1) {
+                LOG_WARN("UDP GSO send failed ({}). Falling back to plain sends.",
+                         std::strerror(errno));
+                _isGsoEnabled.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            // The first datagram of the batch is the faulty one: drop it and keep going.
+            LOG_ERR("Encountered an error while sending data: {}.", std::strerror(errno));
+            sent++;
+            continue;
+        }
+
+        size_t datagramCount = 0;
+
+        for (size_t i = 0; i < static_cast<size_t>(result); i++) {
+            _networkMetrics.totalBytesSent.fetch_add(messages[i].msg_len, std::memory_order_relaxed);
+            if (segmentCounts[i] > 1) {
+                _networkMetrics.totalSegmentedDatagramsSent.fetch_add(
+                    segmentCounts[i], std::memory_order_relaxed);
+            }
+            datagramCount += segmentCounts[i];
+        }
+        _networkMetrics.totalSendCalls.fetch_add(1, std::memory_order_relaxed);
+        _networkMetrics.totalPacketsSent.fetch_add(datagramCount, std::memory_order_relaxed);
+        LOG_TRACE_R3("Sent {} datagrams in one call.", datagramCount);
+
+        sent += datagramCount;
+    }
+
+    if (sent < datagrams.size()) {
+        LOG_DEBUG("Socket is full, handing {} datagrams to asio.", datagrams.size() - sent);
+    }
+    for (; sent < datagrams.size(); sent++) {
+        asyncSend(datagrams[sent].target,
+                  std::move(datagrams[sent].data),
+                  std::move(datagrams[sent].payload));
+    }
+}
+
+#endif
+
 }  // namespace rtnt::core
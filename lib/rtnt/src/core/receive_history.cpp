@@ -0,0 +1,144 @@
+#include "rtnt/core/receive_history.hpp"
+
+#include <algorithm>
+#include <bit>
+
+namespace rtnt::core {
+
+namespace {
+
+/**
+ * @return  The mask of @code count@endcode bits, starting at @code first@endcode.
+ */
+uint64_t getMask(const size_t first,
+                 const size_t count)
+{
+    return (count == 64 ? ~0ULL : (1ULL << count) - 1) << first;
+}
+
+}  // namespace
+
+packet::AcknowledgeBitfield ReceiveHistory::getBitfield() const
+{
+    packet::AcknowledgeBitfield bitfield = 0;
+
+    for (uint32_t i = 0; i < 32; ++i) {
+        if (contains(_head - (i + 1))) {
+            bitfield |= 1U << i;
+        }
+    }
+    return bitfield;
+}
+
+bool ReceiveHistory::contains(const packet::SequenceId sequenceId) const
+{
+    if (!_hasReceived) {
+        return false;
+    }
+
+    const auto age = static_cast<int32_t>(_head - sequenceId);
+
+    if (age < 0 || static_cast<size_t>(age) >= packet::MAX_PACKET_HISTORY_SIZE) {
+        return false;
+    }
+    return test(_received, getBit(sequenceId));
+}
+
+bool ReceiveHistory::isTooOld(const packet::SequenceId sequenceId) const
+{
+    const auto age = static_cast<int32_t>(_head - sequenceId);
+
+    return _hasReceived && age >= 0 &&
+           static_cast<size_t>(age) >= packet::MAX_PACKET_HISTORY_SIZE;
+}
+
+void ReceiveHistory::record(const packet::SequenceId sequenceId)
+{
+    if (!_hasReceived) {
+        _hasReceived = true;
+        _head = sequenceId;
+    }
+
+    const auto advance = static_cast<int32_t>(sequenceId - _head);
+
+    if (advance > 0) {
+        clear(_head + 1,
+              std::min(static_cast<size_t>(advance), packet::MAX_PACKET_HISTORY_SIZE));
+        _head = sequenceId;
+    } else if (isTooOld(sequenceId)) {
+        if (std::ranges::find(_oldPendingAcks, sequenceId) == _oldPendingAcks.end()) {
+            _oldPendingAcks.push_back(sequenceId);
+            _pendingAckCount++;
+        }
+        return;
+    }
+
+    const size_t bit = getBit(sequenceId);
+    _received[bit / 64] |= 1ULL << (bit % 64);
+}
+
+void ReceiveHistory::markPendingAck(const packet::SequenceId sequenceId)
+{
+    if (!contains(sequenceId)) {
+        return;
+    }
+
+    const size_t bit = getBit(sequenceId);
+
+    if (!test(_pendingAcks, bit)) {
+        _pendingAcks[bit / 64] |= 1ULL << (bit % 64);
+        _pendingAckCount++;
+    }
+}
+
+void ReceiveHistory::takePendingAcks(std::deque<packet::SequenceId>& acks,
+                                     const size_t maxCount)
+{
+    // The oldest Sequence ID of the window, which shares its bit with the one after the head.
+    packet::SequenceId sequenceId = _head + 1 - packet::MAX_PACKET_HISTORY_SIZE;
+    size_t remaining = packet::MAX_PACKET_HISTORY_SIZE;
+    size_t taken = 0;
+
+    for (; !_oldPendingAcks.empty() && taken < maxCount; taken++) {
+        acks.push_back(_oldPendingAcks.front());
+        _oldPendingAcks.pop_front();
+        _pendingAckCount--;
+    }
+
+    while (remaining > 0 && _pendingAckCount > 0 && taken < maxCount) {
+        const size_t bit = getBit(sequenceId);
+        const size_t count = std::min(remaining, 64 - bit % 64);
+        uint64_t& word = _pendingAcks[bit / 64];
+        uint64_t bits = word & getMask(bit % 64, count);
+
+        while (bits != 0 && taken < maxCount) {
+            const auto offset = static_cast<uint32_t>(std::countr_zero(bits));
+
+            acks.push_back(sequenceId + (offset - static_cast<uint32_t>(bit % 64)));
+            word &= ~(1ULL << offset);
+            bits &= bits - 1;
+            _pendingAckCount--;
+            taken++;
+        }
+        sequenceId += static_cast<packet::SequenceId>(count);
+        remaining -= count;
+    }
+}
+
+void ReceiveHistory::clear(packet::SequenceId first,
+                           size_t count)
+{
+    while (count > 0) {
+        const size_t bit = getBit(first);
+        const size_t span = std::min(count, 64 - bit % 64);
+        const uint64_t mask = getMask(bit % 64, span);
+
+        _pendingAckCount -= static_cast<size_t>(std::popcount(_pendingAcks[bit / 64] & mask));
+        _received[bit / 64] &= ~mask;
+        _pendingAcks[bit / 64] &= ~mask;
+        first += static_cast<packet::SequenceId>(span);
+        count -= span;
+    }
+}
+
+}  // namespace rtnt::core
@@ -0,0 +1,84 @@
+#include "rtnt/core/reorder_buffer.hpp"
+
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+ReorderBuffer::Result ReorderBuffer::receive(const packet::OrderId orderId,
+                                             Packet&& packet,
+                                             std::vector<Packet>& readyPackets)
+{
+    const auto distance = static_cast<int32_t>(orderId - _nextExpected);
+
+    if (distance < 0) {
+        return Result::kDuplicate;
+    }
+
+    if (distance > 0) {
+        if (isTooFar(orderId)) {
+            return Result::kTooFar;
+        }
+        if (static_cast<size_t>(distance) >= _slots.size()) {
+            grow(static_cast<size_t>(distance));
+        }
+
+        const size_t slot = getSlot(orderId);
+
+        if (isOccupied(slot)) {
+            return Result::kDuplicate;
+        }
+        _slots[slot] = std::move(packet);
+        _occupancy[slot / 64] |= 1ULL << (slot % 64);
+        _size++;
+        return Result::kBuffered;
+    }
+
+    readyPackets.push_back(std::move(packet));
+    _nextExpected++;
+
+    while (_size > 0) {
+        const size_t slot = getSlot(_nextExpected);
+
+        if (!isOccupied(slot)) {
+            break;
+        }
+        readyPackets.push_back(std::move(_slots[slot]));
+        _slots[slot] = Packet();  // Releases the received buffer.
+        _occupancy[slot / 64] &= ~(1ULL << (slot % 64));
+        _size--;
+        _nextExpected++;
+    }
+    return Result::kDelivered;
+}
+
+void ReorderBuffer::grow(const size_t distance)
+{
+    size_t capacity = _slots.empty() ? packet::REORDER_BUFFER_INITIAL_SIZE : _slots.size();
+
+    while (capacity <= distance) {
+        capacity *= 2;
+    }
+
+    std::vector<Packet> slots(capacity);
+    std::vector<uint64_t> occupancy(capacity / 64);
+
+    for (size_t slot = 0; slot < _slots.size(); slot++) {
+        if (!isOccupied(slot)) {
+            continue;
+        }
+
+        // Every buffered Order ID is within a capacity ahead of the next expected one.
+        const packet::OrderId orderId =
+            _nextExpected + static_cast<packet::OrderId>((slot - getSlot(_nextExpected)) &
+                                                         (_slots.size() - 1));
+        const size_t newSlot = orderId & (capacity - 1);
+
+        slots[newSlot] = std::move(_slots[slot]);
+        occupancy[newSlot / 64] |= 1ULL << (newSlot % 64);
+    }
+
+    _slots = std::move(slots);
+    _occupancy = std::move(occupancy);
+}
+
+}  // namespace rtnt::core
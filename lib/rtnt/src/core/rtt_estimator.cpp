@@ -0,0 +1,38 @@
+#include "rtnt/core/rtt_estimator.hpp"
+
+#include <algorithm>
+
+namespace rtnt::core {
+
+void RttEstimator::addSample(const microseconds rtt)
+{
+    if (!_hasSample) {
+        _hasSample = true;
+        _smoothedRtt = rtt;
+        _rttVariation = rtt / 2;
+    } else {
+        const microseconds error = _smoothedRtt > rtt ? _smoothedRtt - rtt : rtt - _smoothedRtt;
+
+        _rttVariation = (_rttVariation * 3 + error) / 4;
+        _smoothedRtt = (_smoothedRtt * 7 + rtt) / 8;
+    }
+
+    _answerTimeout = std::clamp<microseconds>(_smoothedRtt + _rttVariation * 4,
+                                              packet::MIN_RESEND_TIMEOUT,
+                                              packet::MAX_RESEND_TIMEOUT);
+    _retransmitTimeout = std::clamp<microseconds>(_smoothedRtt + packet::MAX_ACK_DELAY,
+                                                  _answerTimeout,
+                                                  packet::MAX_RESEND_TIMEOUT);
+}
+
+microseconds RttEstimator::getRetransmitTimeout(const uint8_t retries) const
+{
+    microseconds timeout = _retransmitTimeout;
+
+    for (uint8_t i = 0; i < retries && timeout < packet::MAX_RESEND_TIMEOUT; i++) {
+        timeout *= 2;
+    }
+    return std::min<microseconds>(timeout, packet::MAX_RESEND_TIMEOUT);
+}
+
+}  // namespace rtnt::core
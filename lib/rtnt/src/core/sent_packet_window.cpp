@@ -0,0 +1,96 @@
+#include "rtnt/core/sent_packet_window.hpp"
+
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+SentPacketWindow::SentPacketWindow()
+    : _slots(packet::SENT_PACKET_WINDOW_INITIAL_SIZE),
+      _occupancy(packet::SENT_PACKET_WINDOW_INITIAL_SIZE / 64)
+{
+}
+
+void SentPacketWindow::insert(SentPacketInfo info)
+{
+    size_t slot = getSlot(info.sequenceId);
+
+    while (isOccupied(slot) && _slots[slot].sequenceId != info.sequenceId) {
+        if (_slots.size() >= packet::MAX_SENT_PACKET_WINDOW_SIZE) {
+            const packet::SequenceId sequenceId = info.sequenceId;
+
+            if (_overflow.insert_or_assign(sequenceId, std::move(info)).second) {
+                _size++;
+            }
+            return;
+        }
+        grow();
+        slot = getSlot(info.sequenceId);
+    }
+
+    if (!isOccupied(slot)) {
+        _occupancy[slot / 64] |= 1ULL << (slot % 64);
+        _size++;
+    }
+    _slots[slot] = std::move(info);
+}
+
+SentPacketInfo* SentPacketWindow::find(const packet::SequenceId sequenceId)
+{
+    const size_t slot = getSlot(sequenceId);
+
+    if (isOccupied(slot) && _slots[slot].sequenceId == sequenceId) {
+        return &_slots[slot];
+    }
+    if (_overflow.empty()) {
+        return nullptr;
+    }
+
+    const auto it = _overflow.find(sequenceId);
+
+    return it != _overflow.end() ? &it->second : nullptr;
+}
+
+bool SentPacketWindow::erase(const packet::SequenceId sequenceId)
+{
+    const size_t slot = getSlot(sequenceId);
+
+    if (!isOccupied(slot) || _slots[slot].sequenceId != sequenceId) {
+        if (_overflow.erase(sequenceId) == 0) {
+            return false;
+        }
+        _size--;
+        return true;
+    }
+
+    _occupancy[slot / 64] &= ~(1ULL << (slot % 64));
+    _slots[slot].packet = Packet();  // Releases the payload right away.
+    _slots[slot].datagram.reset();
+    _size--;
+    return true;
+}
+
+size_t SentPacketWindow::erase(const packet::AcknowledgeId acknowledgeId,
+                               const packet::AcknowledgeBitfield bitfield)
+{
+    return erase(acknowledgeId, bitfield, [](const SentPacketInfo&) {});
+}
+
+void SentPacketWindow::grow()
+{
+    std::vector<SentPacketInfo> slots(_slots.size() * 2);
+    std::vector<uint64_t> occupancy(_occupancy.size() * 2);
+    const size_t mask = slots.size() - 1;
+
+    forEach([&](SentPacketInfo& info) {
+        const size_t slot = info.sequenceId & mask;
+
+        occupancy[slot / 64] |= 1ULL << (slot % 64);
+        slots[slot] = std::move(info);
+        return true;
+    });
+
+    _slots = std::move(slots);
+    _occupancy = std::move(occupancy);
+}
+
+}  // namespace rtnt::core
@@ -0,0 +1,29 @@
+#include "rtnt/core/sequence_filter.hpp"
+
+#include <bit>
+
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+bool SequenceFilter::accept(const packet::SequenceKey key,
+                            const packet::SequenceId sequenceId)
+{
+    if (_entries.empty()) {
+        _entries.resize(packet::SEQUENCE_FILTER_SIZE);
+    }
+
+    // Fibonacci hashing: consecutive keys (e.g. entity IDs) spread over the slots.
+    constexpr int shift = 32 - std::countr_zero(packet::SEQUENCE_FILTER_SIZE);
+    Entry& entry = _entries[static_cast<uint32_t>(key * 0x9E3779B9U) >> shift];
+
+    if (entry.isUsed && entry.key == key &&
+        static_cast<int32_t>(sequenceId - entry.newestSequenceId) <= 0) {
+        return false;
+    }
+
+    entry = {.key = key, .newestSequenceId = sequenceId, .isUsed = true};
+    return true;
+}
+
+}  // namespace rtnt::core
@@ -1,42 +1,167 @@
 #include "rtnt/core/server.hpp"
 
 #include "logger/Logger.h"
+#include "logger/Thread.h"
 #include "rtnt/core/packets/connect.hpp"
 
 namespace rtnt::core {
 
+/**
+ * @class   Server::ShardPeer
+ * @brief   Socket of a shard of the Server, but the first one (which is the Server itself).
+ */
+class Server::ShardPeer final : public Peer
+{
+public:
+    ShardPeer(asio::io_context& context,
+              Server& owner,
+              const unsigned short port,
+              const size_t shardIndex)
+        : Peer(context, owner.getNetworkMetrics()),
+          _owner(owner),
+          _shardIndex(shardIndex)
+    {
+        server(port, true);
+        setIoBackend(owner.getIoBackend());
+        setUdpOffload(owner.isUdpOffloadRequested());
+    }
+
+protected:
+    void onReceive(const udp::endpoint& sender,
+                   PooledBuffer data) override
+    {
+        _owner._internal_receive(*_owner._shards[_shardIndex], sender, std::move(data));
+    }
+
+private:
+    Server& _owner;
+    const size_t _shardIndex;
+};
+
 Server::Server(asio::io_context& context,
                const unsigned short port)
     : Peer(context)
 {
     server(port);
+    _shards.push_back(std::make_unique<Shard>(*this));
+}
+
+Server::~Server()
+{
+    _internal_stopShardThreads();
+}
+
+void Server::setShardCount(const size_t count)
+{
+#if !defined(__linux__)
+    if (count > 1) {
+        LOG_WARN("I/O shards are only available on Linux. Falling back to a single one.");
+        return;
+    }
+#endif
+    _requestedShardCount = std::max<size_t>(count, 1);
+}
+
+void Server::start()
+{
+    _internal_startShards();
+    Peer::start();
+}
+
+void Server::flush()
+{
+    for (const auto& shard : _shards) {
+        shard->peer.Peer::flush();
+    }
+}
+
+void Server::stop()
+{
+    // The I/O threads of the other shards must be done with their rings before they are closed.
+    _internal_stopShardThreads();
+    for (const auto& shard : _shards) {
+        shard->peer.Peer::stop();
+    }
+}
+
+void Server::_internal_stopShardThreads()
+{
+    for (const auto& context : _shardContexts) {
+        context->stop();
+    }
+    for (std::thread& thread : _shardThreads) {
+        thread.join();
+    }
+    _shardThreads.clear();
+}
+
+void Server::_internal_startShards()
+{
+    if (_requestedShardCount <= _shards.size()) {
+        return;
+    }
+
+    // The socket of the first shard is bound again, so that the others can share its port.
+    const unsigned short port = getLocalPort();
+
+    server(port, true);
+    for (size_t i = _shards.size(); i < _requestedShardCount; i++) {
+        asio::io_context& context =
+            *_shardContexts.emplace_back(std::make_unique<asio::io_context>());
+        ShardPeer& peer =
+            *_shardPeers.emplace_back(std::make_unique<ShardPeer>(context, *this, port, i));
+
+        _shards.push_back(std::make_unique<Shard>(peer));
+        peer.start();
+        _shardThreads.emplace_back([&context]() {
+            logger::setThreadLabel("I/O Shard");
+            context.run();
+        });
+    }
+    LOG_INFO("Receiving on {} I/O shards.", _shards.size());
 }
 
 void Server::update(milliseconds timeout)
 {
     _processEvents();
 
+    const auto now = steady_clock::now();
     std::vector<std::shared_ptr<Session>> disconnectedSessions;
 
-    {
-        std::lock_guard lock(_sessionsMutex);
+    LOG_TRACE_R3("Updating server state. Time is {}", now.time_since_epoch().count());
 
-        const auto now = steady_clock::now();
+    for (const auto& shard : _shards) {
+        std::vector<SessionTimer> expiredTimers;
 
-        LOG_TRACE_R3("Updating server state. Time is {}", now.time_since_epoch().count());
-        for (auto it = _sessions.begin(); it != _sessions.end();) {
-            auto& session = it->second;
-            auto lastSeen = session->getLastSeenTimestamp();
-            auto age = duration_cast<milliseconds>(now - lastSeen);
+        {
+            std::lock_guard lock(shard->timersMutex);
+            shard->timers.advance(
+                now, [&](SessionTimer& timer) { expiredTimers.push_back(std::move(timer)); });
+        }
+
+        for (const auto& [session, isTimeoutCheck] : expiredTimers) {
+            if (shard->sessions.find(session->getEndpoint()) != session) {  // Already removed.
+                continue;
+            }
+
+            const auto lastSeen = session->getLastSeenTimestamp();
+            const auto age = duration_cast<milliseconds>(now - lastSeen);
 
             if (age > timeout || session->shouldClose()) {
                 disconnectedSessions.push_back(session);
-                it = _sessions.erase(it);
+                shard->sessions.erase(session->getEndpoint(), session);
+            } else if (isTimeoutCheck) {
+                std::lock_guard timersLock(shard->timersMutex);
+                shard->timers.schedule(lastSeen + timeout + TIMER_WHEEL_RESOLUTION,
+                                       {session, true});
             } else {
                 session->update();
-                ++it;
+                session->flush();
             }
         }
+
+        // The I/O threads only look sessions up for a few probes: this never waits long.
+        shard->sessions.reclaim();
     }
 
     for (const auto& session : disconnectedSessions) {
@@ -44,49 +169,74 @@ void Server::update(milliseconds timeout)
             _onDisconnect(session);
         }
     }
+
+    flush();
 }
 
 void Server::onReceive(const udp::endpoint& sender,
-                       std::shared_ptr<ByteBuffer> data)
+                       PooledBuffer data)
 {
-    std::shared_ptr<Session> session;
-    bool isNewConnection = false;
+    _internal_receive(*_shards.front(), sender, std::move(data));
+}
 
-    {
-        std::lock_guard lock(_sessionsMutex);
+void Server::_internal_receive(Shard& shard,
+                               const udp::endpoint& sender,
+                               PooledBuffer data)
+{
+    std::shared_ptr<Session> session = shard.sessions.find(sender);
+    bool isNewConnection = false;
 
-        auto it = _sessions.find(sender);
+    if (session) {  // Session found
+        if (packet::is<packet::internal::Connect>(data.view())) {
+            LOG_DEBUG("Received duplicate CONNECT from existing session. Resending ACK.");
 
-        if (it != _sessions.end()) {  // Session found
-            session = it->second;
+            packet::internal::ConnectAck ackPacket;
+            ackPacket.assignedSessionId = session->getId();
 
-            if (packet::is<packet::internal::Connect>(*data)) {
-                LOG_DEBUG("Received duplicate CONNECT from existing session. Resending ACK.");
+            Packet p(packet::internal::ConnectAck::kId, packet::internal::ConnectAck::kFlag);
+            p << ackPacket;
+            session->send(p);
+            session->flush();
+            return;
+        }
+    } else {  // New connection
+        if (!packet::is<packet::internal::Connect>(
+                data.view())) {  // todo: you can optimize this because another call to Header::parse is made in Session::handleIncoming.
+            LOG_DEBUG("Not CONNECT packet, ignoring...");
+            return;
+        }
 
-                packet::internal::ConnectAck ackPacket;
-                ackPacket.assignedSessionId = session->getId();
+        LOG_DEBUG("Is CONNECT packet, creating session.");
 
-                Packet p(packet::internal::ConnectAck::kId, packet::internal::ConnectAck::kFlag);
-                p << ackPacket;
-                session->send(p);
-                return;
-            }
-        } else {  // New connection
-            if (!packet::is<packet::internal::Connect>(
-                    *data)) {  // todo: you can optimize this because another call to Header::parse is made in Session::handleIncoming.
-                LOG_DEBUG("Not CONNECT packet, ignoring...");
-                return;
-            }
+        // The session stays in this shard, and sends through its socket.
+        Peer& peer = shard.peer;
+        auto created = std::make_shared<Session>(
+            sender, [&peer, sender](std::shared_ptr<ByteBuffer> rawBytes) {
+                peer.sendToTarget(sender, rawBytes);
+            });
 
-            LOG_DEBUG("Is CONNECT packet, creating session.");
+        created->setGatherSendFunction(
+            [&peer, sender](std::shared_ptr<ByteBuffer> header,
+                            std::shared_ptr<const ByteBuffer> payload) {
+                peer.sendToTarget(sender, std::move(header), std::move(payload));
+            });
+        created->setWakeUpFunction(
+            [&shard, weakSession = std::weak_ptr(created)](time_point<steady_clock> time) {
+                if (auto locked = weakSession.lock()) {
+                    std::lock_guard timersLock(shard.timersMutex);
+                    shard.timers.schedule(time, {std::move(locked), false});
+                }
+            });
 
-            session = std::make_shared<Session>(
-                sender, [this, sender](std::shared_ptr<ByteBuffer> rawBytes) {
-                    this->sendToTarget(sender, rawBytes);
-                });
-            _sessions[sender] = session;
-            isNewConnection = true;
+        session = shard.sessions.insert(sender, created);
+        if (session != created) {  // Created by another thread running the same io_context.
+            return;
         }
+        isNewConnection = true;
+
+        // The timeout is only known by update(), which schedules the next checks.
+        std::lock_guard timersLock(shard.timersMutex);
+        shard.timers.schedule(steady_clock::now(), {session, true});
     }
 
     if (isNewConnection) {
@@ -104,7 +254,7 @@ void Server::onReceive(const udp::endpoint& sender,
     }
 
     for (Packet& packet : packetsToProcess) {
-        _eventQueue.push([this, session, pkt = packet]() mutable {
+        _eventQueue.push([this, session, pkt = std::move(packet)]() mutable {
             _packetDispatcher.dispatch(session, pkt);
             if (pkt.getId() >= 128 && _onMessage) {
                 _onMessage(session, pkt);
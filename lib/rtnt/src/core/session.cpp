@@ -1,15 +1,43 @@
 #include "rtnt/core/session.hpp"
 
-#include <ranges>
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
 
 #include "logger/Logger.h"
 #include "rtnt/common/constants.hpp"
+#include "rtnt/core/packets/probe.hpp"
 #include "rtnt/core/packets/rich_ack.hpp"
 
 namespace rtnt::core {
 
 static std::atomic<session::Id> globalSessionIdCounter{0};
 
+/**
+ * @brief   Rewrites the ACK fields in the header of a wire-format datagram, leaving the rest as is.
+ */
+static void patchAcknowledgeInfo(ByteBuffer& datagram,
+                                 const packet::AcknowledgeId acknowledgeId,
+                                 const packet::AcknowledgeBitfield acknowledgeBitfield,
+                                 const bool hasAck)
+{
+    const auto networkId = endian::swap(acknowledgeId);
+    const auto networkBitfield = endian::swap(acknowledgeBitfield);
+    uint8_t& flags = datagram[offsetof(packet::Header, flags)];
+
+    std::memcpy(datagram.data() + offsetof(packet::Header, acknowledgeId),
+                &networkId,
+                sizeof(networkId));
+    std::memcpy(datagram.data() + offsetof(packet::Header, acknowledgeBitfield),
+                &networkBitfield,
+                sizeof(networkBitfield));
+    if (hasAck) {
+        flags |= static_cast<uint8_t>(packet::Flag::kHasAck);
+    } else {
+        flags &= static_cast<uint8_t>(~static_cast<uint8_t>(packet::Flag::kHasAck));
+    }
+}
+
 Session::Session(udp::endpoint endpoint,
                  SendToPeerFunction sendToPeerFunction)
     : _id(globalSessionIdCounter++),
@@ -19,7 +47,7 @@ Session::Session(udp::endpoint endpoint,
 {
 }
 
-std::vector<Packet> Session::handleIncoming(std::shared_ptr<ByteBuffer> rawData)
+std::vector<Packet> Session::handleIncoming(const PooledBuffer& rawData)
 {
     std::lock_guard lock(_mutex);
 
@@ -29,10 +57,10 @@ std::vector<Packet> Session::handleIncoming(std::shared_ptr<ByteBuffer> rawData)
         "Handling incoming raw data\n"
         "Size: {} bytes\n"
         "Data (N): {}",
-        rawData->size(),
-        byteBufferToHexString(*rawData));
+        rawData.size(),
+        byteBufferToHexString(rawData.view()));
 
-    const packet::parsing::Result headerParsingResult = packet::Header::parse(*rawData);
+    const packet::parsing::Result headerParsingResult = packet::Header::parse(rawData.view());
 
     if (!headerParsingResult) {
         LOG_ERR("Error while handling packet: {}",
@@ -44,10 +72,17 @@ std::vector<Packet> Session::handleIncoming(std::shared_ptr<ByteBuffer> rawData)
 
     _lastSeen = steady_clock::now();
 
-    {
-        auto& channelMetrics = _sessionMetrics.channels[header.channelId];
-        channelMetrics.packetsReceived.fetch_add(1, std::memory_order_relaxed);
-        channelMetrics.bytesReceived.fetch_add(rawData->size(), std::memory_order_relaxed);
+    // Both peers speak the oldest of their versions, learnt from the handshake packets.
+    if (header.messageId == static_cast<packet::Id>(packet::SystemMessageId::kConnect) ||
+        header.messageId == static_cast<packet::Id>(packet::SystemMessageId::kConnectAck)) {
+        _protocolVersion = std::min(PROTOCOL_VER, header.protocolVersion);
+        LOG_DEBUG("Negotiated protocol version {:#06x}.", _protocolVersion);
+
+        // The path is probed once, as soon as the remote peer is known to answer probes.
+        if (_protocolVersion >= PMTU_PROTOCOL_VER && _probeSize == 0 && !_mtuProber.isDone() &&
+            _probeTime == time_point<steady_clock>::max()) {
+            _probeTime = _lastSeen;
+        }
     }
 
     bool hasAck = (header.flags & static_cast<uint8_t>(packet::Flag::kHasAck)) != 0;
@@ -55,35 +90,137 @@ std::vector<Packet> Session::handleIncoming(std::shared_ptr<ByteBuffer> rawData)
     if (hasAck && !_sentPackets.empty()) {
         LOG_DEBUG("Checking sent packets buffer...");
 
-        auto it = _sentPackets.find(header.acknowledgeId);
+        const SentPacketInfo* info = _sentPackets.find(header.acknowledgeId);
 
-        if (it != _sentPackets.end()) {
-            if (it->second.retries == 0) {
+        if (info) {
+            if (info->retries == 0) {
                 auto now = steady_clock::now();
-                auto rtt = duration_cast<milliseconds>(now - it->second.sentTime);
+                auto rtt = duration_cast<microseconds>(now - info->sentTime);
 
                 _updateRtt(rtt);
             }
-            _sentPackets.erase(it);
+            _internal_onAcknowledged(*info);
+            _sentPackets.erase(header.acknowledgeId);
         }
 
-        for (int i = 0; i < 32; ++i) {
-            if (header.acknowledgeBitfield & (1 << i)) {
-                LOG_DEBUG(
-                    "Packet (seqID: {}) acknowledged, removing...", header.acknowledgeId - (i + 1));
-                _sentPackets.erase(header.acknowledgeId - (i + 1));
-            }
+        const size_t acknowledged = _sentPackets.erase(
+            header.acknowledgeId, header.acknowledgeBitfield, [this](const SentPacketInfo& acked) {
+                _internal_onAcknowledged(acked);
+            });
+
+        LOG_DEBUG("{} packets acknowledged by bitfield, removed.", acknowledged);
+    }
+
+    if (hasAck) {
+        _internal_detectLosses();
+        _internal_updateCongestionMetrics();
+    }
+
+    if (header.messageId != static_cast<packet::Id>(packet::SystemMessageId::kBundle)) {
+        auto& channelMetrics = _sessionMetrics.channels[header.channelId];
+        channelMetrics.packetsReceived.fetch_add(1, std::memory_order_relaxed);
+        channelMetrics.bytesReceived.fetch_add(rawData.size(), std::memory_order_relaxed);
+
+        _internal_handleMessage(
+            header, rawData.slice(sizeof(packet::Header), header.packetSize), readyPackets);
+        _internal_scheduleWakeUp();
+        return readyPackets;
+    }
+
+    LOG_TRACE_R3("Received BUNDLE packet ({} bytes of messages)", header.packetSize);
+
+    size_t offset = sizeof(packet::Header);
+    const size_t end = offset + header.packetSize;
+
+    while (offset < end) {
+        if (end - offset < sizeof(packet::BundleEntry)) {
+            LOG_ERR("Error while handling bundle: Truncated message sub-header.");
+            break;
+        }
+
+        packet::BundleEntry entry;
+        std::memcpy(&entry, rawData.data() + offset, sizeof(packet::BundleEntry));
+        entry.convertEndianness();
+        offset += sizeof(packet::BundleEntry);
+
+        if (end - offset < entry.packetSize) {
+            LOG_ERR("Error while handling bundle: Message #{} payload size does not match.",
+                    entry.sequenceId);
+            break;
+        }
+
+        packet::Header messageHeader = header;
+        messageHeader.sequenceId = entry.sequenceId;
+        messageHeader.channelId = entry.channelId;
+        messageHeader.orderId = entry.orderId;
+        messageHeader.messageId = entry.messageId;
+        messageHeader.flags = entry.flags;
+        messageHeader.packetSize = entry.packetSize;
+
+        {
+            auto& channelMetrics = _sessionMetrics.channels[entry.channelId];
+            channelMetrics.packetsReceived.fetch_add(1, std::memory_order_relaxed);
+            channelMetrics.bytesReceived.fetch_add(
+                sizeof(packet::BundleEntry) + entry.packetSize, std::memory_order_relaxed);
         }
+
+        _internal_handleMessage(
+            messageHeader, rawData.slice(offset, entry.packetSize), readyPackets);
+        offset += entry.packetSize;
     }
 
-    bool isDuplicate = this->isDuplicate(header.sequenceId);
+    _internal_scheduleWakeUp();
+    return readyPackets;
+}
+
+void Session::_internal_handleMessage(const packet::Header& header,
+                                      const PooledBuffer& payload,
+                                      std::vector<Packet>& readyPackets)
+{
+    bool isDuplicate = this->isDuplicate(header);
 
     if (isDuplicate) {
         LOG_WARN("Dropped duplicate packet #{}", header.sequenceId);
         ++_sessionMetrics.duplicateCount;
-        _pendingRichAcks.push_back(header.sequenceId);
+        _receiveHistory.markPendingAck(header.sequenceId);
         _hasUnsentAck = true;
-        return readyPackets;
+        return;
+    }
+
+    const bool isOrdered = (static_cast<packet::Flag>(header.flags) & packet::Flag::kOrdered) ==
+                           packet::Flag::kOrdered;
+
+    // Left unacknowledged, like a refused fragment: resent once the reorder buffer has room.
+    if (isOrdered && _channels[header.channelId].reorderBuffer.isTooFar(header.orderId)) {
+        LOG_WARN("Channel {}: Refused ordered packet #{}: Too far ahead (Got {}, Expected {}).",
+                 header.channelId,
+                 header.sequenceId,
+                 header.orderId,
+                 _channels[header.channelId].reorderBuffer.getNextExpected());
+        ++_sessionMetrics.refusedCount;
+        return;
+    }
+
+    const bool isFragment =
+        header.messageId == static_cast<packet::Id>(packet::SystemMessageId::kFragment);
+    auto fragmentResult = FragmentReassembler::Result::kIncomplete;
+    FragmentReassembler::Message message;
+
+    // Stored before being acknowledged: a fragment without room must be resent later.
+    if (isFragment) {
+        fragmentResult =
+            _reassembler.receive(header.sequenceId,
+                                 payload.view(),
+                                 packet::isReliable(static_cast<packet::Flag>(header.flags)),
+                                 message);
+
+        if (fragmentResult == FragmentReassembler::Result::kRefused) {
+            LOG_WARN("Refused fragment #{}: Reassembly buffer full ({} bytes reserved).",
+                     header.sequenceId,
+                     _reassembler.getReservedBytes());
+            ++_sessionMetrics.refusedCount;
+            return;
+        }
     }
 
     updateAcknowledgeInfo(header.sequenceId);
@@ -93,120 +230,459 @@ std::vector<Packet> Session::handleIncoming(std::shared_ptr<ByteBuffer> rawData)
     // if we received enough packets to fill half our window, directly send ACK
     if (_packetsSinceLastAck >= packet::ACK_PACKET_THRESHOLD) {
         _internal_sendAck();
+        _internal_flush();
     }
 
     if (header.messageId == static_cast<packet::Id>(packet::SystemMessageId::kRichAck)) {
         LOG_TRACE_R3("Received RICH_ACK packet");
 
-        checkForOldPackets(rawData, header);
-        return readyPackets;
+        checkForOldPackets(payload, header);
+        return;
+    }
+
+    if (header.messageId == static_cast<packet::Id>(packet::SystemMessageId::kProbe)) {
+        const auto now = steady_clock::now();
+        const packet::internal::ProbeAck probeAck{
+            .size = static_cast<uint16_t>(sizeof(packet::Header) + payload.size())};
+        Packet answer(packet::internal::ProbeAck::kId,
+                      packet::internal::ProbeAck::kFlag,
+                      packet::internal::ProbeAck::kChannel);
+
+        LOG_TRACE_R2("Received a path MTU probe of {} bytes.", probeAck.size);
+        answer.setPriority(packet::Priority::kHigh);
+        answer << probeAck;
+        _internal_queue(answer, 0, now);
+        _internal_requestWakeUp(now);
+        return;
     }
 
-    size_t payloadSize = rawData->size() - sizeof(packet::Header);
+    if (header.messageId == static_cast<packet::Id>(packet::SystemMessageId::kProbeAck)) {
+        Packet answer(header.messageId, static_cast<packet::Flag>(header.flags));
+        packet::internal::ProbeAck probeAck;
+
+        answer._internal_setPayload(payload, 0);
+        try {
+            answer >> probeAck;
+            _internal_onProbeAcknowledged(probeAck.size);
+        } catch (const std::exception& e) {
+            LOG_ERR("Failed to deserialize PROBE_ACK packet: {}", e.what());
+        }
+        return;
+    }
 
-    if (payloadSize == 0 &&
+    if (payload.size() == 0 &&
         header.messageId == static_cast<packet::Id>(packet::SystemMessageId::kAck)) {
         LOG_TRACE_R3("Received ACK packet, stopping.");
-        return readyPackets;
+        return;
+    }
+
+    if (isFragment) {
+        if (fragmentResult == FragmentReassembler::Result::kInvalid) {
+            LOG_ERR("Dropped invalid fragment #{}.", header.sequenceId);
+            return;
+        }
+        if (fragmentResult != FragmentReassembler::Result::kComplete) {
+            return;
+        }
+
+        LOG_TRACE_R2("Reassembled packet #{} ({} bytes, first fragment #{}).",
+                     message.messageId,
+                     message.payload.size(),
+                     message.firstSequenceId);
+
+        packet::Header messageHeader = header;
+        messageHeader.sequenceId = message.firstSequenceId;
+        messageHeader.messageId = message.messageId;
+
+        Packet incomingPacket(message.messageId, static_cast<packet::Flag>(header.flags));
+        incomingPacket._buffer = std::move(message.payload);
+
+        _internal_deliver(messageHeader, std::move(incomingPacket), readyPackets);
+        return;
     }
 
     Packet incomingPacket(header.messageId, static_cast<packet::Flag>(header.flags));
-    ByteBuffer payload;
-    payload.assign(rawData->begin() + sizeof(packet::Header), rawData->end());
-    incomingPacket._internal_setPayload(std::move(payload));
+    incomingPacket._internal_setPayload(payload, 0);
+
+    _internal_deliver(header, std::move(incomingPacket), readyPackets);
+}
 
+void Session::_internal_deliver(const packet::Header& header,
+                                Packet&& incomingPacket,
+                                std::vector<Packet>& readyPackets)
+{
     bool isOrdered =
         (incomingPacket.getReliability() & packet::Flag::kOrdered) == packet::Flag::kOrdered;
+    bool isSequenced =
+        (incomingPacket.getReliability() & packet::Flag::kSequenced) == packet::Flag::kSequenced;
 
     LOG_DEBUG("Is packet ordered? {}.", isOrdered ? "Yes" : "No");
 
+    // The Order ID of a sequenced packet is its key.
+    if (!isOrdered && isSequenced &&
+        !_channels[header.channelId].sequenceFilter.accept(header.orderId, header.sequenceId)) {
+        LOG_TRACE_R2("Channel {}: Dropped stale sequenced packet #{} (key {}).",
+                     header.channelId,
+                     header.sequenceId,
+                     header.orderId);
+        ++_sessionMetrics.staleCount;
+        return;
+    }
+
     if (!isOrdered) {
         readyPackets.push_back(std::move(incomingPacket));
-        return readyPackets;
+        return;
     }
 
-    packet::ChannelId receivedChannelId = header.channelId;
-    packet::OrderId receivedOrderId = header.orderId;
+    const packet::ChannelId receivedChannelId = header.channelId;
+    const packet::OrderId receivedOrderId = header.orderId;
+    ReorderBuffer& reorderBuffer = _channels[receivedChannelId].reorderBuffer;
 
     LOG_DEBUG("Received channel ID: {}", receivedChannelId);
-
-    packet::OrderId& nextExpected = _nextExpectedOrderIds[receivedChannelId];
-    auto& reorderBuffer = _reorderBuffers[receivedChannelId];
-
     LOG_DEBUG("Received ordered ID: {}", receivedOrderId);
 
-    if (receivedOrderId == nextExpected) {
-        readyPackets.push_back(std::move(incomingPacket));
-        nextExpected++;
-
-        while (reorderBuffer.contains(nextExpected)) {
-            auto node = reorderBuffer.extract(nextExpected);
-            readyPackets.push_back(std::move(node.mapped()));
-            nextExpected++;
-        }
-    } else if (receivedOrderId > nextExpected) {
-        LOG_TRACE_R2(
-            "Gap: Got order ID {}, expected {}. Buffering.", receivedOrderId, nextExpected);
-        reorderBuffer[receivedOrderId] = std::move(incomingPacket);
-    } else {
-        LOG_WARN("Channel {}: Duplicate/Old Ordered Packet (Got {}, Expected {}). Ignoring.",
-                 receivedChannelId,
-                 receivedOrderId,
-                 nextExpected);
+    switch (reorderBuffer.receive(receivedOrderId, std::move(incomingPacket), readyPackets)) {
+        case ReorderBuffer::Result::kDelivered:
+            break;
+        case ReorderBuffer::Result::kBuffered:
+            LOG_TRACE_R2("Gap: Got order ID {}, expected {}. Buffering.",
+                         receivedOrderId,
+                         reorderBuffer.getNextExpected());
+            break;
+        case ReorderBuffer::Result::kDuplicate:
+            LOG_WARN("Channel {}: Duplicate/Old Ordered Packet (Got {}, Expected {}). Ignoring.",
+                     receivedChannelId,
+                     receivedOrderId,
+                     reorderBuffer.getNextExpected());
+            break;
+        case ReorderBuffer::Result::kTooFar:
+            // Refused before being acknowledged (cf. _internal_handleMessage).
+            break;
     }
-
-    return readyPackets;
 }
 
 void Session::send(Packet& packet)
 {
     std::lock_guard lock(_mutex);
 
-    packet::SequenceId sequenceId = _localSequenceId++;
+    const size_t payloadSize = packet.getPayload().size();
+    const bool isFragmented = _protocolVersion >= FRAGMENT_PROTOCOL_VER &&
+                              sizeof(packet::Header) + payloadSize > _maxDatagramSize;
+    // Peers that do not probe the path expect fragments of a fixed size.
+    const size_t fragmentSize =
+        _protocolVersion >= PMTU_PROTOCOL_VER
+            ? _maxDatagramSize - sizeof(packet::Header) - sizeof(packet::FragmentHeader)
+            : packet::FRAGMENT_SIZE;
+    const size_t fragmentCount = (payloadSize + fragmentSize - 1) / fragmentSize;
+
+    // Checked before any ID is assigned, so that a dropped message leaves no gap in the channel.
+    if (isFragmented && fragmentCount > packet::MAX_FRAGMENT_COUNT) {
+        LOG_ERR("Dropped packet #{}: {} bytes need {} fragments (maximum is {}).",
+                packet.getId(),
+                payloadSize,
+                fragmentCount,
+                packet::MAX_FRAGMENT_COUNT);
+        return;
+    }
+    if (!isFragmented && payloadSize > UINT16_MAX) {
+        LOG_ERR("Dropped packet #{}: {} bytes do not fit in a datagram, and the remote peer "
+                "(version {:#06x}) does not support fragments.",
+                packet.getId(),
+                payloadSize,
+                _protocolVersion);
+        return;
+    }
+
     packet::OrderId orderId = 0;
 
     if ((packet.getReliability() & packet::Flag::kOrdered) == packet::Flag::kOrdered) {
-        packet::ChannelId channel = packet.getChannel();
-        orderId = _localOrderIds[channel]++;
+        orderId = _channels[packet.getChannel()].nextLocalOrderId++;
+    } else if ((packet.getReliability() & packet::Flag::kSequenced) == packet::Flag::kSequenced) {
+        orderId = packet.getSequenceKey();
+    }
+
+    const auto now = steady_clock::now();
+
+    if (!isFragmented) {
+        _internal_queue(packet, orderId, now);
+        _internal_requestWakeUp(now);
+        return;
+    }
+
+    LOG_TRACE_R2("Splitting packet #{} ({} bytes) into {} fragments.",
+                 packet.getId(),
+                 payloadSize,
+                 fragmentCount);
+
+    const auto payload = packet.getPayload();
+
+    // Every fragment takes the next Sequence ID, the receiver finds the first one from its index.
+    for (size_t index = 0; index < fragmentCount; index++) {
+        const auto chunk = payload.subspan(
+            index * fragmentSize, std::min(fragmentSize, payloadSize - index * fragmentSize));
+        packet::FragmentHeader fragmentHeader;
+
+        fragmentHeader.index = static_cast<uint16_t>(index);
+        fragmentHeader.count = static_cast<uint16_t>(fragmentCount);
+        fragmentHeader.messageId = packet.getId();
+        fragmentHeader.convertEndianness();
+
+        Packet fragment(static_cast<packet::Id>(packet::SystemMessageId::kFragment),
+                        packet.getReliability(),
+                        packet.getChannel());
+
+        fragment.setPriority(packet.getPriority());
+        fragment.setLifetime(packet.getLifetime());
+        fragment._buffer.reserve(sizeof(packet::FragmentHeader) + chunk.size());
+        fragment.append(&fragmentHeader, sizeof(packet::FragmentHeader));
+        fragment.append(chunk.data(), chunk.size());
+
+        _internal_queue(fragment, orderId, now);
+    }
+    _internal_requestWakeUp(now);
+}
+
+void Session::_internal_queue(const Packet& packet,
+                              const packet::OrderId orderId,
+                              const time_point<steady_clock> now)
+{
+    const packet::SequenceId sequenceId = _localSequenceId++;
+
+    if (packet::isReliable(packet.getReliability())) {
+        // Shared, so that neither this copy nor the ones queued on retransmission copy it again.
+        Packet stored = packet;
+
+        stored.share();
+        _sentPackets.insert({stored, now, sequenceId, orderId});
+        _resendTimers.schedule(now + _rttEstimator.getRetransmitTimeout(), sequenceId);
+        _outgoingMessages.push_back({std::move(stored), sequenceId, orderId});
+        return;
+    }
+
+    auto deadline = time_point<steady_clock>::max();
+
+    if (packet.getLifetime() > milliseconds::zero()) {  // Only unreliable messages expire.
+        deadline = now + packet.getLifetime();
+    }
+
+    _outgoingMessages.push_back({packet, sequenceId, orderId, deadline});
+}
+
+void Session::flush()
+{
+    std::lock_guard lock(_mutex);
+    _internal_flush();
+}
+
+void Session::_internal_flush()
+{
+    const auto now = steady_clock::now();
+    const bool canBundle = _protocolVersion >= BUNDLE_PROTOCOL_VER;
+    size_t first = 0;
+
+    _pacer.setRate(_congestionController.getPacingRate(_rttEstimator.hasSample()
+                                                           ? _rttEstimator.getSmoothedRtt()
+                                                           : microseconds::zero()),
+                   now);
+    _blockedReliableBytes = 0;
+    _internal_prepareOutgoingMessages(now);
+
+    size_t end = _outgoingMessages.size();  // Past the messages that may still be sent.
+    bool isPaced = false;
+
+    while (first < end) {
+        size_t last = first;
+        size_t datagramSize = sizeof(packet::Header);
+        size_t reliableSize = 0;
+
+        // Takes messages until the next one would not fit (a datagram holds at least one).
+        // Peers older than bundles get every message in its own packet.
+        while (last < end) {
+            const Packet& message = _outgoingMessages[last].packet;
+            const size_t entrySize = getMessageSize(message);
+
+            if (last > first &&
+                (!canBundle || datagramSize + entrySize > _maxDatagramSize)) {
+                break;
+            }
+            datagramSize += entrySize;
+            if (packet::isReliable(message.getReliability())) {
+                reliableSize += entrySize;
+            }
+            last++;
+        }
+
+        if (reliableSize > 0 && !_congestionController.canSend(reliableSize)) {
+            _blockedReliableBytes = reliableSize;
+
+            // Unreliable messages do not count in the window: they go past the reliable ones.
+            const auto reliable = std::stable_partition(
+                _outgoingMessages.begin() + static_cast<ptrdiff_t>(first),
+                _outgoingMessages.end(),
+                [](const QueuedMessage& message) {
+                    return !packet::isReliable(message.packet.getReliability());
+                });
+
+            end = static_cast<size_t>(reliable - _outgoingMessages.begin());
+            continue;
+        }
+        if (!_pacer.canSend(now)) {
+            isPaced = true;
+            break;
+        }
+
+        if (last - first > 1) {
+            bundleSend(std::span(_outgoingMessages).subspan(first, last - first));
+        } else {
+            QueuedMessage& message = _outgoingMessages[first];
+            SentPacketInfo* info = packet::isReliable(message.packet.getReliability())
+                                       ? _sentPackets.find(message.sequenceId)
+                                       : nullptr;
+
+            rawSend(message.packet, message.sequenceId, message.orderId, info);
+        }
+        _pacer.consume(datagramSize, now);
+
+        for (size_t i = first; i < last; i++) {
+            _internal_onTransmitted(_outgoingMessages[i], now);
+        }
+        first = last;
+    }
+
+    _outgoingMessages.erase(_outgoingMessages.begin(), _outgoingMessages.begin() + first);
+
+    if (!_outgoingMessages.empty()) {
+        LOG_TRACE_R2("{} messages held back ({} bytes in flight, window of {} bytes).",
+                     _outgoingMessages.size(),
+                     _congestionController.getBytesInFlight(),
+                     _congestionController.getCongestionWindow());
+
+        if (isPaced) {  // Sent once the bucket refills.
+            _internal_requestWakeUp(_pacer.getNextSendTime(now));
+        }
+        if (_blockedReliableBytes > 0 && _hasUnsentAck) {
+            // The ACK must not wait for the window: the remote peer may be waiting for it too.
+            Packet ack(static_cast<packet::Id>(packet::SystemMessageId::kAck),
+                       packet::Flag::kUnreliable,
+                       packet::INTERNAL_CHANNEL_ID);
+
+            rawSend(ack, _localSequenceId++, 0);
+        }
+    }
+    _internal_updateCongestionMetrics();
+}
+
+void Session::_internal_prepareOutgoingMessages(const time_point<steady_clock> now)
+{
+    const auto expired = std::ranges::remove_if(
+        _outgoingMessages, [now](const QueuedMessage& message) { return message.deadline < now; });
+
+    if (!expired.empty()) {
+        LOG_TRACE_R2("Dropped {} expired messages.", expired.size());
+        _sessionMetrics.expiredCount.fetch_add(expired.size(), std::memory_order_relaxed);
+        _outgoingMessages.erase(expired.begin(), expired.end());
+    }
+
+    // Stable, so that messages of the same priority keep their order.
+    const auto byPriority = [](const QueuedMessage& message) {
+        return message.packet.getPriority();
+    };
+
+    if (!std::ranges::is_sorted(_outgoingMessages, std::ranges::greater{}, byPriority)) {
+        std::ranges::stable_sort(_outgoingMessages, std::ranges::greater{}, byPriority);
+    }
+}
+
+size_t Session::getMessageSize(const Packet& message)
+{
+    return sizeof(packet::BundleEntry) + message.getPayload().size();
+}
+
+void Session::_internal_onTransmitted(const QueuedMessage& message,
+                                      const time_point<steady_clock> now)
+{
+    if (!packet::isReliable(message.packet.getReliability())) {
+        return;
+    }
+
+    SentPacketInfo* info = _sentPackets.find(message.sequenceId);
+
+    if (!info || info->isInFlight) {  // Acknowledged in the meantime.
+        return;
     }
 
-    if (packet.getReliability() != packet::Flag::kUnreliable) {
-        _sentPackets[sequenceId] = SentPacketInfo{packet, steady_clock::now(), sequenceId, orderId};
+    info->sentTime = now;
+    info->isInFlight = true;
+    info->transmissionId = ++_transmissionCount;
+    _uncheckedTransmissions.push_back(info->sequenceId);
+    _congestionController.onSent(getMessageSize(info->packet));
+}
+
+void Session::_internal_onAcknowledged(const SentPacketInfo& info)
+{
+    _largestAckedTransmissionId = std::max(_largestAckedTransmissionId, info.transmissionId);
+
+    if (info.isInFlight) {
+        _congestionController.onAcknowledged(getMessageSize(info.packet), info.sentTime);
     }
+}
+
+void Session::_internal_onLost(SentPacketInfo& info,
+                               const time_point<steady_clock> now)
+{
+    _congestionController.onLost(getMessageSize(info.packet), info.sentTime, now);
+    info.isInFlight = false;
+}
 
-    rawSend(packet, sequenceId, orderId);
+void Session::_internal_updateCongestionMetrics()
+{
+    _sessionMetrics.congestionWindow.store(_congestionController.getCongestionWindow(),
+                                           std::memory_order_relaxed);
+    _sessionMetrics.bytesInFlight.store(_congestionController.getBytesInFlight(),
+                                        std::memory_order_relaxed);
+    _sessionMetrics.pacingRate.store(_pacer.getRate(), std::memory_order_relaxed);
 }
 
 void Session::rawSend(Packet& packet,
                       packet::SequenceId sequenceId,
-                      packet::OrderId orderId)
+                      packet::OrderId orderId,
+                      SentPacketInfo* info)
 {
+    if (info && info->datagram) {
+        _internal_retransmit(packet, *info);
+        return;
+    }
+
     packet::Header header{};
 
     header.sequenceId = sequenceId;
     header.channelId = packet.getChannel();
     header.orderId = orderId;
-    header.acknowledgeId = _remoteAcknowledgeId;
-    header.acknowledgeBitfield = _remoteAcknowledgeBitfield;
+    header.acknowledgeId = _receiveHistory.getHead();
+    header.acknowledgeBitfield = _receiveHistory.getBitfield();
     header.messageId = packet.getId();
     header.flags = static_cast<uint8_t>(packet.getReliability());
     header.packetSize = static_cast<uint16_t>(packet.getPayload().size());
     // header.checksum = 0;  // todo: Implement CRC32 checksum
 
-    if (_hasReceivedRemotePacket) {
+    if (!_receiveHistory.isEmpty()) {
         header.flags |= static_cast<uint8_t>(packet::Flag::kHasAck);
         _packetsSinceLastAck = 0;
     }
 
     const auto rawBuffer = std::make_shared<ByteBuffer>();
     const auto& payload = packet.getPayload();
+    // A shared payload is handed as is, behind the header.
+    const bool isGathered = packet._shared && _gatherSendFunction;
 
-    rawBuffer->reserve(sizeof(packet::Header) + payload.size());
+    rawBuffer->reserve(sizeof(packet::Header) + (isGathered ? 0 : payload.size()));
 
     header.convertEndianness();
     const auto* headerPtr = reinterpret_cast<const uint8_t*>(&header);
     rawBuffer->insert(rawBuffer->end(), headerPtr, headerPtr + sizeof(packet::Header));
-    rawBuffer->insert(rawBuffer->end(), payload.begin(), payload.end());
+    if (!isGathered) {
+        rawBuffer->insert(rawBuffer->end(), payload.begin(), payload.end());
+    }
 
     header.convertEndianness();
     LOG_TRACE_R3(
@@ -230,14 +706,12 @@ void Session::rawSend(Packet& packet,
         header.packetSize,
         // header.checksum,
         byteBufferToHexString(rawBuffer->begin(), rawBuffer->begin() + sizeof(packet::Header)),
-        byteBufferToHexString(rawBuffer->begin() + sizeof(packet::Header), rawBuffer->end()));
+        byteBufferToHexString(payload));
 
-    if (_sendToPeerFunction) {
-        _sendToPeerFunction(rawBuffer);
+    if (info) {
+        info->datagram = rawBuffer;
     }
-
-    _hasUnsentAck = false;
-    _lastAckTime = steady_clock::now();
+    transmit(rawBuffer, isGathered ? packet._shared : nullptr);
 
     {
         auto& channelMetrics = _sessionMetrics.channels[packet.getChannel()];
@@ -247,43 +721,269 @@ void Session::rawSend(Packet& packet,
     }
 }
 
+void Session::_internal_retransmit(const Packet& packet,
+                                   SentPacketInfo& info)
+{
+    const auto payload = packet.getPayload();
+    // A header alone means that the payload was gathered behind it.
+    const bool isGathered = info.datagram->size() < sizeof(packet::Header) + payload.size();
+    const bool hasAck = !_receiveHistory.isEmpty();
+
+    if (info.datagram.use_count() > 1) {  // Still held by the Peer, which may be sending it.
+        info.datagram = std::make_shared<ByteBuffer>(*info.datagram);
+    }
+    patchAcknowledgeInfo(
+        *info.datagram, _receiveHistory.getHead(), _receiveHistory.getBitfield(), hasAck);
+    if (hasAck) {
+        _packetsSinceLastAck = 0;
+    }
+
+    LOG_TRACE_R3("Resending the datagram of packet #{} (sequence ID = {}).",
+                 packet.getId(),
+                 info.sequenceId);
+
+    transmit(info.datagram, isGathered ? packet._shared : nullptr);
+
+    auto& channelMetrics = _sessionMetrics.channels[packet.getChannel()];
+    channelMetrics.packetsSent.fetch_add(1, std::memory_order_relaxed);
+    channelMetrics.bytesSent.fetch_add(payload.size() + sizeof(packet::Header),
+                                       std::memory_order_relaxed);
+}
+
+void Session::bundleSend(const std::span<const QueuedMessage> messages)
+{
+    packet::Header header{};
+
+    header.channelId = packet::INTERNAL_CHANNEL_ID;
+    header.acknowledgeId = _receiveHistory.getHead();
+    header.acknowledgeBitfield = _receiveHistory.getBitfield();
+    header.messageId = static_cast<packet::Id>(packet::SystemMessageId::kBundle);
+
+    size_t messagesSize = 0;
+
+    for (const QueuedMessage& message : messages) {
+        messagesSize += sizeof(packet::BundleEntry) + message.packet.getPayload().size();
+    }
+    header.packetSize = static_cast<uint16_t>(messagesSize);
+
+    if (!_receiveHistory.isEmpty()) {
+        header.flags |= static_cast<uint8_t>(packet::Flag::kHasAck);
+        _packetsSinceLastAck = 0;
+    }
+
+    const auto rawBuffer = std::make_shared<ByteBuffer>();
+
+    rawBuffer->reserve(sizeof(packet::Header) + messagesSize);
+
+    header.convertEndianness();
+    const auto* headerPtr = reinterpret_cast<const uint8_t*>(&header);
+    rawBuffer->insert(rawBuffer->end(), headerPtr, headerPtr + sizeof(packet::Header));
+
+    for (const QueuedMessage& message : messages) {
+        const auto& payload = message.packet.getPayload();
+        packet::BundleEntry entry{};
+
+        entry.sequenceId = message.sequenceId;
+        entry.channelId = message.packet.getChannel();
+        entry.orderId = message.orderId;
+        entry.messageId = message.packet.getId();
+        entry.flags = static_cast<uint8_t>(message.packet.getReliability());
+        entry.packetSize = static_cast<uint16_t>(payload.size());
+        entry.convertEndianness();
+
+        const auto* entryPtr = reinterpret_cast<const uint8_t*>(&entry);
+        rawBuffer->insert(rawBuffer->end(), entryPtr, entryPtr + sizeof(packet::BundleEntry));
+        rawBuffer->insert(rawBuffer->end(), payload.begin(), payload.end());
+
+        auto& channelMetrics = _sessionMetrics.channels[message.packet.getChannel()];
+        channelMetrics.packetsSent.fetch_add(1, std::memory_order_relaxed);
+        channelMetrics.bytesSent.fetch_add(sizeof(packet::BundleEntry) + payload.size(),
+                                           std::memory_order_relaxed);
+    }
+
+    LOG_TRACE_R3("Preparing to send a bundle of {} messages ({} bytes).\n"
+                 "Acknowledge ID: {}\n"
+                 "Acknowledge bitfield: {}",
+                 messages.size(),
+                 rawBuffer->size(),
+                 header.acknowledgeId,
+                 bitfieldToString(header.acknowledgeBitfield));
+
+    transmit(rawBuffer);
+
+    // The datagram header is shared by all the messages.
+    _sessionMetrics.channels[packet::INTERNAL_CHANNEL_ID].bytesSent.fetch_add(
+        sizeof(packet::Header), std::memory_order_relaxed);
+}
+
+void Session::transmit(std::shared_ptr<ByteBuffer> datagram,
+                       std::shared_ptr<const ByteBuffer> payload)
+{
+    if (payload) {
+        _gatherSendFunction(std::move(datagram), std::move(payload));
+    } else if (_sendToPeerFunction) {
+        _sendToPeerFunction(std::move(datagram));
+    }
+
+    _hasUnsentAck = false;
+    _lastAckTime = steady_clock::now();
+    ++_sessionMetrics.datagramsSent;
+}
+
 void Session::update()
 {
     std::lock_guard lock(_mutex);
 
     LOG_DEBUG("Updating session {}", _id);
 
-    auto now = steady_clock::now();
+    const auto now = steady_clock::now();
+    bool isAlive = true;
 
-    for (auto it = _sentPackets.begin(); it != _sentPackets.end();) {
-        SentPacketInfo& info = it->second;
+    // This is the wake-up that was requested, the next one is requested below.
+    _wakeUpTime = time_point<steady_clock>::max();
 
-        LOG_DEBUG("Iterating over packet ordID = {}", info.orderId);
-        if (now - info.sentTime > packet::RESEND_TIMEOUT) {
-            if (info.retries >= packet::MAX_RESEND_ATTEMPTS) {
-                LOG_FATAL("Connection lost (Packet #{} retries exceeded).", info.packet._messageId);
-                _internal_disconnect();
-                return;
-            }
+    _resendTimers.advance(now, [&](const packet::SequenceId sequenceId) {
+        SentPacketInfo* info = _sentPackets.find(sequenceId);
+
+        if (!isAlive || !info) {  // Acknowledged since.
+            return;
+        }
 
-            LOG_TRACE_R2("Resending packet #{} ({}/{} retry, sequence ID = {} ; order ID = {})",
-                         info.packet._messageId,
-                         info.retries,
-                         packet::MAX_RESEND_ATTEMPTS,
-                         info.sequenceId,
-                         info.orderId);
-            rawSend(info.packet, info.sequenceId, info.orderId);
-
-            info.sentTime = now;
-            info.retries++;
-            ++_sessionMetrics.retransmitCount;
+        if (!info->isInFlight) {  // Still waiting in the send queue (paced or window full).
+            _resendTimers.schedule(now + _rttEstimator.getRetransmitTimeout(info->retries),
+                                   sequenceId);
+            return;
         }
-        ++it;
+
+        const auto timeout = _rttEstimator.getRetransmitTimeout(info->retries);
+
+        if (now - info->sentTime < timeout) {  // Fast retransmitted since.
+            _resendTimers.schedule(info->sentTime + timeout, sequenceId);
+            return;
+        }
+
+        if (info->retries >= packet::MAX_RESEND_ATTEMPTS) {
+            LOG_FATAL("Connection lost (Packet #{} retries exceeded).", info->packet._messageId);
+            _internal_disconnect();
+            isAlive = false;
+            return;
+        }
+
+        LOG_TRACE_R2("Resending packet #{} ({}/{} retry, sequence ID = {} ; order ID = {})",
+                     info->packet._messageId,
+                     info->retries,
+                     packet::MAX_RESEND_ATTEMPTS,
+                     info->sequenceId,
+                     info->orderId);
+        _internal_onLost(*info, now);
+        _outgoingMessages.push_back({info->packet, info->sequenceId, info->orderId});
+
+        info->retries++;
+        ++_sessionMetrics.retransmitCount;
+        _resendTimers.schedule(now + _rttEstimator.getRetransmitTimeout(info->retries),
+                               sequenceId);
+    });
+
+    if (!isAlive) {
+        return;
     }
 
     if (_hasUnsentAck && (now - _lastAckTime > packet::ACK_TIMEOUT)) {
         _internal_sendAck();
     }
+
+    _internal_probe(now);
+    _internal_scheduleWakeUp();
+}
+
+void Session::_internal_probe(const time_point<steady_clock> now)
+{
+    if (now < _probeTime) {
+        return;
+    }
+
+    if (_probeSize != 0) {
+        LOG_TRACE_R2("Path MTU probe of {} bytes unanswered.", _probeSize);
+        _mtuProber.onLost(_probeSize);
+    }
+
+    _probeSize = _mtuProber.getProbeSize();
+
+    if (_probeSize == 0) {
+        LOG_DEBUG("Path MTU probed: datagrams of up to {} bytes.", _maxDatagramSize);
+        _probeTime = time_point<steady_clock>::max();
+        return;
+    }
+
+    const packet::internal::Probe probe{.size = static_cast<uint16_t>(_probeSize)};
+    Packet packet(packet::internal::Probe::kId,
+                  packet::internal::Probe::kFlag,
+                  packet::internal::Probe::kChannel);
+
+    packet << probe;
+
+    // Padded up to the size probed.
+    const ByteBuffer padding(_probeSize - sizeof(packet::Header) - packet.getPayload().size(), 0);
+
+    packet.append(padding.data(), padding.size());
+    rawSend(packet, _localSequenceId++, 0);
+    _probeTime = now + _rttEstimator.getAnswerTimeout();
+}
+
+void Session::_internal_onProbeAcknowledged(const size_t probeSize)
+{
+    // An answer to an earlier probe, late but still telling.
+    _mtuProber.onAcknowledged(probeSize);
+    _maxDatagramSize = _mtuProber.getMaxDatagramSize();
+
+    if (probeSize != _probeSize) {
+        return;
+    }
+
+    LOG_TRACE_R2("Path MTU probe of {} bytes answered.", probeSize);
+    _probeSize = 0;
+    _probeTime = steady_clock::now();
+    _internal_requestWakeUp(_probeTime);
+}
+
+void Session::setWakeUpFunction(WakeUpFunction function)
+{
+    std::lock_guard lock(_mutex);
+    _wakeUpFunction = std::move(function);
+}
+
+void Session::setGatherSendFunction(GatherSendFunction function)
+{
+    std::lock_guard lock(_mutex);
+    _gatherSendFunction = std::move(function);
+}
+
+void Session::_internal_requestWakeUp(const time_point<steady_clock> time)
+{
+    if (time >= _wakeUpTime) {
+        return;
+    }
+
+    _wakeUpTime = time;
+    if (_wakeUpFunction) {
+        _wakeUpFunction(time);
+    }
+}
+
+void Session::_internal_scheduleWakeUp()
+{
+    if (const auto nextResend = _resendTimers.getNextExpiry()) {
+        _internal_requestWakeUp(*nextResend);
+    }
+    if (_hasUnsentAck) {
+        _internal_requestWakeUp(_lastAckTime + packet::ACK_TIMEOUT);
+    }
+    if (_probeTime != time_point<steady_clock>::max()) {
+        _internal_requestWakeUp(_probeTime);
+    }
+    if (!_outgoingMessages.empty() && _congestionController.canSend(_blockedReliableBytes)) {
+        _internal_requestWakeUp(_pacer.getNextSendTime(steady_clock::now()));
+    }
 }
 
 void Session::disconnect()
@@ -294,37 +994,54 @@ void Session::disconnect()
 
 void Session::_internal_sendAck()
 {
-    if (!_pendingRichAcks.empty()) {
-        size_t totalAcks = _pendingRichAcks.size();
-        size_t processed = 0;
-        size_t chunkN = 1;
+    if (_receiveHistory.hasPendingAcks() && _protocolVersion >= SACK_PROTOCOL_VER) {
+        std::deque<packet::SequenceId> pendingAcks;
 
-        LOG_TRACE_R2("Flushing {} pending ACKs in chunks", totalAcks);
+        _receiveHistory.takePendingAcks(pendingAcks, packet::MAX_PACKET_HISTORY_SIZE);
 
-        while (processed < totalAcks) {
-            LOG_TRACE_R2("Chunk {}, processed = {}", chunkN++, processed);
+        const std::vector<packet::internal::AckBlock> blocks =
+            packet::internal::RichAck::encode(pendingAcks);
 
-            size_t chunkSize = std::min(packet::MAX_ACK_PER_PACKET, totalAcks - processed);
+        LOG_TRACE_R2(
+            "Flushing {} pending ACKs as {} SACK blocks", pendingAcks.size(), blocks.size());
 
-            auto start = _pendingRichAcks.begin() + processed;
-            auto end = start + chunkSize;
+        const size_t maxBlockCount = packet::internal::RichAck::getMaxBlockCount(_maxDatagramSize);
 
-            std::deque<packet::SequenceId> acksToSerialize(start, end);
-            packet::internal::RichAck ack{.oobAcks = acksToSerialize};
+        for (size_t first = 0; first < blocks.size(); first += maxBlockCount) {
+            const size_t last = std::min(first + maxBlockCount, blocks.size());
+            const packet::internal::RichAck ack{.blocks = {blocks.begin() + first,
+                                                           blocks.begin() + last}};
 
-            Packet p(static_cast<packet::Id>(packet::SystemMessageId::kRichAck),
+            Packet p(packet::internal::RichAck::kId,
                      packet::internal::RichAck::kFlag,
                      packet::internal::RichAck::kChannel);
+            p.setPriority(packet::Priority::kHigh);
             p << ack;
 
             uint32_t sequenceId = _localSequenceId++;
-            rawSend(p, sequenceId, 0);
-
-            processed += chunkSize;
+            _outgoingMessages.push_back({std::move(p), sequenceId, 0});
         }
+    } else if (_receiveHistory.hasPendingAcks()) {
+        size_t chunkN = 1;
 
-        _pendingRichAcks.clear();
-    } else {
+        LOG_TRACE_R2("Flushing pending ACKs in chunks");
+
+        while (_receiveHistory.hasPendingAcks()) {
+            LOG_TRACE_R2("Chunk {}", chunkN++);
+
+            packet::internal::LegacyRichAck ack;
+            _receiveHistory.takePendingAcks(ack.oobAcks, packet::MAX_ACK_PER_PACKET);
+
+            Packet p(packet::internal::LegacyRichAck::kId,
+                     packet::internal::LegacyRichAck::kFlag,
+                     packet::internal::LegacyRichAck::kChannel);
+            p.setPriority(packet::Priority::kHigh);
+            p << ack;
+
+            uint32_t sequenceId = _localSequenceId++;
+            _outgoingMessages.push_back({std::move(p), sequenceId, 0});
+        }
+    } else if (_outgoingMessages.empty()) {
         LOG_TRACE_R2("Ahh it's empty, sending simple ACK...");
 
         Packet p(static_cast<packet::Id>(packet::SystemMessageId::kAck),
@@ -332,114 +1049,67 @@ void Session::_internal_sendAck()
                  packet::INTERNAL_CHANNEL_ID);
         uint32_t sequenceId = _localSequenceId++;
 
-        rawSend(p, sequenceId, 0);
+        p.setPriority(packet::Priority::kHigh);
+
+        _outgoingMessages.push_back({std::move(p), sequenceId, 0});
     }
 }
 
-void Session::_internal_disconnect() { this->_shouldClose = true; }
+void Session::_internal_disconnect()
+{
+    this->_shouldClose = true;
+    _internal_requestWakeUp(steady_clock::now());
+}
 
 void Session::updateAcknowledgeInfo(uint32_t sequenceId)
 {
     LOG_DEBUG("Updating acknowledge information");
 
-    if (!_hasReceivedRemotePacket) {
-        _remoteAcknowledgeId = sequenceId;
-        _hasReceivedRemotePacket = true;
-        _hasUnsentAck = true;
-        return;
-    }
-
-    if (sequenceId > _remoteAcknowledgeId) {
-        LOG_DEBUG("sequenceId > _remoteAcknowledgeId");
-        uint32_t shift = sequenceId - _remoteAcknowledgeId;
-
-        if (shift > 32) {
-            for (uint32_t i = 0; i < 32; ++i) {
-                if (_remoteAcknowledgeBitfield & (1U << i)) {
-                    _oldPacketHistory.push_back(_remoteAcknowledgeId - (i + 1));
-                }
-            }
-            _oldPacketHistory.push_back(_remoteAcknowledgeId);
-            _remoteAcknowledgeBitfield = 0;
-        } else {
-            for (uint32_t i = 32 - shift; i < 32; ++i) {
-                if (_remoteAcknowledgeBitfield & (1U << i)) {
-                    _oldPacketHistory.push_back(_remoteAcknowledgeId - (i + 1));
-                }
-            }
-
-            _remoteAcknowledgeBitfield <<= shift;
-            _remoteAcknowledgeBitfield |= 1 << (shift - 1);
-        }
-        _remoteAcknowledgeId = sequenceId;
-    } else if (sequenceId < _remoteAcknowledgeId) {
-        uint32_t diff = _remoteAcknowledgeId - sequenceId;
+    _receiveHistory.record(sequenceId);
 
-        if (diff <= 32) {
-            LOG_DEBUG("Diff is under 32, simple ACK");
-            _remoteAcknowledgeBitfield |= 1U << (diff - 1);
-        } else {
-            LOG_DEBUG("Diff is greater than 32 ({}), pushing to history.", diff);
-            auto it = std::ranges::find(_oldPacketHistory, sequenceId);
-
-            if (it == _oldPacketHistory.end()) {  // if not in the history, then add it
-                LOG_DEBUG("Not in the history, adding it to history.");
-                _oldPacketHistory.push_back(sequenceId);
-                if (_oldPacketHistory.size() > packet::MAX_PACKET_HISTORY_SIZE) {
-                    _oldPacketHistory.pop_front();
-                }
-            }
-        }
+    // Too late for the bitfield of the headers, it has to be acknowledged explicitly.
+    if (_receiveHistory.getHead() - sequenceId > 32) {
+        LOG_DEBUG("Received packet #{} outside of the ACK bitfield.", sequenceId);
+        _receiveHistory.markPendingAck(sequenceId);
     }
 
     _hasUnsentAck = true;
 }
 
-bool Session::isDuplicate(uint32_t sequenceId) const
+bool Session::isDuplicate(const packet::Header& header) const
 {
-    if (!_hasReceivedRemotePacket) {
-        return false;
+    if (_receiveHistory.isTooOld(header.sequenceId)) {
+        LOG_WARN("Packet #{} is too old for the reception history.", header.sequenceId);
+        return !packet::isReliable(static_cast<packet::Flag>(header.flags));
     }
-
-    if (sequenceId == _remoteAcknowledgeId) {
-        return true;
-    }
-
-    if (sequenceId > _remoteAcknowledgeId) {
-        return false;
-    }
-
-    uint32_t diff = _remoteAcknowledgeId - sequenceId;
-
-    if (diff <= 32) {
-        return (_remoteAcknowledgeBitfield & (1 << (diff - 1))) != 0;
-    }
-
-    const auto it = std::ranges::find(_oldPacketHistory, sequenceId);
-    return (it != _oldPacketHistory.end());
+    return _receiveHistory.contains(header.sequenceId);
 }
 
-void Session::checkForOldPackets(std::shared_ptr<ByteBuffer> rawData,
+void Session::checkForOldPackets(const PooledBuffer& payload,
                                  const packet::Header& header)
 {
     Packet incomingPacket(header.messageId, static_cast<packet::Flag>(header.flags));
 
-    if (rawData->size() > sizeof(packet::Header)) {
-        ByteBuffer payload;
+    if (payload.size() > 0) {
+        incomingPacket._internal_setPayload(payload, 0);
 
-        payload.assign(rawData->begin() + sizeof(packet::Header), rawData->end());
-        incomingPacket._internal_setPayload(std::move(payload));
+        const auto acknowledge = [this](const packet::SequenceId ackedSeqId) {
+            if (const SentPacketInfo* info = _sentPackets.find(ackedSeqId)) {
+                _internal_onAcknowledged(*info);
+                _sentPackets.erase(ackedSeqId);
+                LOG_TRACE_R2("Packet #{} acknowledged via RICH_ACK.", ackedSeqId);
+            }
+        };
 
         try {
-            packet::internal::RichAck richAck;
-            incomingPacket >> richAck;
-
-            if (!_sentPackets.empty()) {
-                for (uint32_t ackedSeqId : richAck.oobAcks) {
-                    if (_sentPackets.erase(ackedSeqId)) {
-                        LOG_TRACE_R2("Packet #{} acknowledged via RICH_ACK.", ackedSeqId);
-                    }
-                }
+            if (_protocolVersion >= SACK_PROTOCOL_VER) {
+                packet::internal::RichAck richAck;
+                incomingPacket >> richAck;
+                richAck.forEach(acknowledge);
+            } else {
+                packet::internal::LegacyRichAck richAck;
+                incomingPacket >> richAck;
+                std::ranges::for_each(richAck.oobAcks, acknowledge);
             }
         } catch (const std::exception& e) {
             LOG_ERR("Failed to deserialize RICH_ACK packet: {}", e.what());
@@ -447,9 +1117,54 @@ void Session::checkForOldPackets(std::shared_ptr<ByteBuffer> rawData,
     }
 }
 
-void Session::_updateRtt(const milliseconds rtt)
+void Session::_internal_detectLosses()
+{
+    const auto now = steady_clock::now();
+
+    while (!_uncheckedTransmissions.empty()) {
+        const uint64_t transmissionId = _transmissionCount - _uncheckedTransmissions.size() + 1;
+
+        if (transmissionId + packet::FAST_RETRANSMIT_THRESHOLD > _largestAckedTransmissionId) {
+            return;
+        }
+
+        SentPacketInfo* info = _sentPackets.find(_uncheckedTransmissions.front());
+
+        _uncheckedTransmissions.pop_front();
+        // Skips the packets acknowledged, or transmitted again, since.
+        if (!info || info->transmissionId != transmissionId || info->retries != 0 ||
+            !info->isInFlight) {
+            continue;
+        }
+
+        LOG_TRACE_R2("Fast retransmit of packet #{} (sequence ID = {}, transmission {}, "
+                     "acknowledged up to transmission {})",
+                     info->packet._messageId,
+                     info->sequenceId,
+                     transmissionId,
+                     _largestAckedTransmissionId);
+        _internal_onLost(*info, now);
+        _outgoingMessages.push_back({info->packet, info->sequenceId, info->orderId});
+
+        info->retries++;
+        ++_sessionMetrics.retransmitCount;
+        ++_sessionMetrics.fastRetransmitCount;
+        _internal_requestWakeUp(now);
+    }
+}
+
+void Session::_updateRtt(const microseconds rtt)
 {
-    const auto rttMs = static_cast<uint32_t>(rtt.count());
+    _rttEstimator.addSample(rtt);
+    _sessionMetrics.smoothedRtt.store(
+        static_cast<uint32_t>(_rttEstimator.getSmoothedRtt().count()), std::memory_order_relaxed);
+    _sessionMetrics.rttVariation.store(
+        static_cast<uint32_t>(_rttEstimator.getRttVariation().count()), std::memory_order_relaxed);
+    _sessionMetrics.retransmitTimeout.store(
+        static_cast<uint32_t>(_rttEstimator.getRetransmitTimeout().count()),
+        std::memory_order_relaxed);
+
+    const auto rttMs = static_cast<uint32_t>(duration_cast<milliseconds>(rtt).count());
     _sessionMetrics.rtt.store(rttMs, std::memory_order_relaxed);
 
     const uint32_t currentMax = _sessionMetrics.maxRtt.load(std::memory_order_relaxed);
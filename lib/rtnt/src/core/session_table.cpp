@@ -0,0 +1,208 @@
+#include "rtnt/core/session_table.hpp"
+
+#include <thread>
+
+#include "rtnt/common/constants.hpp"
+
+namespace rtnt::core {
+
+// Every access to the slots, the table pointer, the epoch and the reader counts is sequentially
+// consistent: a lookup registering after reclaim() saw no reader is then sure to see the removals
+// made before it, and the other way around.
+
+SessionTable::Entry SessionTable::_tombstone;
+
+SessionTable::Table::Table(const size_t capacity)
+    : mask(capacity - 1),
+      slots(std::make_unique<std::atomic<Entry*>[]>(capacity))
+{
+}
+
+SessionTable::ReadGuard::ReadGuard(const SessionTable& table)
+{
+    // Registering in an epoch that ended meanwhile could outlast a reclaim() not waiting for it.
+    for (;;) {
+        const uint64_t epoch = table._epoch.load();
+
+        _readers = &table._readers[epoch & 1];
+        _readers->fetch_add(1);
+        if (table._epoch.load() == epoch) {
+            return;
+        }
+        _readers->fetch_sub(1);
+    }
+}
+
+SessionTable::ReadGuard::~ReadGuard() { _readers->fetch_sub(1); }
+
+SessionTable::SessionTable()
+    : _table(new Table(SESSION_TABLE_INITIAL_CAPACITY))
+{
+}
+
+SessionTable::~SessionTable()
+{
+    const std::unique_ptr<Table> table(_table.load());
+
+    for (size_t i = 0; i <= table->mask; i++) {
+        const Entry* entry = table->slots[i].load();
+
+        if (entry != &_tombstone) {
+            delete entry;
+        }
+    }
+}
+
+std::shared_ptr<Session> SessionTable::find(const udp::endpoint& endpoint) const
+{
+    const ReadGuard guard(*this);
+    const Table* table = _table.load();
+
+    for (size_t i = getHomeSlot(*table, endpoint);; i = (i + 1) & table->mask) {
+        const Entry* entry = table->slots[i].load();
+
+        if (entry == nullptr) {
+            return nullptr;
+        }
+        if (entry != &_tombstone && entry->endpoint == endpoint) {
+            return entry->session;
+        }
+    }
+}
+
+std::shared_ptr<Session> SessionTable::insert(const udp::endpoint& endpoint,
+                                              std::shared_ptr<Session> session)
+{
+    std::lock_guard lock(_writeMutex);
+    const size_t size = _size.load();
+
+    // Tombstones count, as they do not end probes either.
+    if ((size + _tombstones + 1) * 2 > _table.load()->mask + 1) {
+        _internal_grow(size + 1);
+    }
+
+    Table* table = _table.load();
+    std::atomic<Entry*>* freeSlot = nullptr;
+
+    for (size_t i = getHomeSlot(*table, endpoint);; i = (i + 1) & table->mask) {
+        Entry* entry = table->slots[i].load();
+
+        if (entry == nullptr) {
+            freeSlot = freeSlot != nullptr ? freeSlot : &table->slots[i];
+            break;
+        }
+        if (entry == &_tombstone) {
+            freeSlot = freeSlot != nullptr ? freeSlot : &table->slots[i];
+        } else if (entry->endpoint == endpoint) {
+            return entry->session;
+        }
+    }
+
+    if (freeSlot->load() == &_tombstone) {
+        _tombstones--;
+    }
+    freeSlot->store(new Entry{endpoint, session});
+    _size.store(size + 1);
+    return session;
+}
+
+bool SessionTable::erase(const udp::endpoint& endpoint,
+                         const std::shared_ptr<Session>& session)
+{
+    std::lock_guard lock(_writeMutex);
+    Table* table = _table.load();
+
+    for (size_t i = getHomeSlot(*table, endpoint);; i = (i + 1) & table->mask) {
+        Entry* entry = table->slots[i].load();
+
+        if (entry == nullptr) {
+            return false;
+        }
+        if (entry != &_tombstone && entry->endpoint == endpoint) {
+            if (entry->session != session) {
+                return false;
+            }
+            table->slots[i].store(&_tombstone);
+            _retiredEntries.emplace_back(entry);
+            _tombstones++;
+            _size.store(_size.load() - 1);
+            return true;
+        }
+    }
+}
+
+void SessionTable::reclaim()
+{
+    std::vector<std::unique_ptr<Entry>> entries;
+    std::vector<std::unique_ptr<Table>> tables;
+
+    {
+        std::lock_guard lock(_writeMutex);
+
+        entries.swap(_retiredEntries);
+        tables.swap(_retiredTables);
+    }
+
+    if (entries.empty() && tables.empty()) {
+        return;
+    }
+
+    // The lookups that may still read them registered in the epoch that ends here.
+    std::lock_guard lock(_reclaimMutex);
+    const uint64_t epoch = _epoch.fetch_add(1);
+
+    while (_readers[epoch & 1].load() != 0) {
+        std::this_thread::yield();
+    }
+}
+
+size_t SessionTable::getHomeSlot(const Table& table,
+                                 const udp::endpoint& endpoint)
+{
+    const asio::ip::address address = endpoint.address();
+    uint64_t key = endpoint.port();
+
+    if (address.is_v4()) {
+        key |= uint64_t{address.to_v4().to_uint()} << 16;
+    } else {
+        for (const uint8_t byte : address.to_v6().to_bytes()) {
+            key = (key ^ byte) * 0x100000001B3ULL;  // FNV-1a
+        }
+    }
+
+    // Fibonacci hashing spreads the (often close) addresses and ports over the whole table.
+    return static_cast<size_t>((key * 0x9E3779B97F4A7C15ULL) >> 32) & table.mask;
+}
+
+void SessionTable::_internal_grow(const size_t minSize)
+{
+    size_t capacity = SESSION_TABLE_INITIAL_CAPACITY;
+
+    // Room for as many sessions again before the next growth.
+    while (capacity < minSize * 4) {
+        capacity *= 2;
+    }
+
+    auto grown = std::make_unique<Table>(capacity);
+    Table* table = _table.load();
+
+    for (size_t i = 0; i <= table->mask; i++) {
+        Entry* entry = table->slots[i].load();
+
+        if (entry == nullptr || entry == &_tombstone) {
+            continue;
+        }
+        for (size_t j = getHomeSlot(*grown, entry->endpoint);; j = (j + 1) & grown->mask) {
+            if (grown->slots[j].load() == nullptr) {
+                grown->slots[j].store(entry);
+                break;
+            }
+        }
+    }
+
+    _retiredTables.emplace_back(table);
+    _table.store(grown.release());
+    _tombstones = 0;
+}
+
+}  // namespace rtnt::core
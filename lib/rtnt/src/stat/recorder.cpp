@@ -36,22 +36,35 @@ void Recorder::exportToCsv(const std::string& filename) const
     std::ofstream file(filename + ".csv");
 
     if (file.is_open()) {
-        file << "Timestamp,TotalBytesSent,TotalBytesReceived,AvgRTT,TotalRetries\n";
+        file << "Timestamp,TotalBytesSent,TotalBytesReceived,AvgRTT,TotalRetries,"
+                "DatagramsPerSendCall,AvgCongestionWindow,TotalPacingRate\n";
 
         for (const auto& entry : _history) {
             uint64_t totalRtt = 0;
             uint64_t totalRetries = 0;
+            uint64_t totalCongestionWindow = 0;
+            uint64_t totalPacingRate = 0;
 
             if (!entry.sessions.empty()) {
                 for (const auto& s : entry.sessions) {
                     totalRtt += s.rtt;
                     totalRetries += s.retransmitCount;
+                    totalCongestionWindow += s.congestionWindow;
+                    totalPacingRate += s.pacingRate;
                 }
                 totalRtt /= entry.sessions.size();
+                totalCongestionWindow /= entry.sessions.size();
             }
 
+            const double datagramsPerSendCall =
+                entry.totalSendCalls == 0 ? 0.0
+                                          : static_cast<double>(entry.totalPacketsSent) /
+                                                static_cast<double>(entry.totalSendCalls);
+
             file << entry.timestamp << "," << entry.totalBytesSent << ","
-                 << entry.totalBytesReceived << "," << totalRtt << "," << totalRetries << "\n";
+                 << entry.totalBytesReceived << "," << totalRtt << "," << totalRetries << ","
+                 << datagramsPerSendCall << "," << totalCongestionWindow << "," << totalPacingRate
+                 << "\n";
         }
 
         LOG_INFO("Global stats exported to {}", filename);
@@ -110,6 +123,8 @@ SystemSnapshot Recorder::_takeSnapshot()
     const auto& metrics = _peer.getNetworkMetrics();
     snapshot.totalBytesSent = metrics.totalBytesSent.load(std::memory_order_relaxed);
     snapshot.totalBytesReceived = metrics.totalBytesReceived.load(std::memory_order_relaxed);
+    snapshot.totalPacketsSent = metrics.totalPacketsSent.load(std::memory_order_relaxed);
+    snapshot.totalSendCalls = metrics.totalSendCalls.load(std::memory_order_relaxed);
 
     auto snapshotSession = [&](const std::shared_ptr<core::Session>& session) {
         if (!session) {
@@ -123,6 +138,8 @@ SystemSnapshot Recorder::_takeSnapshot()
         snap.rtt = sessionMetrics.rtt.load(std::memory_order_relaxed);
         snap.retransmitCount = sessionMetrics.retransmitCount.load(std::memory_order_relaxed);
         snap.duplicateCount = sessionMetrics.duplicateCount.load(std::memory_order_relaxed);
+        snap.congestionWindow = sessionMetrics.congestionWindow.load(std::memory_order_relaxed);
+        snap.pacingRate = sessionMetrics.pacingRate.load(std::memory_order_relaxed);
 
         for (size_t i = 0; i < sessionMetrics.channels.size(); ++i) {
             uint64_t ps = sessionMetrics.channels[i].packetsSent.load(std::memory_order_relaxed);
@@ -139,9 +156,8 @@ SystemSnapshot Recorder::_takeSnapshot()
     };
 
     if (_server) {  // if server, then snapshot all sessions
-        std::lock_guard lock(_server->_sessionsMutex);
-        for (const auto& [endpoint, session] : _server->_sessions) {
-            snapshotSession(session);
+        for (const auto& shard : _server->_shards) {
+            shard->sessions.forEach(snapshotSession);
         }
     } else if (_client) {  // and client only has one.
         std::lock_guard lock(_client->_mutex);
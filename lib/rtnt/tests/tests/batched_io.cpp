@@ -0,0 +1,212 @@
+#include <gtest/gtest.h>
+
+#include <asio/io_context.hpp>
+#include <string>
+#include <thread>
+
+#include "rtnt/core/client.hpp"
+#include "rtnt/core/server.hpp"
+
+#if defined(__linux__)
+
+namespace {
+
+struct Example
+{
+    static constexpr rtnt::core::packet::Id kId = 1001;
+    static constexpr rtnt::core::packet::Name kName = "EXAMPLE";
+    static constexpr rtnt::core::packet::Flag kFlag = rtnt::core::packet::Flag::kReliable;
+
+    uint32_t x;
+    std::string padding = std::string(rtnt::core::packet::MAX_PROBE_SIZE / 2, ' ');
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & x;
+        ar & padding;
+    }
+};
+
+struct UnreliableExample
+{
+    static constexpr rtnt::core::packet::Id kId = 1002;
+    static constexpr rtnt::core::packet::Name kName = "UNRELIABLE_EXAMPLE";
+    static constexpr rtnt::core::packet::Flag kFlag = rtnt::core::packet::Flag::kUnreliable;
+
+    uint32_t x;
+    std::string padding = std::string(rtnt::core::packet::MAX_PROBE_SIZE / 2, ' ');
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & x;
+        ar & padding;
+    }
+};
+
+}  // namespace
+
+/**
+ * @brief   Broadcasts a burst of reliable packets between two Peers using the same I/O backend.
+ *          The packets are too large to share a datagram, so that each one is a send of its own.
+ * @param   backend     I/O backend of both Peers
+ * @param   udpOffload  Whether to enable GSO/GRO. The test must pass whether or not the kernel
+ *                      supports it.
+ */
+static void broadcastBurst(const rtnt::core::Peer::IoBackend backend,
+                           const bool udpOffload)
+{
+    constexpr uint32_t packetCount = 64;
+
+    asio::io_context context;
+    auto workGuard = asio::make_work_guard(context);
+
+    rtnt::core::Server server(context, 4243);
+    rtnt::core::Client client(context);
+
+    server.setIoBackend(backend);
+    client.setIoBackend(backend);
+    server.setUdpOffload(udpOffload);
+    client.setUdpOffload(udpOffload);
+    server.start();
+
+    std::thread ioThread([&context]() { context.run(); });
+
+    uint32_t received = 0;
+    client.onMessage([&](const rtnt::core::Packet& p) {
+        if (p.getId() == Example::kId) {
+            received++;
+        }
+    });
+
+    const auto waitFor = [&](auto condition) {
+        const auto start = std::chrono::steady_clock::now();
+
+        while (std::chrono::steady_clock::now() - start < std::chrono::seconds(2)) {
+            server.update();
+            client.update();
+            if (condition()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+
+    client.connect("127.0.0.1", 4243);
+    ASSERT_TRUE(waitFor([&]() { return client.isConnected(); })) << "Client failed to connect.";
+
+    const uint64_t callsBefore = server.getNetworkMetrics().totalSendCalls.load();
+    const uint64_t packetsBefore = server.getNetworkMetrics().totalPacketsSent.load();
+
+    for (uint32_t i = 0; i < packetCount; i++) {
+        server.broadcast(Example{.x = i});
+    }
+    server.flush();
+
+    EXPECT_TRUE(waitFor([&]() { return received == packetCount; }))
+        << "Client received " << received << "/" << packetCount << " packets.";
+
+    // Read once received, as some backends only account for a send when it completes.
+    const uint64_t calls = server.getNetworkMetrics().totalSendCalls.load() - callsBefore;
+    const uint64_t packets = server.getNetworkMetrics().totalPacketsSent.load() - packetsBefore;
+
+    // The I/O thread may flush a few ACKs (and part of the burst) at the same time.
+    EXPECT_GE(packets, packetCount);
+    EXPECT_LT(calls, packets / 4) << "The burst should have been sent with a few syscalls.";
+
+    context.stop();
+    ioThread.join();
+}
+
+TEST(BatchedIo,
+     broadcast_burst)
+{
+    broadcastBurst(rtnt::core::Peer::IoBackend::kBatched, false);
+}
+
+TEST(BatchedIo,
+     broadcast_burst_udp_offload)
+{
+    broadcastBurst(rtnt::core::Peer::IoBackend::kBatched, true);
+}
+
+TEST(BatchedIo,
+     broadcast_burst_io_uring)
+{
+    // Falls back to the batched backend on kernels without io_uring.
+    broadcastBurst(rtnt::core::Peer::IoBackend::kIoUring, false);
+}
+
+TEST(BatchedIo,
+     held_packets_release_reception_buffers)
+{
+    constexpr uint32_t packetCount = 128;
+
+    asio::io_context context;
+    auto workGuard = asio::make_work_guard(context);
+
+    rtnt::core::Server server(context, 4243);
+    rtnt::core::Client client(context);
+
+    server.setIoBackend(rtnt::core::Peer::IoBackend::kBatched);
+    client.setIoBackend(rtnt::core::Peer::IoBackend::kBatched);
+    server.start();
+
+    std::thread ioThread([&context]() { context.run(); });
+
+    uint32_t received = 0;
+    client.onMessage([&](const rtnt::core::Packet& p) {
+        if (p.getId() == UnreliableExample::kId) {
+            received++;
+        }
+    });
+
+    client.connect("127.0.0.1", 4243);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    while (!client.isConnected() &&
+           std::chrono::steady_clock::now() - start < std::chrono::seconds(2)) {
+        server.update();
+        client.update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(client.isConnected()) << "Client failed to connect.";
+
+    // The client does not update: every packet sent waits in its event queue. They are sent a
+    // few at a time, not to overflow the socket receive buffer.
+    const uint64_t before = client.getNetworkMetrics().totalPacketsReceived.load();
+    const auto receivedDatagrams = [&]() {
+        return client.getNetworkMetrics().totalPacketsReceived.load() - before;
+    };
+
+    for (uint32_t i = 0; i < packetCount; i++) {
+        server.broadcast(UnreliableExample{.x = i});
+        if ((i + 1) % 16 != 0) {
+            continue;
+        }
+        server.flush();
+
+        const auto sent = std::chrono::steady_clock::now();
+
+        while (receivedDatagrams() < i + 1 &&
+               std::chrono::steady_clock::now() - sent < std::chrono::seconds(2)) {
+            server.update();
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        ASSERT_GE(receivedDatagrams(), i + 1) << "The client stopped receiving the burst.";
+    }
+
+    // They were copied out of the reception buffers, which are neither held nor exhausted.
+    EXPECT_EQ(client.getNetworkMetrics().receptionPoolMisses.load(), 0);
+
+    client.update();
+    EXPECT_EQ(received, packetCount);
+
+    context.stop();
+    ioThread.join();
+}
+
+#endif
@@ -1,9 +1,18 @@
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "network_fixture.hpp"
+#include "session_helpers.hpp"
 
 namespace {
 
+using rtnt::core::ByteBuffer;
+using rtnt::core::Packet;
+using rtnt::core::Session;
+namespace packet = rtnt::core::packet;
+
 struct Example
 {
     static constexpr rtnt::core::packet::Id kId = 1001;
@@ -18,6 +27,16 @@ struct Example
     }
 };
 
+/**
+ * @brief A datagram handed to the Peer in two parts (cf.
+ *        @code Session::setGatherSendFunction()@endcode).
+ */
+struct GatheredDatagram
+{
+    std::shared_ptr<ByteBuffer> header;
+    std::shared_ptr<const ByteBuffer> payload;
+};
+
 }  // namespace
 
 TEST_F(NetworkTest,
@@ -47,3 +66,77 @@ TEST_F(NetworkTest,
 
     EXPECT_EQ(receivedString, strToTransmit);
 }
+
+TEST(Broadcast,
+     shared_payload_is_not_copied)
+{
+    Packet original(Example::kId, packet::Flag::kReliable);
+
+    original << Example{.str = "shared"};
+    original.share();
+
+    const Packet copy = original;
+
+    EXPECT_TRUE(copy.isShared());
+    EXPECT_EQ(copy.getPayload().data(), original.getPayload().data());
+
+    // Writing into a shared packet gives it its own payload, the other copies are left untouched.
+    Packet written = original;
+
+    written << uint32_t{42};
+    EXPECT_FALSE(written.isShared());
+    EXPECT_EQ(written.getPayload().size(), original.getPayload().size() + sizeof(uint32_t));
+    EXPECT_TRUE(std::ranges::equal(written.getPayload().first(original.getPayload().size()),
+                                   original.getPayload()));
+}
+
+TEST(Broadcast,
+     sessions_send_shared_payload_behind_their_header)
+{
+    std::vector<GatheredDatagram> gathered;
+    std::vector<ByteBuffer> copied;
+    Session first(rtnt::core::udp::endpoint{}, nullptr);
+    Session second(rtnt::core::udp::endpoint{}, nullptr);
+    Session legacy(rtnt::core::udp::endpoint{}, [&](std::shared_ptr<ByteBuffer> datagram) {
+        copied.push_back(*datagram);
+    });
+    Session receiver(rtnt::core::udp::endpoint{}, nullptr);
+
+    for (Session* session : {&first, &second}) {
+        session->setGatherSendFunction(
+            [&](std::shared_ptr<ByteBuffer> header, std::shared_ptr<const ByteBuffer> payload) {
+                gathered.push_back({std::move(header), std::move(payload)});
+            });
+    }
+
+    Packet message(Example::kId, packet::Flag::kReliable);
+
+    message << Example{.str = "shared"};
+    message.share();
+    for (Session* session : {&first, &second, &legacy}) {
+        session->send(message);
+        session->flush();
+    }
+
+    // Each session builds its own header, in front of the same payload.
+    ASSERT_EQ(gathered.size(), 2);
+    for (const GatheredDatagram& datagram : gathered) {
+        EXPECT_EQ(datagram.header->size(), sizeof(packet::Header));
+        EXPECT_EQ(datagram.payload->data(), message.getPayload().data());
+    }
+
+    // Without a gather function, the payload is copied behind the header.
+    ASSERT_EQ(copied.size(), 1);
+
+    ByteBuffer reassembled = *gathered[0].header;
+
+    reassembled.insert(reassembled.end(), gathered[0].payload->begin(), gathered[0].payload->end());
+    EXPECT_EQ(reassembled, copied[0]);
+
+    std::vector<Packet> received = deliver(receiver, {reassembled});
+    Example example;
+
+    ASSERT_EQ(received.size(), 1);
+    received[0] >> example;
+    EXPECT_EQ(example.str, "shared");
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "rtnt/common/buffer_pool.hpp"
+#include "rtnt/core/session.hpp"
+
+TEST(BufferPool,
+     reuse)
+{
+    auto pool = rtnt::BufferPool::create(2, 64);
+
+    const uint8_t* first = nullptr;
+    {
+        rtnt::PooledBuffer buffer = pool->acquire();
+        first = buffer.data();
+
+        ASSERT_TRUE(buffer.isPooled());
+        EXPECT_EQ(buffer.capacity(), 64);
+        EXPECT_EQ(buffer.size(), 0);
+
+        rtnt::PooledBuffer copy = buffer;
+        buffer = {};
+        EXPECT_EQ(copy.data(), first);  // The copy keeps the block alive.
+    }
+
+    const rtnt::PooledBuffer again = pool->acquire();
+    EXPECT_EQ(again.data(), first);
+    EXPECT_EQ(pool->getMissCount(), 0);
+}
+
+TEST(BufferPool,
+     exhaustion_falls_back_to_heap)
+{
+    auto pool = rtnt::BufferPool::create(1, 16);
+
+    const rtnt::PooledBuffer first = pool->acquire();
+    const rtnt::PooledBuffer second = pool->acquire();
+
+    EXPECT_TRUE(first.isPooled());
+    EXPECT_FALSE(second.isPooled());
+    EXPECT_EQ(second.capacity(), 16);
+    EXPECT_EQ(pool->getMissCount(), 1);
+}
+
+TEST(BufferPool,
+     buffers_outlive_pool_owner)
+{
+    rtnt::PooledBuffer buffer;
+    {
+        auto pool = rtnt::BufferPool::create(1, 8);
+        buffer = pool->acquire();
+    }
+    buffer.resize(4);
+    buffer.data()[3] = 0x2A;
+    EXPECT_EQ(buffer.view().size(), 4);
+    EXPECT_EQ(buffer.view()[3], 0x2A);
+}
+
+TEST(BufferPool,
+     concurrent_acquire_release)
+{
+    constexpr size_t threadCount = 4;
+    constexpr size_t iterations = 1 << 14;
+
+    auto pool = rtnt::BufferPool::create(threadCount * 2, 8);
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < threadCount; t++) {
+        threads.emplace_back([&pool, t]() {
+            for (size_t i = 0; i < iterations; i++) {
+                rtnt::PooledBuffer a = pool->acquire();
+                rtnt::PooledBuffer b = pool->acquire();
+
+                a.resize(1);
+                a.data()[0] = static_cast<uint8_t>(t);
+                b = a;
+                ASSERT_EQ(b.data()[0], static_cast<uint8_t>(t));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(pool->getMissCount(), 0);
+}
+
+TEST(BufferPool,
+     slice_shares_block)
+{
+    auto pool = rtnt::BufferPool::create(1, 64);
+    rtnt::PooledBuffer buffer = pool->acquire();
+
+    buffer.resize(10);
+    for (uint8_t i = 0; i < 10; i++) {
+        buffer.data()[i] = i;
+    }
+
+    const rtnt::PooledBuffer first = buffer.slice(0, 4);
+    const rtnt::PooledBuffer last = buffer.slice(8, 4);  // Clamped to the 2 remaining bytes.
+    buffer = {};
+
+    EXPECT_EQ(first.size(), 4);
+    EXPECT_EQ(last.size(), 2);
+    EXPECT_EQ(last.data(), first.data() + 8);
+    EXPECT_EQ(last.view()[1], 9);
+    EXPECT_EQ(last.capacity(), 56);
+
+    // The block only goes back to the pool once every slice is released.
+    EXPECT_FALSE(pool->acquire().isPooled());
+    EXPECT_EQ(pool->getMissCount(), 1);
+}
+
+TEST(BufferPool,
+     session_does_not_copy_payload)
+{
+    auto pool = rtnt::BufferPool::create(1, 64);
+    rtnt::PooledBuffer buffer = pool->acquire();
+    rtnt::core::Session session(rtnt::core::udp::endpoint{}, nullptr);
+
+    rtnt::core::packet::Header header{};
+    header.messageId = 1001;
+    header.channelId = rtnt::core::packet::DEFAULT_CHANNEL_ID;
+    header.packetSize = sizeof(uint32_t);
+    header.convertEndianness();
+
+    const uint32_t value = rtnt::endian::swap(static_cast<uint32_t>(0xDEADBEEF));
+    std::memcpy(buffer.data(), &header, sizeof(header));
+    std::memcpy(buffer.data() + sizeof(header), &value, sizeof(value));
+    buffer.resize(sizeof(header) + sizeof(value));
+
+    const uint8_t* datagram = buffer.data();
+    auto packets = session.handleIncoming(buffer);
+    buffer = {};
+
+    ASSERT_EQ(packets.size(), 1);
+    EXPECT_EQ(packets[0].getPayload().data(), datagram + sizeof(header));
+
+    uint32_t received = 0;
+    packets[0] >> received;
+    EXPECT_EQ(received, 0xDEADBEEF);
+}
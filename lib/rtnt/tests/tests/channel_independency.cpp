@@ -65,6 +65,7 @@ TEST_F(NetworkTest,
 
     PacketCh1 p1_0{0};
     client->send(p1_0);  // this packet WILL be lost
+    client->update();    // Messages are only sent on update.
 
     std::this_thread::sleep_for(
         std::chrono::milliseconds(50));  // decrease if ran on slow machines.
@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "rtnt/core/session.hpp"
+#include "session_helpers.hpp"
+
+namespace {
+
+using rtnt::core::ByteBuffer;
+using rtnt::core::Packet;
+using rtnt::core::Session;
+namespace packet = rtnt::core::packet;
+
+constexpr packet::Id MESSAGE_ID = 1001;
+
+}  // namespace
+
+TEST(Coalescing,
+     messages_share_a_datagram)
+{
+    SessionPair pair;
+
+    for (uint32_t i = 0; i < 32; i++) {
+        Packet p(MESSAGE_ID,
+                 i % 2 ? packet::Flag::kOrdered : packet::Flag::kUnreliable,
+                 packet::DEFAULT_CHANNEL_ID);
+        p << i;
+        pair.sender.send(p);
+    }
+    EXPECT_TRUE(pair.datagrams.empty()) << "Messages must wait for the flush.";
+
+    pair.sender.flush();
+    ASSERT_EQ(pair.datagrams.size(), 1);
+    EXPECT_EQ(pair.sender.getSessionMetrics().datagramsSent, 1);
+
+    const auto bundle = pair.datagrams;
+    std::vector<Packet> received = pair.deliverDatagrams();
+
+    ASSERT_EQ(received.size(), 32);
+    for (uint32_t i = 0; i < 32; i++) {
+        uint32_t value = 0;
+
+        EXPECT_EQ(received[i].getId(), MESSAGE_ID);
+        received[i] >> value;
+        EXPECT_EQ(value, i);
+    }
+
+    // Delivering the same bundle again must not deliver its messages twice.
+    EXPECT_TRUE(deliver(pair.receiver, bundle).empty());
+}
+
+TEST(Coalescing,
+     bundles_respect_mtu)
+{
+    const std::string body(98, 'x');  // 100 bytes once serialized.
+    SessionPair pair;
+
+    for (int i = 0; i < 100; i++) {
+        Packet p(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+        p << body;
+        pair.sender.send(p);
+    }
+    pair.sender.flush();
+
+    EXPECT_GT(pair.datagrams.size(), 1);
+    EXPECT_LE(pair.datagrams.size(), 12);
+    for (const auto& datagram : pair.datagrams) {
+        EXPECT_LE(datagram->size(), packet::MAX_BUNDLE_SIZE);
+    }
+
+    std::vector<Packet> received = pair.deliverDatagrams();
+
+    ASSERT_EQ(received.size(), 100);
+    for (Packet& p : received) {
+        std::string value;
+
+        p >> value;
+        EXPECT_EQ(value, body);
+    }
+}
+
+TEST(Coalescing,
+     legacy_peer_gets_separate_packets)
+{
+    std::vector<ByteBuffer> datagrams;
+    Session session(rtnt::core::udp::endpoint{}, [&](std::shared_ptr<ByteBuffer> datagram) {
+        datagrams.push_back(*datagram);
+    });
+
+    // A CONNECT from a peer speaking a version older than bundles.
+    packet::Header header{};
+    header.protocolVersion = rtnt::BUNDLE_PROTOCOL_VER - 1;
+    header.messageId = static_cast<packet::Id>(packet::SystemMessageId::kConnect);
+    header.channelId = packet::INTERNAL_CHANNEL_ID;
+    header.convertEndianness();
+
+    const ByteBuffer connect(reinterpret_cast<const uint8_t*>(&header),
+                             reinterpret_cast<const uint8_t*>(&header) + sizeof(header));
+    deliver(session, {connect});
+    EXPECT_EQ(session.getProtocolVersion(), rtnt::BUNDLE_PROTOCOL_VER - 1);
+
+    for (uint32_t i = 0; i < 4; i++) {
+        Packet p(MESSAGE_ID, packet::Flag::kUnreliable, packet::DEFAULT_CHANNEL_ID);
+        p << i;
+        session.send(p);
+    }
+    session.flush();
+    EXPECT_EQ(datagrams.size(), 4);
+}
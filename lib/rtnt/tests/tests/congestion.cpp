@@ -0,0 +1,134 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+#include "rtnt/core/congestion_controller.hpp"
+#include "rtnt/core/pacer.hpp"
+#include "rtnt/core/session.hpp"
+#include "session_helpers.hpp"
+
+namespace {
+
+using rtnt::core::CongestionController;
+using rtnt::core::Packet;
+using rtnt::core::Pacer;
+namespace packet = rtnt::core::packet;
+using namespace std::chrono;
+using namespace std::chrono_literals;
+
+constexpr packet::Id MESSAGE_ID = 1001;
+
+}  // namespace
+
+TEST(Congestion,
+     window_grows_then_halves_on_loss)
+{
+    CongestionController controller;
+    const auto start = steady_clock::now();
+
+    EXPECT_EQ(controller.getCongestionWindow(), packet::INITIAL_CONGESTION_WINDOW);
+    EXPECT_EQ(controller.getPacingRate(0us), 0) << "No pacing until the first RTT sample.";
+
+    // Slow start: a full window acknowledged doubles it.
+    controller.onSent(packet::INITIAL_CONGESTION_WINDOW);
+    EXPECT_FALSE(controller.canSend(1));
+    controller.onAcknowledged(packet::INITIAL_CONGESTION_WINDOW, start);
+    EXPECT_EQ(controller.getCongestionWindow(), 2 * packet::INITIAL_CONGESTION_WINDOW);
+    EXPECT_EQ(controller.getBytesInFlight(), 0);
+
+    // Losses of the same flight only halve the window once.
+    controller.onSent(3000);
+    controller.onLost(1000, start + 1ms, start + 10ms);
+    controller.onLost(1000, start + 2ms, start + 11ms);
+    EXPECT_EQ(controller.getCongestionWindow(), packet::INITIAL_CONGESTION_WINDOW);
+    EXPECT_FALSE(controller.isInSlowStart());
+    EXPECT_EQ(controller.getBytesInFlight(), 1000);
+
+    // Congestion avoidance: about one bundle per window acknowledged.
+    const size_t window = controller.getCongestionWindow();
+
+    controller.onSent(window);
+    controller.onAcknowledged(window + 1000, start + 20ms);
+    EXPECT_GE(controller.getCongestionWindow(), window + packet::MAX_BUNDLE_SIZE - 1);
+    EXPECT_LE(controller.getCongestionWindow(), window + 2 * packet::MAX_BUNDLE_SIZE);
+
+    // Window per RTT, with the congestion avoidance gain.
+    EXPECT_EQ(controller.getPacingRate(100ms),
+              controller.getCongestionWindow() * 10 * packet::PACING_GAIN_PERCENT / 100);
+
+    // Never below the minimum.
+    for (int i = 0; i < 32; i++) {
+        const auto sentTime = start + 30ms + milliseconds(2 * i);  // Once per RTT.
+
+        controller.onLost(0, sentTime, sentTime + 1ms);
+    }
+    EXPECT_EQ(controller.getCongestionWindow(), packet::MIN_CONGESTION_WINDOW);
+}
+
+TEST(Congestion,
+     pacer_spreads_datagrams)
+{
+    constexpr uint64_t RATE = 120'000;  // 100 full bundles per second.
+    constexpr size_t DATAGRAM_SIZE = packet::MAX_BUNDLE_SIZE;
+    Pacer pacer;
+    const auto start = steady_clock::now();
+    std::vector<steady_clock::duration> sendTimes;
+
+    pacer.setRate(RATE, start);
+
+    // A game loop trying to send as much as it can, every millisecond.
+    for (auto now = start; now < start + 100ms; now += 1ms) {
+        while (pacer.canSend(now)) {
+            pacer.consume(DATAGRAM_SIZE, now);
+            sendTimes.push_back(now - start);
+        }
+    }
+
+    // The burst of the bucket, then one datagram every 10 ms.
+    ASSERT_GE(sendTimes.size(), 10);
+    EXPECT_LE(sendTimes.size(), packet::MIN_PACING_BURST_SIZE / DATAGRAM_SIZE + 11);
+    for (size_t i = packet::MIN_PACING_BURST_SIZE / DATAGRAM_SIZE + 1; i < sendTimes.size(); i++) {
+        EXPECT_GE(sendTimes[i] - sendTimes[i - 1], 9ms);
+    }
+
+    EXPECT_GT(pacer.getNextSendTime(start + 100ms), start + 100ms);
+
+    pacer.setRate(0, start + 100ms);
+    EXPECT_TRUE(pacer.canSend(start + 100ms)) << "A rate of 0 disables pacing.";
+}
+
+TEST(Congestion,
+     window_holds_back_reliable_messages)
+{
+    const std::string body(998, 'x');  // 1000 bytes once serialized: one message per bundle.
+    SessionPair pair;
+
+    for (int i = 0; i < 40; i++) {
+        Packet p(MESSAGE_ID, packet::Flag::kOrdered, packet::DEFAULT_CHANNEL_ID);
+        p << body;
+        pair.sender.send(p);
+    }
+    pair.sender.flush();
+
+    const auto& metrics = pair.sender.getSessionMetrics();
+
+    EXPECT_GT(pair.datagrams.size(), 1);
+    EXPECT_LT(pair.datagrams.size(), 40);
+    EXPECT_LE(metrics.bytesInFlight, packet::INITIAL_CONGESTION_WINDOW);
+    EXPECT_EQ(metrics.congestionWindow, packet::INITIAL_CONGESTION_WINDOW);
+
+    // Every acknowledgement lets more messages through, until all of them are delivered in order.
+    size_t received = 0;
+
+    for (int round = 0; round < 10 && received < 40; round++) {
+        received += pair.deliverDatagrams().size();
+        pair.reply();
+        pair.sender.flush();
+    }
+
+    EXPECT_EQ(received, 40);
+    EXPECT_GT(metrics.congestionWindow, packet::INITIAL_CONGESTION_WINDOW);
+    EXPECT_GT(metrics.pacingRate, 0);
+    EXPECT_EQ(metrics.retransmitCount, 0);
+}
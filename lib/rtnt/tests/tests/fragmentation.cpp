@@ -0,0 +1,228 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "rtnt/common/constants.hpp"
+#include "rtnt/core/fragment_reassembler.hpp"
+#include "rtnt/core/session.hpp"
+#include "session_helpers.hpp"
+
+namespace {
+
+using rtnt::core::ByteBuffer;
+using rtnt::core::FragmentReassembler;
+using rtnt::core::Packet;
+namespace packet = rtnt::core::packet;
+
+constexpr packet::Id MESSAGE_ID = 1001;
+constexpr uint32_t WORD_COUNT = 25'000;  // 100 KB
+
+/**
+ * @brief Builds the payload of a fragment, filled with its index.
+ */
+ByteBuffer makeFragment(const uint16_t index,
+                        const uint16_t count,
+                        const size_t size = packet::FRAGMENT_SIZE,
+                        const packet::Id messageId = MESSAGE_ID)
+{
+    packet::FragmentHeader header{index, count, messageId};
+    ByteBuffer payload(sizeof(packet::FragmentHeader) + size, static_cast<uint8_t>(index));
+
+    header.convertEndianness();
+    std::memcpy(payload.data(), &header, sizeof(packet::FragmentHeader));
+    return payload;
+}
+
+/**
+ * @brief Gives all the fragments of a message to a reassembler, the last one excepted.
+ */
+void fillAllButLast(FragmentReassembler& reassembler,
+                    const packet::SequenceId firstSequenceId,
+                    const bool isReliable)
+{
+    FragmentReassembler::Message message;
+
+    for (uint16_t i = 0; i + 1 < packet::MAX_FRAGMENT_COUNT; i++) {
+        ASSERT_EQ(reassembler.receive(firstSequenceId + i,
+                                      makeFragment(i, packet::MAX_FRAGMENT_COUNT),
+                                      isReliable,
+                                      message),
+                  FragmentReassembler::Result::kIncomplete);
+    }
+}
+
+Packet makeLargePacket()
+{
+    Packet p(MESSAGE_ID, packet::Flag::kOrdered, packet::DEFAULT_CHANNEL_ID);
+
+    for (uint32_t i = 0; i < WORD_COUNT; i++) {
+        p << i;
+    }
+    return p;
+}
+
+void expectLargePacket(Packet& p)
+{
+    ASSERT_EQ(p.getId(), MESSAGE_ID);
+    ASSERT_EQ(p.getPayload().size(), WORD_COUNT * sizeof(uint32_t));
+    for (uint32_t i = 0; i < WORD_COUNT; i++) {
+        uint32_t value = 0;
+
+        p >> value;
+        ASSERT_EQ(value, i);
+    }
+}
+
+}  // namespace
+
+TEST(Fragmentation,
+     large_message_is_reassembled)
+{
+    SessionPair pair;
+    Packet message = makeLargePacket();
+
+    pair.sender.send(message);
+
+    std::vector<Packet> received;
+
+    // The congestion window lets a few fragments through per round trip.
+    for (int round = 0; round < 100 && received.empty(); round++) {
+        pair.sender.flush();
+        for (const auto& datagram : pair.datagrams) {
+            ASSERT_LE(datagram->size(), packet::MAX_BUNDLE_SIZE);
+        }
+        received = pair.deliverDatagrams();
+        pair.reply();
+    }
+
+    ASSERT_EQ(received.size(), 1);
+    expectLargePacket(received[0]);
+    EXPECT_EQ(pair.sender.getSessionMetrics().retransmitCount, 0);
+}
+
+TEST(Fragmentation,
+     lost_fragment_is_resent_alone)
+{
+    SessionPair pair;
+    Packet message(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+
+    message << ByteBuffer(5 * packet::FRAGMENT_SIZE - 100, 42);
+    pair.sender.send(message);
+    pair.sender.flush();
+    ASSERT_EQ(pair.datagrams.size(), 5);
+
+    // The first fragment is lost, the next ones are acknowledged by a reply.
+    pair.datagrams.erase(pair.datagrams.begin());
+    EXPECT_TRUE(pair.deliverDatagrams().empty());
+    pair.reply();
+
+    // Only the lost fragment is resent, not the whole message.
+    pair.sender.flush();
+    ASSERT_EQ(pair.datagrams.size(), 1);
+    EXPECT_EQ(pair.sender.getSessionMetrics().retransmitCount, 1);
+
+    std::vector<Packet> received = pair.deliverDatagrams();
+    ByteBuffer payload;
+
+    ASSERT_EQ(received.size(), 1);
+    received[0] >> payload;
+    EXPECT_EQ(payload, ByteBuffer(5 * packet::FRAGMENT_SIZE - 100, 42));
+}
+
+TEST(Fragmentation,
+     reassembly_buffer_is_bounded)
+{
+    FragmentReassembler reassembler;
+    FragmentReassembler::Message message;
+    const auto first = makeFragment(0, packet::MAX_FRAGMENT_COUNT);
+
+    // An incomplete unreliable message is evicted to make room for a new one.
+    ASSERT_EQ(reassembler.receive(0, first, false, message),
+              FragmentReassembler::Result::kIncomplete);
+    ASSERT_EQ(reassembler.receive(10'000, first, true, message),
+              FragmentReassembler::Result::kIncomplete);
+    EXPECT_EQ(reassembler.size(), 1);
+    EXPECT_LE(reassembler.getReservedBytes(), packet::REASSEMBLY_BUFFER_SIZE);
+
+    // An incomplete reliable message is not: the new one is refused until it completes.
+    EXPECT_EQ(reassembler.receive(20'000, first, true, message),
+              FragmentReassembler::Result::kRefused);
+
+    fillAllButLast(reassembler, 10'000, true);
+    ASSERT_EQ(reassembler.receive(10'000 + packet::MAX_FRAGMENT_COUNT - 1,
+                                  makeFragment(packet::MAX_FRAGMENT_COUNT - 1,
+                                               packet::MAX_FRAGMENT_COUNT,
+                                               10),
+                                  true,
+                                  message),
+              FragmentReassembler::Result::kComplete);
+    EXPECT_EQ(message.firstSequenceId, 10'000);
+    EXPECT_EQ(message.messageId, MESSAGE_ID);
+    EXPECT_EQ(message.payload.size(),
+              (packet::MAX_FRAGMENT_COUNT - 1) * packet::FRAGMENT_SIZE + 10);
+    EXPECT_EQ(message.payload[packet::FRAGMENT_SIZE], 1);
+    EXPECT_EQ(reassembler.getReservedBytes(), 0);
+
+    EXPECT_EQ(reassembler.receive(20'000, first, true, message),
+              FragmentReassembler::Result::kIncomplete);
+}
+
+TEST(Fragmentation,
+     invalid_fragments_are_rejected)
+{
+    FragmentReassembler reassembler;
+    FragmentReassembler::Message message;
+    const auto receive = [&](const ByteBuffer& fragment) {
+        return reassembler.receive(100, fragment, true, message);
+    };
+
+    EXPECT_EQ(receive(makeFragment(3, 3)), FragmentReassembler::Result::kInvalid);
+    EXPECT_EQ(receive(makeFragment(0, 0)), FragmentReassembler::Result::kInvalid);
+    EXPECT_EQ(receive(makeFragment(0, packet::MAX_FRAGMENT_COUNT + 1)),
+              FragmentReassembler::Result::kInvalid);
+    EXPECT_EQ(receive(makeFragment(0, 2, packet::MAX_FRAGMENT_SIZE + 1)),
+              FragmentReassembler::Result::kInvalid);
+    EXPECT_EQ(receive(makeFragment(1, 2, 0)), FragmentReassembler::Result::kInvalid);
+    EXPECT_EQ(receive({1, 2, 3}), FragmentReassembler::Result::kInvalid);
+    EXPECT_EQ(reassembler.size(), 0);
+
+    // A fragment that does not match the message it belongs to.
+    ASSERT_EQ(receive(makeFragment(0, 2)), FragmentReassembler::Result::kIncomplete);
+    EXPECT_EQ(reassembler.receive(101, makeFragment(1, 3, 10), true, message),
+              FragmentReassembler::Result::kInvalid);
+    EXPECT_EQ(reassembler.receive(101, makeFragment(1, 2, 10, MESSAGE_ID + 1), true, message),
+              FragmentReassembler::Result::kInvalid);
+    EXPECT_EQ(reassembler.receive(101, makeFragment(1, 2, 10), true, message),
+              FragmentReassembler::Result::kComplete);
+}
+
+TEST(Fragmentation,
+     fragment_size_is_learnt)
+{
+    FragmentReassembler reassembler;
+    FragmentReassembler::Message message;
+
+    // The last fragment comes first: it waits for the size of the others.
+    ASSERT_EQ(reassembler.receive(202, makeFragment(2, 3, 100), true, message),
+              FragmentReassembler::Result::kIncomplete);
+    ASSERT_EQ(reassembler.receive(200, makeFragment(0, 3, 1400), true, message),
+              FragmentReassembler::Result::kIncomplete);
+    EXPECT_EQ(reassembler.getReservedBytes(), 3 * 1400);
+
+    // Every fragment but the last one has the same size.
+    EXPECT_EQ(reassembler.receive(201, makeFragment(1, 3, 1000), true, message),
+              FragmentReassembler::Result::kInvalid);
+    ASSERT_EQ(reassembler.receive(201, makeFragment(1, 3, 1400), true, message),
+              FragmentReassembler::Result::kComplete);
+    ASSERT_EQ(message.payload.size(), 2 * 1400 + 100);
+    EXPECT_EQ(message.payload[1400], 1);
+    EXPECT_EQ(message.payload[2 * 1400], 2);
+    EXPECT_EQ(message.payload.back(), 2);
+
+    // A last fragment larger than the others.
+    ASSERT_EQ(reassembler.receive(300, makeFragment(0, 2, 500), true, message),
+              FragmentReassembler::Result::kIncomplete);
+    EXPECT_EQ(reassembler.receive(301, makeFragment(1, 2, 501), true, message),
+              FragmentReassembler::Result::kInvalid);
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "rtnt/core/mtu_prober.hpp"
+#include "rtnt/core/packets/connect.hpp"
+#include "rtnt/core/session.hpp"
+#include "session_helpers.hpp"
+
+namespace {
+
+using rtnt::core::ByteBuffer;
+using rtnt::core::MtuProber;
+using rtnt::core::Packet;
+using rtnt::core::Session;
+namespace packet = rtnt::core::packet;
+using namespace std::chrono_literals;
+
+constexpr packet::Id MESSAGE_ID = 1001;
+
+/**
+ * @brief Runs a prober against a path carrying datagrams of up to the given size.
+ * @return The number of probes sent.
+ */
+size_t probe(MtuProber& prober,
+             const size_t pathMtu)
+{
+    size_t probes = 0;
+
+    for (size_t size = prober.getProbeSize(); size != 0; size = prober.getProbeSize()) {
+        if (size <= pathMtu) {
+            prober.onAcknowledged(size);
+        } else {
+            prober.onLost(size);
+        }
+        probes++;
+    }
+    return probes;
+}
+
+/**
+ * @brief Two sessions that went through the handshake, over a path dropping the datagrams larger
+ *        than its MTU.
+ */
+struct Link
+{
+    size_t pathMtu;
+    std::vector<ByteBuffer> toClient;
+    std::vector<ByteBuffer> toServer;
+    Session server{rtnt::core::udp::endpoint{}, [this](std::shared_ptr<ByteBuffer> datagram) {
+                       if (datagram->size() <= pathMtu) {
+                           toClient.push_back(*datagram);
+                       }
+                   }};
+    Session client{rtnt::core::udp::endpoint{}, [this](std::shared_ptr<ByteBuffer> datagram) {
+                       if (datagram->size() <= pathMtu) {
+                           toServer.push_back(*datagram);
+                       }
+                   }};
+
+    explicit Link(const size_t mtu)
+        : pathMtu(mtu)
+    {
+        client.send(packet::internal::Connect{});
+        client.flush();
+        exchange();
+
+        // A reliable round trip brings the answer timeout (which times probes) down.
+        Packet message(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+        message << uint32_t{0};
+        server.send(message);
+        server.flush();
+        deliver(client, toClient);
+        toClient.clear();
+
+        Packet reply(MESSAGE_ID, packet::Flag::kUnreliable, packet::DEFAULT_CHANNEL_ID);
+        reply << uint32_t{0};
+        client.send(reply);
+        exchange();
+    }
+
+    std::vector<Packet> exchange()
+    {
+        std::vector<Packet> received = deliver(client, toClient);
+
+        toClient.clear();
+        client.flush();
+        deliver(server, toServer);
+        toServer.clear();
+        server.flush();
+        return received;
+    }
+};
+
+}  // namespace
+
+TEST(PathMtu,
+     prober_finds_path_mtu)
+{
+    MtuProber full;
+
+    EXPECT_EQ(probe(full, 1500), 1) << "The largest size is probed first.";
+    EXPECT_EQ(full.getMaxDatagramSize(), packet::MAX_PROBE_SIZE);
+
+    MtuProber tunnel;
+
+    probe(tunnel, 1400);
+    EXPECT_LE(tunnel.getMaxDatagramSize(), 1400);
+    EXPECT_GT(tunnel.getMaxDatagramSize(), 1400 - packet::PROBE_PRECISION);
+
+    MtuProber minimal;
+
+    probe(minimal, packet::MAX_BUNDLE_SIZE);
+    EXPECT_EQ(minimal.getMaxDatagramSize(), packet::MAX_BUNDLE_SIZE);
+}
+
+TEST(PathMtu,
+     single_probe_loss_is_retried)
+{
+    MtuProber prober;
+
+    prober.onLost(packet::MAX_PROBE_SIZE);
+    EXPECT_EQ(prober.getProbeSize(), packet::MAX_PROBE_SIZE);
+    prober.onAcknowledged(packet::MAX_PROBE_SIZE);
+    EXPECT_TRUE(prober.isDone());
+    EXPECT_EQ(prober.getMaxDatagramSize(), packet::MAX_PROBE_SIZE);
+
+    // Answers can not claim more than what is probed.
+    MtuProber forged;
+
+    forged.onAcknowledged(60'000);
+    EXPECT_EQ(forged.getMaxDatagramSize(), packet::MAX_BUNDLE_SIZE);
+}
+
+TEST(PathMtu,
+     sessions_probe_after_handshake)
+{
+    Link link(1300);
+
+    EXPECT_EQ(link.server.getMaxDatagramSize(), packet::MAX_BUNDLE_SIZE);
+
+    for (int i = 0; i < 100; i++) {
+        link.server.update();
+        link.server.flush();
+        link.exchange();
+        std::this_thread::sleep_for(5ms);
+    }
+
+    const size_t mtu = link.server.getMaxDatagramSize();
+
+    EXPECT_LE(mtu, 1300);
+    EXPECT_GT(mtu, 1300 - packet::PROBE_PRECISION);
+
+    // Bundles and fragments now fill the datagrams the path carries.
+    Packet message(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+    message << ByteBuffer(10'000, 42);
+    link.toClient.clear();
+    link.server.send(message);
+    link.server.flush();
+
+    ASSERT_FALSE(link.toClient.empty());
+    for (const ByteBuffer& datagram : link.toClient) {
+        EXPECT_LE(datagram.size(), mtu);
+    }
+    EXPECT_EQ(link.toClient.front().size(), mtu);
+}
+
+TEST(PathMtu,
+     sessions_without_handshake_do_not_probe)
+{
+    std::vector<ByteBuffer> datagrams;
+    Session session(rtnt::core::udp::endpoint{}, [&](std::shared_ptr<ByteBuffer> datagram) {
+        datagrams.push_back(*datagram);
+    });
+
+    session.update();
+    session.flush();
+    EXPECT_TRUE(datagrams.empty());
+    EXPECT_EQ(session.getMaxDatagramSize(), packet::MAX_BUNDLE_SIZE);
+}
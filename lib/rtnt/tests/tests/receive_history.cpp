@@ -0,0 +1,112 @@
+#include <gtest/gtest.h>
+
+#include <deque>
+
+#include "rtnt/common/constants.hpp"
+#include "rtnt/core/receive_history.hpp"
+
+namespace {
+
+using rtnt::core::ReceiveHistory;
+namespace packet = rtnt::core::packet;
+
+}  // namespace
+
+TEST(ReceiveHistory,
+     duplicates_and_bitfield)
+{
+    ReceiveHistory history;
+
+    EXPECT_TRUE(history.isEmpty());
+    EXPECT_FALSE(history.contains(0));
+
+    history.record(10);
+    history.record(12);
+    history.record(8);
+
+    EXPECT_EQ(history.getHead(), 12);
+    EXPECT_TRUE(history.contains(10));
+    EXPECT_TRUE(history.contains(8));
+    EXPECT_FALSE(history.contains(11));
+    EXPECT_FALSE(history.contains(13));
+    // 11 (bit 0) missing, 10 (bit 1) received, 9 (bit 2) missing, 8 (bit 3) received.
+    EXPECT_EQ(history.getBitfield(), 0b1010);
+}
+
+TEST(ReceiveHistory,
+     window_slides)
+{
+    ReceiveHistory history;
+    const packet::SequenceId first = UINT32_MAX - 10;  // Sequence IDs wrap around.
+
+    history.record(first);
+    history.record(first + 100);
+    EXPECT_TRUE(history.contains(first));
+    EXPECT_FALSE(history.isTooOld(first));
+
+    // The first ID shares its bit with this one: it must not be seen as received.
+    const packet::SequenceId next =
+        first + static_cast<packet::SequenceId>(packet::MAX_PACKET_HISTORY_SIZE);
+
+    history.record(next);
+    EXPECT_EQ(history.getHead(), next);
+    EXPECT_TRUE(history.contains(next));
+    EXPECT_TRUE(history.isTooOld(first));
+    EXPECT_FALSE(history.contains(first));
+    EXPECT_TRUE(history.contains(first + 100));
+}
+
+TEST(ReceiveHistory,
+     pending_acks)
+{
+    ReceiveHistory history;
+
+    for (packet::SequenceId id = 0; id < 200; id += 2) {
+        history.record(id);
+    }
+
+    history.markPendingAck(40);
+    history.markPendingAck(20);
+    history.markPendingAck(20);  // Deduplicated.
+    history.markPendingAck(21);  // Never received, ignored.
+    history.markPendingAck(60);
+    EXPECT_TRUE(history.hasPendingAcks());
+
+    std::deque<packet::SequenceId> acks;
+
+    history.takePendingAcks(acks, 2);
+    EXPECT_EQ(acks, (std::deque<packet::SequenceId>{20, 40}));
+
+    history.takePendingAcks(acks, 2);
+    EXPECT_EQ(acks, (std::deque<packet::SequenceId>{20, 40, 60}));
+    EXPECT_FALSE(history.hasPendingAcks());
+
+    // Pending acks sliding out of the window are forgotten.
+    history.markPendingAck(100);
+    history.record(100 + packet::MAX_PACKET_HISTORY_SIZE);
+    EXPECT_FALSE(history.hasPendingAcks());
+}
+
+TEST(ReceiveHistory,
+     too_old_ids_are_acknowledged)
+{
+    ReceiveHistory history;
+    const auto head = static_cast<packet::SequenceId>(packet::MAX_PACKET_HISTORY_SIZE + 10);
+
+    history.record(head);
+    history.record(head - 40);
+    history.markPendingAck(head - 40);
+    ASSERT_TRUE(history.isTooOld(5));
+
+    // A stalled packet, received when too old for the window, is acknowledged first.
+    history.record(5);
+    history.record(5);  // Deduplicated.
+    EXPECT_FALSE(history.contains(5));
+    EXPECT_TRUE(history.hasPendingAcks());
+
+    std::deque<packet::SequenceId> acks;
+
+    history.takePendingAcks(acks, 8);
+    EXPECT_EQ(acks, (std::deque<packet::SequenceId>{5, head - 40}));
+    EXPECT_FALSE(history.hasPendingAcks());
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "rtnt/common/constants.hpp"
+#include "rtnt/core/reorder_buffer.hpp"
+#include "session_helpers.hpp"
+
+namespace {
+
+using rtnt::core::ByteBuffer;
+using rtnt::core::Packet;
+using rtnt::core::ReorderBuffer;
+using rtnt::core::Session;
+namespace packet = rtnt::core::packet;
+
+Packet makePacket(const packet::OrderId orderId)
+{
+    Packet p(1001, packet::Flag::kOrdered);
+    p << orderId;
+    return p;
+}
+
+/**
+ * @brief Encodes an ordered packet as a peer would send it, without payload.
+ */
+ByteBuffer makeDatagram(const packet::SequenceId sequenceId,
+                        const packet::OrderId orderId)
+{
+    packet::Header header{};
+    header.sequenceId = sequenceId;
+    header.channelId = packet::DEFAULT_CHANNEL_ID;
+    header.orderId = orderId;
+    header.messageId = 1001;
+    header.flags = static_cast<uint8_t>(packet::Flag::kOrdered);
+    header.convertEndianness();
+
+    return {reinterpret_cast<const uint8_t*>(&header),
+            reinterpret_cast<const uint8_t*>(&header) + sizeof(header)};
+}
+
+std::vector<packet::OrderId> readOrderIds(std::vector<Packet>& packets)
+{
+    std::vector<packet::OrderId> orderIds;
+
+    for (Packet& p : packets) {
+        packet::OrderId orderId = 0;
+
+        p >> orderId;
+        orderIds.push_back(orderId);
+    }
+    return orderIds;
+}
+
+}  // namespace
+
+TEST(ReorderBuffer,
+     buffers_gaps_and_drains_in_order)
+{
+    ReorderBuffer buffer;
+    std::vector<Packet> ready;
+
+    EXPECT_EQ(buffer.receive(0, makePacket(0), ready), ReorderBuffer::Result::kDelivered);
+    EXPECT_EQ(buffer.capacity(), 0) << "Nothing is allocated until a gap occurs.";
+
+    EXPECT_EQ(buffer.receive(3, makePacket(3), ready), ReorderBuffer::Result::kBuffered);
+    EXPECT_EQ(buffer.receive(2, makePacket(2), ready), ReorderBuffer::Result::kBuffered);
+    EXPECT_EQ(buffer.receive(2, makePacket(2), ready), ReorderBuffer::Result::kDuplicate);
+    EXPECT_EQ(buffer.receive(5, makePacket(5), ready), ReorderBuffer::Result::kBuffered);
+    EXPECT_EQ(buffer.size(), 3);
+    EXPECT_EQ(ready.size(), 1);
+
+    EXPECT_EQ(buffer.receive(1, makePacket(1), ready), ReorderBuffer::Result::kDelivered);
+    EXPECT_EQ(readOrderIds(ready), (std::vector<packet::OrderId>{0, 1, 2, 3}));
+    EXPECT_EQ(buffer.getNextExpected(), 4);
+    EXPECT_EQ(buffer.size(), 1);
+
+    EXPECT_EQ(buffer.receive(0, makePacket(0), ready), ReorderBuffer::Result::kDuplicate);
+}
+
+TEST(ReorderBuffer,
+     grows_and_wraps)
+{
+    const packet::OrderId first = UINT32_MAX - 100;  // Order IDs wrap around.
+    const auto count = static_cast<packet::OrderId>(packet::REORDER_BUFFER_INITIAL_SIZE * 4);
+    ReorderBuffer buffer(first);
+    std::vector<Packet> ready;
+
+    // Every packet arrives before the first one, in reverse order.
+    for (packet::OrderId i = count - 1; i > 0; i--) {
+        ASSERT_EQ(buffer.receive(first + i, makePacket(first + i), ready),
+                  ReorderBuffer::Result::kBuffered);
+    }
+    EXPECT_GE(buffer.capacity(), count);
+    EXPECT_TRUE(ready.empty());
+
+    EXPECT_EQ(buffer.receive(first, makePacket(first), ready), ReorderBuffer::Result::kDelivered);
+    ASSERT_EQ(ready.size(), count);
+    EXPECT_EQ(buffer.size(), 0);
+    EXPECT_EQ(buffer.getNextExpected(), first + count);
+
+    const std::vector<packet::OrderId> orderIds = readOrderIds(ready);
+
+    for (packet::OrderId i = 0; i < count; i++) {
+        EXPECT_EQ(orderIds[i], first + i);
+    }
+}
+
+TEST(ReorderBuffer,
+     refuses_packets_too_far_ahead)
+{
+    ReorderBuffer buffer;
+    std::vector<Packet> ready;
+
+    EXPECT_EQ(buffer.receive(packet::MAX_REORDER_BUFFER_SIZE, makePacket(0), ready),
+              ReorderBuffer::Result::kTooFar);
+    EXPECT_EQ(buffer.receive(packet::MAX_REORDER_BUFFER_SIZE - 1, makePacket(0), ready),
+              ReorderBuffer::Result::kBuffered);
+    EXPECT_EQ(buffer.capacity(), packet::MAX_REORDER_BUFFER_SIZE);
+}
+
+TEST(ReorderBuffer,
+     packets_too_far_ahead_are_not_acknowledged)
+{
+    Session session(rtnt::core::udp::endpoint{}, [](std::shared_ptr<ByteBuffer>) {});
+    const ByteBuffer tooFar = makeDatagram(0, packet::MAX_REORDER_BUFFER_SIZE);
+
+    // Not acknowledged, so its retransmission is not a duplicate.
+    EXPECT_TRUE(deliver(session, {tooFar, tooFar}).empty());
+    EXPECT_EQ(session.getSessionMetrics().refusedCount, 2);
+    EXPECT_EQ(session.getSessionMetrics().duplicateCount, 0);
+
+    // Once the gap is filled, it is received again, and delivered after it.
+    for (packet::OrderId i = 0; i < packet::MAX_REORDER_BUFFER_SIZE; i++) {
+        ASSERT_EQ(deliver(session, {makeDatagram(i + 1, i)}).size(), 1);
+    }
+
+    std::vector<Packet> received = deliver(session, {tooFar});
+
+    ASSERT_EQ(received.size(), 1);
+    EXPECT_EQ(received[0].getId(), 1001);
+    EXPECT_EQ(session.getSessionMetrics().refusedCount, 2);
+}
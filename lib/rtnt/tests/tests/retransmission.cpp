@@ -0,0 +1,298 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "rtnt/core/rtt_estimator.hpp"
+#include "rtnt/core/session.hpp"
+#include "session_helpers.hpp"
+
+namespace {
+
+using rtnt::core::ByteBuffer;
+using rtnt::core::Packet;
+using rtnt::core::RttEstimator;
+namespace packet = rtnt::core::packet;
+using namespace std::chrono_literals;
+
+constexpr packet::Id MESSAGE_ID = 1001;
+
+}  // namespace
+
+TEST(Retransmission,
+     rto_follows_rtt_samples)
+{
+    RttEstimator estimator;
+
+    EXPECT_FALSE(estimator.hasSample());
+    EXPECT_EQ(estimator.getRetransmitTimeout(), packet::INITIAL_RESEND_TIMEOUT);
+
+    // SRTT = R, RTTVAR = R / 2, RTO = SRTT + 4 RTTVAR.
+    estimator.addSample(100ms);
+    EXPECT_EQ(estimator.getSmoothedRtt(), 100ms);
+    EXPECT_EQ(estimator.getRttVariation(), 50ms);
+    EXPECT_EQ(estimator.getRetransmitTimeout(), 300ms);
+
+    // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R.
+    estimator.addSample(180ms);
+    EXPECT_EQ(estimator.getRttVariation(), 57500us);
+    EXPECT_EQ(estimator.getSmoothedRtt(), 110ms);
+    EXPECT_EQ(estimator.getRetransmitTimeout(), 340ms);
+
+    // Each retransmission doubles the timeout, up to its maximum.
+    EXPECT_EQ(estimator.getRetransmitTimeout(1), 680ms);
+    EXPECT_EQ(estimator.getRetransmitTimeout(2), packet::MAX_RESEND_TIMEOUT);
+    EXPECT_EQ(estimator.getRetransmitTimeout(200), packet::MAX_RESEND_TIMEOUT);
+}
+
+TEST(Retransmission,
+     rto_is_bounded_on_fast_links)
+{
+    RttEstimator estimator;
+
+    for (int i = 0; i < 16; i++) {
+        estimator.addSample(200us);
+    }
+    EXPECT_EQ(estimator.getSmoothedRtt(), 200us);
+    EXPECT_LT(estimator.getRetransmitTimeout(), packet::INITIAL_RESEND_TIMEOUT);
+
+    // A quiet receiver may delay its ACK: the timeout leaves room for it.
+    EXPECT_EQ(estimator.getRetransmitTimeout(), 200us + packet::MAX_ACK_DELAY);
+}
+
+TEST(Retransmission,
+     delayed_ack_is_not_retransmitted)
+{
+    SessionPair pair;
+
+    // The RTT is learnt from ACKs sent right away, along replies.
+    for (uint32_t i = 0; i < 8; i++) {
+        Packet p(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+        p << i;
+        pair.sender.send(p);
+        pair.sender.flush();
+        pair.deliverDatagrams();
+        pair.reply();
+    }
+    ASSERT_LT(pair.sender.getSessionMetrics().smoothedRtt, 5'000);
+
+    // Then the receiver has nothing to send: it only acknowledges from update(), once its ACK
+    // timeout is over.
+    const uint64_t congestionWindow = pair.sender.getSessionMetrics().congestionWindow;
+    Packet p(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+
+    p << uint32_t{0};
+    pair.sender.send(p);
+    pair.sender.flush();
+    ASSERT_EQ(pair.deliverDatagrams().size(), 1);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    while (pair.replies.empty() && std::chrono::steady_clock::now() - start < 500ms) {
+        std::this_thread::sleep_for(2ms);
+        pair.receiver.update();
+        pair.receiver.flush();
+        pair.sender.update();
+        pair.sender.flush();
+    }
+    ASSERT_FALSE(pair.replies.empty()) << "The receiver never acknowledged the packet.";
+    EXPECT_GE(std::chrono::steady_clock::now() - start, packet::ACK_TIMEOUT);
+    deliver(pair.sender, pair.replies);
+
+    EXPECT_EQ(pair.sender.getSessionMetrics().retransmitCount, 0)
+        << "The packet was retransmitted before its ACK came.";
+    EXPECT_GE(pair.sender.getSessionMetrics().congestionWindow, congestionWindow);
+}
+
+TEST(Retransmission,
+     fast_retransmit_fills_hole)
+{
+    SessionPair pair;
+
+    for (uint32_t i = 0; i < 5; i++) {
+        Packet p(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+        p << i;
+        pair.sender.send(p);
+        pair.sender.flush();
+    }
+    ASSERT_EQ(pair.datagrams.size(), 5);
+
+    // The first packet is lost, the next ones are acknowledged by a reply.
+    pair.datagrams.erase(pair.datagrams.begin());
+    ASSERT_EQ(pair.deliverDatagrams().size(), 4);
+    pair.reply();
+    EXPECT_EQ(pair.sender.getSessionMetrics().fastRetransmitCount, 1);
+    EXPECT_EQ(pair.sender.getSessionMetrics().retransmitCount, 1);
+
+    // Resent right away, long before any timeout.
+    pair.sender.flush();
+    ASSERT_EQ(pair.datagrams.size(), 1);
+
+    std::vector<Packet> received = pair.deliverDatagrams();
+    uint32_t value = 1;
+
+    ASSERT_EQ(received.size(), 1);
+    received[0] >> value;
+    EXPECT_EQ(value, 0);
+}
+
+TEST(Retransmission,
+     fast_retransmit_follows_transmission_order)
+{
+    SessionPair pair;
+    // Large enough for each message to take its own datagram.
+    const ByteBuffer padding(packet::MAX_BUNDLE_SIZE / 2, 0);
+    const auto sendReliable = [&](const uint32_t value, const packet::Priority priority) {
+        Packet p(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+        p << value << padding;
+        p.setPriority(priority);
+        pair.sender.send(p);
+    };
+
+    // Queued first, the low priority message is transmitted last.
+    sendReliable(0, packet::Priority::kLow);
+    for (uint32_t i = 1; i <= 3; i++) {
+        sendReliable(i, packet::Priority::kHigh);
+    }
+    pair.sender.flush();
+    ASSERT_EQ(pair.datagrams.size(), 4);
+
+    // The first one on the wire is lost, the next two are acknowledged. Their Sequence IDs are 3
+    // past the low priority message, but it was transmitted after them: it is not lost.
+    const std::shared_ptr<ByteBuffer> last = pair.datagrams[3];
+
+    pair.datagrams = {pair.datagrams[1], pair.datagrams[2]};
+    ASSERT_EQ(pair.deliverDatagrams().size(), 2);
+    pair.reply();
+    EXPECT_EQ(pair.sender.getSessionMetrics().fastRetransmitCount, 0)
+        << "A message sent later than the ones acknowledged was retransmitted.";
+
+    // The third acknowledgement past the first transmission proves it lost.
+    pair.datagrams = {last};
+    ASSERT_EQ(pair.deliverDatagrams().size(), 1);
+    pair.reply();
+    EXPECT_EQ(pair.sender.getSessionMetrics().fastRetransmitCount, 1);
+    EXPECT_EQ(pair.sender.getSessionMetrics().retransmitCount, 1);
+
+    pair.sender.flush();
+    ASSERT_EQ(pair.datagrams.size(), 1);
+
+    std::vector<Packet> received = pair.deliverDatagrams();
+    uint32_t value = 0;
+
+    ASSERT_EQ(received.size(), 1);
+    received[0] >> value;
+    EXPECT_EQ(value, 1);
+}
+
+TEST(Retransmission,
+     stalled_packet_survives_unreliable_volume)
+{
+    SessionPair pair;
+    const auto sendReliable = [&](const uint32_t value) {
+        Packet p(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+        p << value;
+        pair.sender.send(p);
+    };
+
+    // The reliable packet is lost...
+    sendReliable(0);
+    pair.sender.flush();
+    ASSERT_EQ(pair.datagrams.size(), 1);
+    pair.datagrams.clear();
+
+    // ... while unreliable traffic takes a whole window of Sequence IDs.
+    const size_t volume = packet::MAX_SENT_PACKET_WINDOW_SIZE - 1;
+
+    for (uint32_t i = 0; i < volume; i++) {
+        Packet p(MESSAGE_ID, packet::Flag::kUnreliable, packet::DEFAULT_CHANNEL_ID);
+        p << i;
+        pair.sender.send(p);
+    }
+    pair.sender.flush();
+    ASSERT_EQ(pair.deliverDatagrams().size(), volume);
+
+    // The first one shares the slot of the stalled packet.
+    for (uint32_t i = 1; i <= 3; i++) {
+        sendReliable(i);
+    }
+    EXPECT_FALSE(pair.sender.shouldClose());
+    pair.sender.flush();
+    ASSERT_EQ(pair.deliverDatagrams().size(), 3);
+    pair.reply();
+    EXPECT_EQ(pair.sender.getSessionMetrics().fastRetransmitCount, 1);
+
+    // Older than the reception history, the retransmission is still delivered, and acknowledged.
+    pair.sender.flush();
+
+    std::vector<Packet> received = pair.deliverDatagrams();
+    uint32_t value = 1;
+
+    ASSERT_EQ(received.size(), 1);
+    received[0] >> value;
+    EXPECT_EQ(value, 0);
+
+    std::this_thread::sleep_for(packet::ACK_TIMEOUT + 10ms);
+    pair.receiver.update();
+    pair.receiver.flush();
+    deliver(pair.sender, pair.replies);
+    pair.sender.flush();
+    EXPECT_EQ(pair.sender.getSessionMetrics().bytesInFlight, 0);
+    EXPECT_FALSE(pair.sender.shouldClose());
+}
+
+TEST(Retransmission,
+     retransmission_reuses_datagram)
+{
+    SessionPair pair;
+    auto& datagrams = pair.datagrams;
+
+    for (uint32_t i = 0; i < 5; i++) {
+        Packet p(MESSAGE_ID, packet::Flag::kReliable, packet::DEFAULT_CHANNEL_ID);
+        p << i;
+        pair.sender.send(p);
+        pair.sender.flush();
+    }
+    ASSERT_EQ(datagrams.size(), 5);
+
+    // The first packet is lost, and still held by the Peer when it is fast retransmitted.
+    const std::shared_ptr<ByteBuffer> lost = datagrams[0];
+    const ByteBuffer original = *lost;
+
+    datagrams.erase(datagrams.begin());
+    ASSERT_EQ(pair.deliverDatagrams().size(), 4);
+    pair.reply();
+    pair.sender.flush();
+
+    // The held datagram is left untouched: the retransmission is a patched copy of it.
+    ASSERT_EQ(datagrams.size(), 1);
+    EXPECT_NE(datagrams[0], lost);
+    EXPECT_EQ(*lost, original);
+
+    const auto header = packet::Header::parse(*datagrams[0]).header;
+
+    ASSERT_TRUE(header.has_value());
+    EXPECT_EQ(header->sequenceId, 0);
+    EXPECT_NE(header->flags & static_cast<uint8_t>(packet::Flag::kHasAck), 0);
+    EXPECT_TRUE(std::equal(original.begin() + sizeof(packet::Header),
+                           original.end(),
+                           datagrams[0]->begin() + sizeof(packet::Header)));
+
+    // Once the Peer is done with it, the next retransmission sends the same buffer again.
+    const ByteBuffer* resent = datagrams[0].get();
+
+    datagrams.clear();
+    std::this_thread::sleep_for(packet::MAX_RESEND_TIMEOUT + 50ms);
+    pair.sender.update();
+    pair.sender.flush();
+    ASSERT_EQ(datagrams.size(), 1);
+    EXPECT_EQ(datagrams[0].get(), resent);
+
+    std::vector<Packet> received = pair.deliverDatagrams();
+    uint32_t value = 1;
+
+    ASSERT_EQ(received.size(), 1);
+    received[0] >> value;
+    EXPECT_EQ(value, 0);
+}
@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+
+#include <deque>
+#include <vector>
+
+#include "rtnt/core/packets/rich_ack.hpp"
+
+namespace {
+
+using rtnt::core::packet::SequenceId;
+using rtnt::core::packet::internal::AckBlock;
+using rtnt::core::packet::internal::RichAck;
+
+std::deque<SequenceId> decode(const RichAck& ack)
+{
+    std::deque<SequenceId> sequenceIds;
+
+    ack.forEach([&](const SequenceId id) { sequenceIds.push_back(id); });
+    return sequenceIds;
+}
+
+}  // namespace
+
+TEST(RichAck,
+     runs_and_tails)
+{
+    const std::deque<SequenceId> sequenceIds = {10, 11, 12, 14, 20, 45, 100, 101};
+    const RichAck ack{.blocks = RichAck::encode(sequenceIds)};
+
+    // 10-12, then 14, 20 and 45 after the gap at 13. 100 is too far for the tail.
+    const std::vector<AckBlock> expected = {
+        {.start = 10, .length = 3, .tail = 1U << 0 | 1U << 6 | 1U << 31},
+        {.start = 100, .length = 2, .tail = 0},
+    };
+
+    EXPECT_EQ(ack.blocks, expected);
+    EXPECT_EQ(decode(ack), sequenceIds);
+}
+
+TEST(RichAck,
+     bursty_loss_is_compact)
+{
+    std::deque<SequenceId> sequenceIds;
+
+    // Bursts of 5 packets lost every 15 packets, with Sequence IDs wrapping around.
+    for (SequenceId id = UINT32_MAX - 200; sequenceIds.size() < 256; id++) {
+        if ((id - (UINT32_MAX - 200)) % 15 < 10) {
+            sequenceIds.push_back(id);
+        }
+    }
+
+    RichAck ack{.blocks = RichAck::encode(sequenceIds)};
+    rtnt::core::Packet packet(RichAck::kId);
+    packet << ack;
+
+    // 4 bytes per ID with the legacy encoding.
+    EXPECT_LT(packet.getPayload().size() * 10, sequenceIds.size() * sizeof(SequenceId));
+
+    RichAck received;
+    packet >> received;
+    EXPECT_EQ(decode(received), sequenceIds);
+}
@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rtnt/core/session.hpp"
+#include "session_helpers.hpp"
+
+namespace {
+
+using rtnt::core::Packet;
+namespace packet = rtnt::core::packet;
+using namespace std::chrono_literals;
+
+const std::string BODY(998, 'x');  // 1000 bytes once serialized: one message per bundle.
+
+struct Snapshot
+{
+    static constexpr packet::Id kId = 1001;
+    static constexpr packet::Name kName = "SNAPSHOT";
+    static constexpr packet::Flag kFlag = packet::Flag::kUnreliable;
+    static constexpr packet::Priority kPriority = packet::Priority::kLow;
+    static constexpr auto kLifetime = 1ms;
+
+    std::string body = BODY;
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & body;
+    }
+};
+
+struct Chat
+{
+    static constexpr packet::Id kId = 1002;
+    static constexpr packet::Name kName = "CHAT";
+    static constexpr packet::Flag kFlag = packet::Flag::kReliable;
+    static constexpr auto kLifetime = 1ms;  // Ignored, reliable messages never expire.
+
+    std::string body = BODY;
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & body;
+    }
+};
+
+struct Spawn
+{
+    static constexpr packet::Id kId = 1003;
+    static constexpr packet::Name kName = "SPAWN";
+    static constexpr packet::Flag kFlag = packet::Flag::kReliable;
+    static constexpr packet::Priority kPriority = packet::Priority::kHigh;
+
+    std::string body = BODY;
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & body;
+    }
+};
+
+struct Connection : SessionPair
+{
+    std::vector<packet::Id> flush()
+    {
+        std::vector<packet::Id> ids;
+
+        sender.flush();
+        for (const Packet& p : deliverDatagrams()) {
+            ids.push_back(p.getId());
+        }
+        return ids;
+    }
+};
+
+}  // namespace
+
+TEST(SendQueue,
+     expired_unreliable_messages_are_dropped)
+{
+    Connection connection;
+
+    connection.sender.send(Snapshot{});
+    connection.sender.send(Chat{});
+    std::this_thread::sleep_for(5ms);
+
+    EXPECT_EQ(connection.flush(), std::vector<packet::Id>{Chat::kId});
+    EXPECT_EQ(connection.sender.getSessionMetrics().expiredCount, 1);
+
+    // Sent in time, it is not dropped.
+    connection.sender.send(Snapshot{});
+    EXPECT_EQ(connection.flush(), std::vector<packet::Id>{Snapshot::kId});
+}
+
+TEST(SendQueue,
+     higher_priorities_go_first)
+{
+    Connection connection;
+
+    connection.sender.send(Snapshot{});
+    connection.sender.send(Chat{});
+    connection.sender.send(Spawn{});
+    connection.sender.send(Chat{});
+    connection.sender.send(Spawn{});
+
+    EXPECT_EQ(connection.flush(),
+              (std::vector<packet::Id>{Spawn::kId, Spawn::kId, Chat::kId, Chat::kId, Snapshot::kId}));
+}
+
+TEST(SendQueue,
+     unreliable_messages_pass_a_full_window)
+{
+    Connection connection;
+
+    for (int i = 0; i < 20; i++) {
+        connection.sender.send(Chat{});
+    }
+    connection.sender.send(Snapshot{});
+
+    const std::vector<packet::Id> ids = connection.flush();
+
+    ASSERT_FALSE(ids.empty());
+    EXPECT_LT(ids.size(), 21) << "The congestion window holds back some chat messages.";
+    EXPECT_EQ(ids.back(), Snapshot::kId) << "The snapshot does not wait for the window.";
+    EXPECT_EQ(connection.sender.getSessionMetrics().expiredCount, 0);
+}
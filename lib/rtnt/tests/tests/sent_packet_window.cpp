@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "rtnt/common/constants.hpp"
+#include "rtnt/core/sent_packet_window.hpp"
+
+namespace {
+
+using rtnt::core::SentPacketInfo;
+using rtnt::core::SentPacketWindow;
+namespace packet = rtnt::core::packet;
+
+SentPacketInfo makeInfo(const packet::SequenceId sequenceId)
+{
+    return {rtnt::core::Packet(1001, packet::Flag::kReliable), {}, sequenceId, 0};
+}
+
+}  // namespace
+
+TEST(SentPacketWindow,
+     insert_find_erase)
+{
+    SentPacketWindow window;
+
+    window.insert(makeInfo(10));
+    window.insert(makeInfo(11));
+    EXPECT_EQ(window.size(), 2);
+
+    ASSERT_NE(window.find(10), nullptr);
+    EXPECT_EQ(window.find(10)->sequenceId, 10);
+    // Same slot, other Sequence ID.
+    EXPECT_EQ(window.find(10 + packet::SENT_PACKET_WINDOW_INITIAL_SIZE), nullptr);
+
+    EXPECT_TRUE(window.erase(10));
+    EXPECT_FALSE(window.erase(10));
+    EXPECT_EQ(window.find(10), nullptr);
+    EXPECT_EQ(window.size(), 1);
+}
+
+TEST(SentPacketWindow,
+     bitfield_acknowledgement)
+{
+    SentPacketWindow window;
+
+    for (packet::SequenceId id = 0; id < 40; id++) {
+        window.insert(makeInfo(id));
+    }
+
+    // Acknowledges 38 (bit 0), 36 (bit 2) and 7 (bit 31), relative to 39.
+    EXPECT_EQ(window.erase(39, 0b101 | 1U << 31), 3);
+    EXPECT_EQ(window.find(38), nullptr);
+    EXPECT_EQ(window.find(36), nullptr);
+    EXPECT_EQ(window.find(7), nullptr);
+    EXPECT_NE(window.find(37), nullptr);
+    EXPECT_EQ(window.size(), 37);
+
+    // Already acknowledged packets are ignored.
+    EXPECT_EQ(window.erase(39, 0b101), 0);
+}
+
+TEST(SentPacketWindow,
+     grows_with_span_and_wraps)
+{
+    SentPacketWindow window;
+    const packet::SequenceId first = UINT32_MAX - 100;  // Sequence IDs wrap around.
+    const size_t count = packet::SENT_PACKET_WINDOW_INITIAL_SIZE * 8;
+
+    for (size_t i = 0; i < count; i++) {
+        window.insert(makeInfo(first + static_cast<packet::SequenceId>(i)));
+    }
+    EXPECT_EQ(window.size(), count);
+    EXPECT_GE(window.capacity(), count);
+
+    std::vector<packet::SequenceId> visited;
+    window.forEach([&](const SentPacketInfo& info) {
+        visited.push_back(info.sequenceId);
+        return true;
+    });
+    EXPECT_EQ(visited.size(), count);
+
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_NE(window.find(first + static_cast<packet::SequenceId>(i)), nullptr);
+    }
+}
+
+TEST(SentPacketWindow,
+     spills_beyond_maximum)
+{
+    SentPacketWindow window;
+    const packet::SequenceId stalled = packet::MAX_SENT_PACKET_WINDOW_SIZE;
+
+    // A stalled packet, while others took a whole window of Sequence IDs.
+    window.insert(makeInfo(stalled - 1));
+    window.insert(makeInfo(0));
+    window.insert(makeInfo(stalled));
+    window.insert(makeInfo(stalled * 2));
+    EXPECT_EQ(window.capacity(), packet::MAX_SENT_PACKET_WINDOW_SIZE);
+    EXPECT_EQ(window.size(), 4);
+
+    ASSERT_NE(window.find(stalled), nullptr);
+    EXPECT_EQ(window.find(stalled)->sequenceId, stalled);
+    ASSERT_NE(window.find(stalled * 2), nullptr);
+
+    size_t visited = 0;
+    window.forEach([&](const SentPacketInfo&) {
+        visited++;
+        return true;
+    });
+    EXPECT_EQ(visited, 4);
+
+    // Acknowledged in any order, whether in the ring or spilled.
+    EXPECT_TRUE(window.erase(stalled));
+    EXPECT_TRUE(window.erase(0));
+    EXPECT_EQ(window.find(stalled), nullptr);
+    EXPECT_NE(window.find(stalled * 2), nullptr);
+    EXPECT_TRUE(window.erase(stalled * 2));
+    EXPECT_FALSE(window.erase(stalled * 2));
+    EXPECT_EQ(window.size(), 1);
+}
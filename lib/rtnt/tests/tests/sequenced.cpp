@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <ranges>
+#include <vector>
+
+#include "rtnt/core/sequence_filter.hpp"
+#include "rtnt/core/session.hpp"
+#include "session_helpers.hpp"
+
+namespace {
+
+using rtnt::core::Packet;
+using rtnt::core::SequenceFilter;
+namespace packet = rtnt::core::packet;
+
+struct Position
+{
+    static constexpr packet::Id kId = 1001;
+    static constexpr packet::Name kName = "POSITION";
+    static constexpr packet::Flag kFlag = packet::Flag::kSequenced;
+
+    uint32_t entity;
+    float x;
+
+    [[nodiscard]] uint32_t sequenceKey() const { return entity; }
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & entity & x;
+    }
+};
+
+}  // namespace
+
+TEST(Sequenced,
+     filter_keeps_newest_per_key)
+{
+    SequenceFilter filter;
+    const packet::SequenceId first = UINT32_MAX - 1;  // Sequence IDs wrap around.
+
+    EXPECT_TRUE(filter.accept(7, first));
+    EXPECT_TRUE(filter.accept(7, first + 2));
+    EXPECT_FALSE(filter.accept(7, first + 1));
+    EXPECT_FALSE(filter.accept(7, first));
+
+    // Other keys are independent.
+    EXPECT_TRUE(filter.accept(8, first));
+    EXPECT_TRUE(filter.accept(7, first + 3));
+}
+
+TEST(Sequenced,
+     stale_updates_are_dropped)
+{
+    SessionPair pair;
+
+    EXPECT_FALSE(packet::isReliable(packet::Flag::kSequenced));
+
+    for (const Position& position : {Position{1, 1.F},
+                                     Position{2, 1.F},
+                                     Position{1, 2.F},
+                                     Position{2, 2.F},
+                                     Position{1, 3.F}}) {
+        pair.sender.send(position);
+        pair.sender.flush();  // One datagram each, so that they can be reordered.
+    }
+    ASSERT_EQ(pair.datagrams.size(), 5);
+
+    // The network delivers them in reverse order: only the newest of each entity is kept.
+    std::ranges::reverse(pair.datagrams);
+
+    std::vector<Packet> received = pair.deliverDatagrams();
+
+    ASSERT_EQ(received.size(), 2);
+    EXPECT_EQ(pair.receiver.getSessionMetrics().staleCount, 3);
+
+    Position position{};
+
+    received[0] >> position;
+    EXPECT_EQ(position.entity, 1);
+    EXPECT_EQ(position.x, 3.F);
+    received[1] >> position;
+    EXPECT_EQ(position.entity, 2);
+    EXPECT_EQ(position.x, 2.F);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "rtnt/common/buffer_pool.hpp"
+#include "rtnt/core/session.hpp"
+
+/**
+ * @brief Sends the datagrams of a session to another one, as a Peer would.
+ */
+inline std::vector<rtnt::core::Packet> deliver(rtnt::core::Session& receiver,
+                                               const std::vector<rtnt::core::ByteBuffer>& datagrams)
+{
+    auto pool = rtnt::BufferPool::create(datagrams.size(), 2048);
+    std::vector<rtnt::core::Packet> received;
+
+    for (const rtnt::core::ByteBuffer& datagram : datagrams) {
+        rtnt::PooledBuffer buffer = pool->acquire();
+
+        std::memcpy(buffer.data(), datagram.data(), datagram.size());
+        buffer.resize(datagram.size());
+        for (rtnt::core::Packet& p : receiver.handleIncoming(buffer)) {
+            received.push_back(std::move(p));
+        }
+    }
+    return received;
+}
+
+/**
+ * @brief Same as above, with the datagrams as the session handed them to its Peer.
+ */
+inline std::vector<rtnt::core::Packet> deliver(
+    rtnt::core::Session& receiver,
+    const std::vector<std::shared_ptr<rtnt::core::ByteBuffer>>& datagrams)
+{
+    std::vector<rtnt::core::ByteBuffer> copies;
+
+    for (const auto& datagram : datagrams) {
+        copies.push_back(*datagram);
+    }
+    return deliver(receiver, copies);
+}
+
+/**
+ * @brief Two sessions talking to each other: the datagrams they send are kept (as their Peer
+ *        would hold them), until the test delivers them to the other session, or drops them.
+ */
+struct SessionPair
+{
+    static constexpr rtnt::core::packet::Id REPLY_ID = 1000;
+
+    std::vector<std::shared_ptr<rtnt::core::ByteBuffer>> datagrams;  ///< Sent by the sender
+    std::vector<std::shared_ptr<rtnt::core::ByteBuffer>> replies;    ///< Sent by the receiver
+    rtnt::core::Session sender{rtnt::core::udp::endpoint{},
+                               [this](std::shared_ptr<rtnt::core::ByteBuffer> datagram) {
+                                   datagrams.push_back(std::move(datagram));
+                               }};
+    rtnt::core::Session receiver{rtnt::core::udp::endpoint{},
+                                 [this](std::shared_ptr<rtnt::core::ByteBuffer> datagram) {
+                                     replies.push_back(std::move(datagram));
+                                 }};
+
+    /**
+     * @brief Delivers the datagrams of the sender to the receiver.
+     */
+    std::vector<rtnt::core::Packet> deliverDatagrams()
+    {
+        std::vector<rtnt::core::Packet> received = deliver(receiver, datagrams);
+
+        datagrams.clear();
+        return received;
+    }
+
+    /**
+     * @brief Makes the receiver send an unreliable reply, which acknowledges what it received, and
+     *        delivers it to the sender.
+     */
+    void reply()
+    {
+        rtnt::core::Packet p(REPLY_ID,
+                             rtnt::core::packet::Flag::kUnreliable,
+                             rtnt::core::packet::DEFAULT_CHANNEL_ID);
+
+        p << uint32_t{0};
+        receiver.send(p);
+        receiver.flush();
+        deliver(sender, replies);
+        replies.clear();
+    }
+};
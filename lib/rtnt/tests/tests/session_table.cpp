@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "rtnt/common/constants.hpp"
+#include "rtnt/core/session.hpp"
+#include "rtnt/core/session_table.hpp"
+
+namespace {
+
+using rtnt::core::Session;
+using rtnt::core::SessionTable;
+using rtnt::core::udp;
+
+udp::endpoint makeEndpoint(const uint16_t port)
+{
+    return {asio::ip::make_address_v4("127.0.0.1"), port};
+}
+
+std::shared_ptr<Session> makeSession(const uint16_t port)
+{
+    return std::make_shared<Session>(makeEndpoint(port), nullptr);
+}
+
+}  // namespace
+
+TEST(SessionTable,
+     sessions_are_found_by_endpoint)
+{
+    SessionTable table;
+    const auto first = makeSession(1000);
+    const auto second = makeSession(1001);
+
+    EXPECT_EQ(table.find(makeEndpoint(1000)), nullptr);
+    EXPECT_EQ(table.insert(makeEndpoint(1000), first), first);
+    EXPECT_EQ(table.insert(makeEndpoint(1001), second), second);
+
+    // An endpoint keeps its session: inserting another one gives the first back.
+    EXPECT_EQ(table.insert(makeEndpoint(1000), second), first);
+    EXPECT_EQ(table.find(makeEndpoint(1000)), first);
+    EXPECT_EQ(table.find(makeEndpoint(1001)), second);
+    EXPECT_EQ(table.size(), 2);
+
+    // A session is only removed by its own endpoint and pointer.
+    EXPECT_FALSE(table.erase(makeEndpoint(1000), second));
+    EXPECT_TRUE(table.erase(makeEndpoint(1000), first));
+    EXPECT_FALSE(table.erase(makeEndpoint(1000), first));
+    EXPECT_EQ(table.find(makeEndpoint(1000)), nullptr);
+    EXPECT_EQ(table.find(makeEndpoint(1001)), second);
+    EXPECT_EQ(table.size(), 1);
+
+    table.reclaim();
+
+    size_t visited = 0;
+
+    table.forEach([&](const std::shared_ptr<Session>& session) {
+        EXPECT_EQ(session, second);
+        visited++;
+    });
+    EXPECT_EQ(visited, 1);
+}
+
+TEST(SessionTable,
+     table_grows_and_reuses_removed_slots)
+{
+    constexpr uint16_t count = 10 * rtnt::core::SESSION_TABLE_INITIAL_CAPACITY;
+
+    SessionTable table;
+    std::vector<std::shared_ptr<Session>> sessions;
+
+    for (uint16_t i = 0; i < count; i++) {
+        sessions.push_back(table.insert(makeEndpoint(1000 + i), makeSession(1000 + i)));
+    }
+    ASSERT_EQ(table.size(), count);
+    for (uint16_t i = 0; i < count; i++) {
+        ASSERT_EQ(table.find(makeEndpoint(1000 + i)), sessions[i]);
+    }
+
+    // Sessions coming and going leave removed slots behind, which must not fill the table.
+    for (int round = 0; round < 10; round++) {
+        for (uint16_t i = 0; i < count; i++) {
+            ASSERT_TRUE(table.erase(makeEndpoint(1000 + i), sessions[i]));
+            sessions[i] = table.insert(makeEndpoint(1000 + i), makeSession(1000 + i));
+        }
+        table.reclaim();
+    }
+    EXPECT_EQ(table.size(), count);
+    for (uint16_t i = 0; i < count; i++) {
+        EXPECT_EQ(table.find(makeEndpoint(1000 + i)), sessions[i]);
+    }
+}
+
+TEST(SessionTable,
+     lookups_run_during_inserts_and_removals)
+{
+    constexpr uint16_t stableCount = 32;
+    constexpr uint16_t churnCount = 512;
+
+    SessionTable table;
+    std::vector<std::shared_ptr<Session>> stable;
+    std::atomic<bool> isDone = false;
+    std::atomic<uint64_t> misses = 0;
+
+    for (uint16_t i = 0; i < stableCount; i++) {
+        stable.push_back(table.insert(makeEndpoint(1000 + i), makeSession(1000 + i)));
+    }
+
+    // The I/O thread: sessions that never leave are always found, whatever happens around them.
+    std::thread reader([&]() {
+        while (!isDone) {
+            for (uint16_t i = 0; i < stableCount; i++) {
+                if (table.find(makeEndpoint(1000 + i)) != stable[i]) {
+                    misses++;
+                }
+            }
+            if (table.find(makeEndpoint(4000)) != nullptr) {
+                misses++;
+            }
+        }
+    });
+
+    // The main thread: sessions come and go, and grow the table.
+    for (int round = 0; round < 20; round++) {
+        std::vector<std::shared_ptr<Session>> churn;
+
+        for (uint16_t i = 0; i < churnCount; i++) {
+            churn.push_back(table.insert(makeEndpoint(5000 + i), makeSession(5000 + i)));
+        }
+        for (uint16_t i = 0; i < churnCount; i++) {
+            ASSERT_TRUE(table.erase(makeEndpoint(5000 + i), churn[i]));
+        }
+        table.reclaim();
+    }
+
+    isDone = true;
+    reader.join();
+    EXPECT_EQ(misses, 0);
+    EXPECT_EQ(table.size(), stableCount);
+}
@@ -0,0 +1,180 @@
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <asio/io_context.hpp>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "rtnt/core/client.hpp"
+#include "rtnt/core/server.hpp"
+
+#if defined(__linux__)
+
+namespace {
+
+struct Example
+{
+    static constexpr rtnt::core::packet::Id kId = 1001;
+    static constexpr rtnt::core::packet::Name kName = "EXAMPLE";
+    static constexpr rtnt::core::packet::Flag kFlag = rtnt::core::packet::Flag::kReliable;
+
+    uint32_t x;
+
+    template <typename Archive>
+    void serialize(Archive& ar)
+    {
+        ar & x;
+    }
+};
+
+}  // namespace
+
+TEST(Sharding,
+     clients_are_served_by_every_shard)
+{
+    constexpr size_t shardCount = 4;
+    constexpr uint32_t clientCount = 16;
+
+    asio::io_context context;
+    auto workGuard = asio::make_work_guard(context);
+
+    rtnt::core::Server server(context, 4244);
+    std::vector<std::unique_ptr<rtnt::core::Client>> clients;
+    std::vector<uint32_t> echoes(clientCount, 0);
+    std::vector<uint32_t> broadcasts(clientCount, 0);
+
+    server.setShardCount(shardCount);
+    server.start();
+    EXPECT_EQ(server.getShardCount(), shardCount);
+
+    // Each message is sent back by the session (and thus the shard) that received it.
+    server.getPacketDispatcher().bind<Example>(
+        [&](const std::shared_ptr<rtnt::core::Session>& session, const Example& pkt) {
+            server.sendTo(session, pkt);
+        });
+
+    for (uint32_t i = 0; i < clientCount; i++) {
+        auto& client = clients.emplace_back(std::make_unique<rtnt::core::Client>(context));
+
+        client->getPacketDispatcher().bind<Example>(
+            [&echoes, &broadcasts, i](const auto&, const Example& pkt) {
+                (pkt.x == i ? echoes : broadcasts)[i]++;
+            });
+    }
+
+    std::thread ioThread([&context]() { context.run(); });
+
+    const auto waitFor = [&](auto condition) {
+        const auto start = std::chrono::steady_clock::now();
+
+        while (std::chrono::steady_clock::now() - start < std::chrono::seconds(2)) {
+            server.update();
+            for (const auto& client : clients) {
+                client->update();
+            }
+            if (condition()) {
+                return true;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+        return false;
+    };
+
+    for (const auto& client : clients) {
+        client->connect("127.0.0.1", 4244);
+    }
+    ASSERT_TRUE(waitFor([&]() {
+        return std::ranges::all_of(clients, [](const auto& c) { return c->isConnected(); });
+    })) << "Clients failed to connect.";
+
+    const uint64_t receivedBefore = server.getNetworkMetrics().totalPacketsReceived.load();
+
+    for (uint32_t i = 0; i < clientCount; i++) {
+        clients[i]->send(Example{.x = i});
+    }
+    EXPECT_TRUE(waitFor([&]() { return std::ranges::all_of(echoes, [](auto n) { return n; }); }))
+        << "Some clients did not get their message back.";
+
+    server.broadcast(Example{.x = clientCount});
+    EXPECT_TRUE(
+        waitFor([&]() { return std::ranges::all_of(broadcasts, [](auto n) { return n; }); }))
+        << "Some clients did not receive the broadcast.";
+
+    // The metrics of the shards add up in those of the server.
+    EXPECT_GE(server.getNetworkMetrics().totalPacketsReceived.load() - receivedBefore,
+              clientCount);
+
+    context.stop();
+    ioThread.join();
+}
+
+TEST(Sharding,
+     stops_while_receiving)
+{
+    constexpr size_t shardCount = 4;
+    constexpr uint32_t clientCount = 8;
+
+    asio::io_context context;
+    auto workGuard = asio::make_work_guard(context);
+
+    rtnt::core::Server server(context, 4244);
+    std::vector<std::unique_ptr<rtnt::core::Client>> clients;
+
+    // Falls back to the batched backend on kernels without io_uring.
+    server.setIoBackend(rtnt::core::Peer::IoBackend::kIoUring);
+    server.setShardCount(shardCount);
+    server.start();
+
+    for (uint32_t i = 0; i < clientCount; i++) {
+        clients.emplace_back(std::make_unique<rtnt::core::Client>(context));
+    }
+
+    std::thread ioThread([&context]() { context.run(); });
+
+    for (const auto& client : clients) {
+        client->connect("127.0.0.1", 4244);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    const auto isConnected = [&]() {
+        return std::ranges::all_of(clients, [](const auto& c) { return c->isConnected(); });
+    };
+
+    while (!isConnected() && std::chrono::steady_clock::now() - start < std::chrono::seconds(2)) {
+        server.update();
+        for (const auto& client : clients) {
+            client->update();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_TRUE(isConnected()) << "Clients failed to connect.";
+
+    // The shards are stopped while their I/O threads are busy receiving.
+    std::atomic<bool> isSending = true;
+    std::thread sender([&]() {
+        for (uint32_t i = 0; isSending; i++) {
+            for (const auto& client : clients) {
+                client->send(Example{.x = i});
+                client->update();
+            }
+        }
+    });
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    server.stop();
+
+    const uint64_t received = server.getNetworkMetrics().totalPacketsReceived.load();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_EQ(server.getNetworkMetrics().totalPacketsReceived.load(), received)
+        << "A shard kept receiving after the server was stopped.";
+
+    isSending = false;
+    sender.join();
+    context.stop();
+    ioThread.join();
+}
+
+#endif
@@ -0,0 +1,94 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "rtnt/common/constants.hpp"
+#include "rtnt/core/timer_wheel.hpp"
+
+namespace {
+
+using rtnt::core::TimerWheel;
+using rtnt::core::TIMER_WHEEL_RESOLUTION;
+using rtnt::core::TIMER_WHEEL_SIZE;
+using namespace std::chrono;
+
+}  // namespace
+
+TEST(TimerWheel,
+     fires_expired_timers_only)
+{
+    const auto start = steady_clock::now();
+    TimerWheel<int> wheel(start);
+    std::vector<int> fired;
+    const auto collect = [&](const int key) { fired.push_back(key); };
+
+    wheel.schedule(start + milliseconds(10), 1);
+    wheel.schedule(start + milliseconds(50), 2);
+    wheel.schedule(start + milliseconds(11), 3);
+    EXPECT_EQ(wheel.size(), 3);
+    EXPECT_EQ(wheel.getNextExpiry(), start + TIMER_WHEEL_RESOLUTION * 3);
+
+    wheel.advance(start + milliseconds(9), collect);
+    EXPECT_TRUE(fired.empty()) << "Timers must never fire early.";
+
+    wheel.advance(start + milliseconds(20), collect);
+    std::ranges::sort(fired);
+    EXPECT_EQ(fired, (std::vector<int>{1, 3}));
+    EXPECT_EQ(wheel.size(), 1);
+
+    // A deadline already passed fires on the next tick.
+    wheel.schedule(start, 4);
+    fired.clear();
+    wheel.advance(start + milliseconds(20), collect);
+    EXPECT_TRUE(fired.empty());
+    wheel.advance(start + milliseconds(20) + TIMER_WHEEL_RESOLUTION, collect);
+    EXPECT_EQ(fired, (std::vector<int>{4}));
+
+    fired.clear();
+    wheel.advance(start + milliseconds(60), collect);
+    EXPECT_EQ(fired, (std::vector<int>{2}));
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_EQ(wheel.getNextExpiry(), std::nullopt);
+}
+
+TEST(TimerWheel,
+     keeps_timers_of_later_revolutions)
+{
+    const auto start = steady_clock::now();
+    const auto revolution = TIMER_WHEEL_RESOLUTION * TIMER_WHEEL_SIZE;
+    TimerWheel<int> wheel(start);
+    std::vector<int> fired;
+    const auto collect = [&](const int key) { fired.push_back(key); };
+
+    // Both share a slot, one revolution apart.
+    wheel.schedule(start + TIMER_WHEEL_RESOLUTION * 5, 1);
+    wheel.schedule(start + TIMER_WHEEL_RESOLUTION * 5 + revolution * 3, 2);
+
+    wheel.advance(start + TIMER_WHEEL_RESOLUTION * 5, collect);
+    EXPECT_EQ(fired, (std::vector<int>{1}));
+
+    wheel.advance(start + revolution * 2, collect);
+    EXPECT_EQ(fired.size(), 1);
+
+    // A long pause visits every slot once.
+    wheel.advance(start + revolution * 10, collect);
+    EXPECT_EQ(fired, (std::vector<int>{1, 2}));
+}
+
+TEST(TimerWheel,
+     expired_timer_can_reschedule)
+{
+    const auto start = steady_clock::now();
+    TimerWheel<int> wheel(start);
+    int fireCount = 0;
+
+    wheel.schedule(start + TIMER_WHEEL_RESOLUTION, 1);
+    for (int i = 1; i <= 5; i++) {
+        wheel.advance(start + TIMER_WHEEL_RESOLUTION * i, [&](const int key) {
+            fireCount++;
+            wheel.schedule(start + TIMER_WHEEL_RESOLUTION * (i + 1), key);
+        });
+    }
+    EXPECT_EQ(fireCount, 5);
+    EXPECT_EQ(wheel.size(), 1);
+}